@@ -9,6 +9,9 @@
 
 #include <src/logger.h>
 #include <src/locations.h>
+#include <src/options.h>
+#include <src/telemetry.h>
+#include <src/config.h>
 
 Launcher::Launcher(const QApplication& t_application)
 {
@@ -21,12 +24,16 @@ void Launcher::start()
 
     m_worker = std::make_shared<LauncherWorker>();
 
-    m_mainWindow = std::make_unique<MainWindow>(m_worker, nullptr);
-
     connect(m_worker.get(), &QThread::finished, this, &Launcher::finish);
 
-    logInfo("Showing main window.");
-    m_mainWindow->show();
+    // Prefetch helper works in the background without any window.
+    if (!Options::getInstance().isPrefetchHelper())
+    {
+        m_mainWindow = std::make_unique<MainWindow>(m_worker, nullptr);
+
+        logInfo("Showing main window.");
+        m_mainWindow->show();
+    }
 
     logInfo("Starting launcher worker.");
     m_worker->start();
@@ -38,6 +45,13 @@ void Launcher::finish()
 
     logInfo("Launcher worker has finished. Checking result.");
 
+    if (Options::getInstance().isPrefetchHelper())
+    {
+        logInfo("Prefetch helper has finished. Closing launcher application.");
+
+        QApplication::quit();
+        return;
+    }
 
     if (m_worker->result() == LauncherWorker::CANCELLED ||
         m_worker->result() == LauncherWorker::SUCCESS)
@@ -76,13 +90,20 @@ void Launcher::cleanup()
     {
         if (m_worker->isRunning())
         {
-            logWarning("Application is about to be closed but launcher thread is still working - cancelling thread and waiting 2s for result.");
+            logWarning("Application is about to be closed but launcher thread is still working - cancelling thread and waiting for result.");
             m_worker->cancel();
+
+            // Cancellation interrupts network transfers, hashing and extraction, terminating the thread is only the last resort.
             if (!m_worker->wait(2000))
             {
-                logWarning("Launcher thread couldn't be cancelled - terminating thread.");
-                m_worker->terminate();
-                m_worker->wait();
+                logWarning("Launcher thread is taking long to cancel - still waiting.");
+
+                if (!m_worker->wait(Config::workerCancellationTimeoutMsec))
+                {
+                    logWarning("Launcher thread couldn't be cancelled - terminating thread.");
+                    m_worker->terminate();
+                    m_worker->wait();
+                }
             }
         }
 
@@ -90,5 +111,26 @@ void Launcher::cleanup()
         {
             logCritical("An error has occured!");
         }
+
+        Telemetry::getInstance().setValue("result", resultName(m_worker->result()));
+    }
+
+    Telemetry::getInstance().writeReport(Locations::getInstance().telemetryReportFilePath());
+}
+
+QString Launcher::resultName(LauncherWorker::Result t_result)
+{
+    switch (t_result)
+    {
+    case LauncherWorker::CANCELLED:
+        return "cancelled";
+    case LauncherWorker::SUCCESS:
+        return "success";
+    case LauncherWorker::FAILED:
+        return "failed";
+    case LauncherWorker::FATAL_ERROR:
+        return "fatal_error";
+    default:
+        return "none";
     }
 }
@@ -24,6 +24,8 @@ private slots:
     void cleanup();
 
 private:
+    static QString resultName(LauncherWorker::Result t_result);
+
     std::unique_ptr<MainWindow> m_mainWindow;
     std::shared_ptr<LauncherWorker> m_worker;
 };
@@ -23,5 +23,9 @@ int main(int argc, char* argv[])
     launcher.start();
 
     logInfo("Starting application loop.");
-    return application.exec();
+    int result = application.exec();
+
+    Logger::shutdown();
+
+    return result;
 }
@@ -0,0 +1,22 @@
+QT += core network
+include(../default.pri)
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+TARGET = LauncherBench
+TEMPLATE = app
+
+CONFIG += console
+
+TESTS_DIR = $$PWD/../patchkit-launcher-qt-tests/src
+
+INCLUDEPATH += $$PWD/src
+INCLUDEPATH += $$TESTS_DIR
+
+SOURCES     += $$PWD/src/*.cpp
+HEADERS     += $$PWD/src/*.h
+
+# Network mocks and the local HTTP server are shared with the tests.
+SOURCES     += $$TESTS_DIR/mockednam.cpp $$TESTS_DIR/mockedreply.cpp $$TESTS_DIR/testhttpserver.cpp
+HEADERS     += $$TESTS_DIR/mockednam.h $$TESTS_DIR/mockedreply.h $$TESTS_DIR/testhttpserver.h
+
+include(../link_static.pri)
@@ -0,0 +1,132 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "benchmarkrunner.h"
+
+#include <algorithm>
+
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+static QString readValue(const QStringList& t_arguments, const QString& t_option)
+{
+    QString prefix = t_option + "=";
+
+    for (const QString& argument : t_arguments)
+    {
+        if (argument.startsWith(prefix))
+        {
+            return argument.mid(prefix.size());
+        }
+    }
+
+    return QString();
+}
+
+BenchmarkRunner::BenchmarkRunner(const QStringList& t_arguments)
+    : m_filter(readValue(t_arguments, "--filter"))
+    , m_maxSize(256 * 1024 * 1024)
+    , m_iterations(5)
+    , m_output(stdout)
+{
+    bool ok;
+
+    qint64 maxSize = readValue(t_arguments, "--max-size").toLongLong(&ok);
+
+    if (ok && maxSize > 0)
+    {
+        m_maxSize = maxSize;
+    }
+
+    int iterations = readValue(t_arguments, "--iterations").toInt(&ok);
+
+    if (ok && iterations > 0)
+    {
+        m_iterations = iterations;
+    }
+}
+
+bool BenchmarkRunner::isSelected(const QString& t_name) const
+{
+    return t_name.contains(m_filter);
+}
+
+bool BenchmarkRunner::isAnySelected(const QStringList& t_names) const
+{
+    for (const QString& name : t_names)
+    {
+        if (isSelected(name))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+QVector<qint64> BenchmarkRunner::sizes(qint64 t_limit) const
+{
+    qint64 maxSize = t_limit > 0 ? qMin(t_limit, m_maxSize) : m_maxSize;
+
+    QVector<qint64> sizes;
+
+    for (qint64 size = 64 * 1024; size <= maxSize; size *= 16)
+    {
+        sizes.append(size);
+    }
+
+    return sizes;
+}
+
+void BenchmarkRunner::measure(const QString& t_name, qint64 t_size,
+                              std::function<void()> t_case,
+                              std::function<void()> t_setup)
+{
+    if (!isSelected(t_name))
+    {
+        return;
+    }
+
+    QVector<qint64> samples;
+    QElapsedTimer timer;
+
+    for (int i = 0; i <= m_iterations; i++)
+    {
+        if (t_setup)
+        {
+            t_setup();
+        }
+
+        timer.start();
+        t_case();
+        qint64 elapsed = timer.nsecsElapsed();
+
+        // First run only warms up the caches.
+        if (i > 0)
+        {
+            samples.append(elapsed);
+        }
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    double minMsec = samples.first() / 1e6;
+    double medianMsec = samples.at(samples.size() / 2) / 1e6;
+
+    QJsonObject result;
+    result["benchmark"] = t_name;
+    result["size"] = double(t_size);
+    result["iterations"] = m_iterations;
+    result["min_msec"] = minMsec;
+    result["median_msec"] = medianMsec;
+
+    if (t_size > 0 && medianMsec > 0)
+    {
+        result["mb_per_sec"] = (t_size / (1024.0 * 1024.0)) / (medianMsec / 1000.0);
+    }
+
+    m_output << QJsonDocument(result).toJson(QJsonDocument::Compact) << endl;
+}
@@ -0,0 +1,62 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#ifndef BENCHMARKRUNNER_H
+#define BENCHMARKRUNNER_H
+
+#include <functional>
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QTextStream>
+
+/**
+ * @brief
+ * Measures benchmark cases and prints the results as JSON lines.
+ *
+ * @details
+ * Every measured case prints one line to stdout:
+ * {"benchmark":"chunk_hashing","size":1048576,"iterations":5,"min_msec":0.2,"median_msec":0.21,"mb_per_sec":4761.9}
+ *
+ * Options:
+ * --filter=<text> - runs only the benchmarks whose name contains the text.
+ * --max-size=<bytes> - largest synthetic data size (256 MB by default). Sizes grow from 64 KB by a factor of 16.
+ * --iterations=<count> - number of measured iterations of every case (5 by default).
+ */
+class BenchmarkRunner
+{
+public:
+    BenchmarkRunner(const QStringList& t_arguments);
+
+    bool isSelected(const QString& t_name) const;
+    bool isAnySelected(const QStringList& t_names) const;
+
+    /**
+     * @brief sizes
+     *
+     * @return
+     * Synthetic data sizes up to the maximum size and t_limit.
+     */
+    QVector<qint64> sizes(qint64 t_limit = -1) const;
+
+    /**
+     * @brief measure
+     *
+     * Runs t_setup and t_case once for warm up and then for every iteration. Only t_case is timed.
+     * t_size is the number of bytes processed by a single run, used to compute throughput (0 skips it).
+     */
+    void measure(const QString& t_name, qint64 t_size,
+                 std::function<void()> t_case,
+                 std::function<void()> t_setup = std::function<void()>());
+
+private:
+    QString m_filter;
+    qint64 m_maxSize;
+    int m_iterations;
+    QTextStream m_output;
+};
+
+#endif // BENCHMARKRUNNER_H
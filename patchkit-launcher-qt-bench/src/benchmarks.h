@@ -0,0 +1,16 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+class BenchmarkRunner;
+
+void runDownloadBenchmarks(BenchmarkRunner& t_runner);
+void runHashingBenchmarks(BenchmarkRunner& t_runner);
+void runContentSummaryBenchmarks(BenchmarkRunner& t_runner);
+void runInstallBenchmarks(BenchmarkRunner& t_runner);
+
+#endif // BENCHMARKS_H
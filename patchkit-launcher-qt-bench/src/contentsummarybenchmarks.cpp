@@ -0,0 +1,58 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "benchmarks.h"
+
+#include <QJsonDocument>
+
+#include "benchmarkrunner.h"
+#include "syntheticdata.h"
+
+#include "src/contentsummary.h"
+
+void runContentSummaryBenchmarks(BenchmarkRunner& t_runner)
+{
+    if (!t_runner.isAnySelected({"content_summary_parse", "content_summary_parse_qjson", "content_summary_load_binary"}))
+    {
+        return;
+    }
+
+    for (int chunksCount : {1000, 100000, 1000000})
+    {
+        QByteArray json = SyntheticData::contentSummaryJson(chunksCount, chunksCount / 100 + 1);
+
+        t_runner.measure("content_summary_parse", json.size(), [&]()
+        {
+            ContentSummary summary = ContentSummary::fromJson(json);
+
+            if (!summary.isValid() || summary.getChunksCount() != chunksCount)
+            {
+                throw std::runtime_error("Couldn't parse content summary.");
+            }
+        });
+
+        t_runner.measure("content_summary_parse_qjson", json.size(), [&]()
+        {
+            ContentSummary summary(QJsonDocument::fromJson(json));
+
+            if (!summary.isValid() || summary.getChunksCount() != chunksCount)
+            {
+                throw std::runtime_error("Couldn't parse content summary.");
+            }
+        });
+
+        QByteArray binary = ContentSummary::fromJson(json).toBinary();
+
+        t_runner.measure("content_summary_load_binary", binary.size(), [&]()
+        {
+            ContentSummary summary = ContentSummary::fromBinary(binary);
+
+            if (!summary.isValid() || summary.getChunksCount() != chunksCount)
+            {
+                throw std::runtime_error("Couldn't load content summary.");
+            }
+        });
+    }
+}
@@ -0,0 +1,369 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "benchmarks.h"
+
+#include <QTemporaryFile>
+#include <QTimer>
+
+#include "benchmarkrunner.h"
+#include "syntheticdata.h"
+#include "mockednam.h"
+#include "testhttpserver.h"
+
+#include "src/chunkeddownloader.h"
+#include "src/cancellationtokensource.h"
+#include "src/byteranges.h"
+#include "src/config.h"
+
+// Downloader keeps the whole file in memory, several copies of it at once.
+static const qint64 inMemoryDownloadLimit = 512 * 1024 * 1024;
+
+// Downloads to a file are limited only by the disk space.
+static const qint64 fileDownloadLimit = Q_INT64_C(8) * 1024 * 1024 * 1024;
+
+/**
+ * @brief
+ * Reply with content which repeats a pattern, so it can be larger than the available memory.
+ * Like a socket, it has at most a read buffer of data available at once.
+ */
+class PatternNetworkReply : public QNetworkReply
+{
+public:
+    PatternNetworkReply(const QNetworkRequest& t_request, const QByteArray& t_pattern, qint64 t_size)
+        : m_pattern(t_pattern)
+        , m_offset(0)
+        , m_end(t_size)
+    {
+        setRequest(t_request);
+        setUrl(t_request.url());
+
+        int statusCode = 200;
+        QVector<ByteRanges::TRange> ranges;
+
+        // Only the first range is served, just like some servers do.
+        if (t_request.hasRawHeader("Range") && ByteRanges::parseRangeHeader(t_request.rawHeader("Range"), t_size, ranges))
+        {
+            m_offset = ranges.first().first;
+            m_end = qMin(ranges.first().second, t_size - 1) + 1;
+
+            setRawHeader("Content-Range", "bytes " + QByteArray::number(m_offset) + "-" + QByteArray::number(m_end - 1)
+                         + "/" + QByteArray::number(t_size));
+
+            statusCode = 206;
+        }
+
+        setHeader(QNetworkRequest::ContentLengthHeader, QVariant(m_end - m_offset));
+
+        open(ReadOnly | Unbuffered);
+
+        QTimer::singleShot(0, this, [this, statusCode]()
+        {
+            setFinished(true);
+            setAttribute(QNetworkRequest::HttpStatusCodeAttribute, QVariant::fromValue(statusCode));
+            emit readyRead();
+            emit finished();
+        });
+    }
+
+    void abort() override
+    {
+    }
+
+    qint64 bytesAvailable() const override
+    {
+        return qMin(m_end - m_offset, Config::downloadReadBufferSize);
+    }
+
+    bool isSequential() const override
+    {
+        return true;
+    }
+
+protected:
+    qint64 readData(char* t_data, qint64 t_maxSize) override
+    {
+        if (m_offset >= m_end)
+        {
+            return -1;
+        }
+
+        qint64 readSize = qMin(t_maxSize, bytesAvailable());
+
+        for (qint64 position = 0; position < readSize;)
+        {
+            qint64 patternOffset = (m_offset + position) % m_pattern.size();
+            qint64 copySize = qMin(readSize - position, m_pattern.size() - patternOffset);
+
+            memcpy(t_data + position, m_pattern.constData() + patternOffset, size_t(copySize));
+            position += copySize;
+        }
+
+        m_offset += readSize;
+
+        return readSize;
+    }
+
+private:
+    QByteArray m_pattern;
+    qint64 m_offset;
+    qint64 m_end;
+};
+
+class PatternNAM : public QNetworkAccessManager
+{
+public:
+    PatternNAM(const QByteArray& t_pattern, qint64 t_size)
+        : m_pattern(t_pattern)
+        , m_size(t_size)
+    {
+    }
+
+protected:
+    QNetworkReply* createRequest(Operation, const QNetworkRequest& t_request, QIODevice*) override
+    {
+        return new PatternNetworkReply(t_request, m_pattern, m_size);
+    }
+
+private:
+    QByteArray m_pattern;
+    qint64 m_size;
+};
+
+// Summary of the data served by PatternNAM, a pattern of one chunk repeated up to t_size.
+static ContentSummary summarizePattern(const QByteArray& t_pattern, qint64 t_size)
+{
+    const int chunkSize = t_pattern.size();
+
+    THash patternHash = HashingStrategy::xxHash(t_pattern);
+    QVector<THash> chunkHashes(int(t_size / chunkSize), patternHash);
+
+    if (t_size % chunkSize != 0)
+    {
+        chunkHashes.append(HashingStrategy::xxHash(t_pattern.left(int(t_size % chunkSize))));
+    }
+
+    return ContentSummary(chunkSize, patternHash, "none", "none", "xxHash", chunkHashes, {});
+}
+
+// Shaped transfers take seconds per iteration above this size.
+static const qint64 shapedDownloadLimit = 64 * 1024 * 1024;
+
+static void runMockedDownloadBenchmarks(BenchmarkRunner& t_runner, CancellationToken& t_token)
+{
+    for (qint64 size : t_runner.sizes(inMemoryDownloadLimit))
+    {
+        QByteArray data = SyntheticData::generate(size);
+        ContentSummary summary = SyntheticData::summarize(data);
+
+        MockedNAM nam;
+        nam.push("bench", data, 0);
+
+        t_runner.measure("chunked_download", size, [&]()
+        {
+            ChunkedDownloader downloader(&nam, summary, &HashingStrategy::xxHashStream, t_token);
+
+            if (downloader.downloadFile("bench", Config::maxConnectionTimeoutMsec).size() != data.size())
+            {
+                throw std::runtime_error("Chunked download returned wrong amount of data.");
+            }
+        });
+
+        t_runner.measure("direct_download", size, [&]()
+        {
+            Downloader downloader(&nam, t_token);
+
+            if (downloader.downloadFile("bench", Config::maxConnectionTimeoutMsec).size() != data.size())
+            {
+                throw std::runtime_error("Download returned wrong amount of data.");
+            }
+        });
+    }
+}
+
+static void runFileDownloadBenchmarks(BenchmarkRunner& t_runner, CancellationToken& t_token)
+{
+    QByteArray pattern = SyntheticData::generate(SyntheticData::chunkSize);
+
+    QTemporaryFile file;
+
+    if (!file.open())
+    {
+        throw std::runtime_error("Couldn't create temporary file.");
+    }
+
+    for (qint64 size : t_runner.sizes(fileDownloadLimit))
+    {
+        ContentSummary summary = summarizePattern(pattern, size);
+        PatternNAM nam(pattern, size);
+
+        t_runner.measure("chunked_download_to_file", size, [&]()
+        {
+            ChunkedDownloader downloader(&nam, summary, &HashingStrategy::xxHashStream, t_token);
+
+            downloader.downloadFile("bench", file, Config::maxConnectionTimeoutMsec);
+
+            if (file.size() != size)
+            {
+                throw std::runtime_error("Chunked download wrote wrong amount of data.");
+            }
+        },
+        [&]()
+        {
+            file.resize(0);
+            file.seek(0);
+        });
+    }
+}
+
+static void measureLoopbackDownload(BenchmarkRunner& t_runner, const QString& t_name, qint64 t_size,
+                                    const TestHttpServer::Profile& t_profile, CancellationToken& t_token)
+{
+    if (!t_runner.isSelected(t_name))
+    {
+        return;
+    }
+
+    QByteArray data = SyntheticData::generate(t_size);
+    ContentSummary summary = SyntheticData::summarize(data);
+
+    TestHttpServer server;
+
+    if (!server.start())
+    {
+        throw std::runtime_error("Couldn't start local HTTP server.");
+    }
+
+    QNetworkAccessManager nam;
+
+    t_runner.measure(t_name, t_size, [&]()
+    {
+        ChunkedDownloader downloader(&nam, summary, &HashingStrategy::xxHashStream, t_token);
+
+        if (downloader.downloadFile(server.url("/bench"), Config::maxConnectionTimeoutMsec) != data)
+        {
+            throw std::runtime_error("Chunked download returned wrong data.");
+        }
+    },
+    [&]()
+    {
+        // Resets the count of faulty requests.
+        server.setContent("/bench", data, t_profile);
+    });
+}
+
+static void runLoopbackDownloadBenchmarks(BenchmarkRunner& t_runner, CancellationToken& t_token)
+{
+    for (qint64 size : t_runner.sizes(inMemoryDownloadLimit))
+    {
+        measureLoopbackDownload(t_runner, "loopback_chunked_download", size, TestHttpServer::Profile(), t_token);
+
+        // First transfer is cut in the middle and has a corrupted byte before the cut.
+        TestHttpServer::Profile faultyProfile;
+        faultyProfile.truncateAtByte = size / 2 + 100;
+        faultyProfile.corruptAtByte = size / 4;
+        faultyProfile.faultyRequestsCount = 1;
+
+        measureLoopbackDownload(t_runner, "loopback_chunked_download_faulty", size, faultyProfile, t_token);
+    }
+
+    for (qint64 size : t_runner.sizes(shapedDownloadLimit))
+    {
+        TestHttpServer::Profile shapedProfile;
+        shapedProfile.bytesPerSecond = 100 * 1024 * 1024;
+        shapedProfile.slowStartMsec = 200;
+        shapedProfile.latencyMsec = 20;
+
+        measureLoopbackDownload(t_runner, "loopback_chunked_download_shaped", size, shapedProfile, t_token);
+    }
+}
+
+static void measureParallelRanges(BenchmarkRunner& t_runner, const QString& t_name, qint64 t_size)
+{
+    if (!t_runner.isSelected(t_name))
+    {
+        return;
+    }
+
+    const int rangesCount = 16;
+
+    QByteArray data = SyntheticData::generate(t_size);
+
+    TestHttpServer::Profile profile;
+    profile.latencyMsec = 20;
+
+    TestHttpServer server;
+
+    if (!server.start())
+    {
+        throw std::runtime_error("Couldn't start local HTTP server.");
+    }
+
+    server.setContent("/bench", data, profile);
+
+    QNetworkAccessManager nam;
+
+    t_runner.measure(t_name, t_size, [&]()
+    {
+        QList<QNetworkReply*> replies;
+        qint64 rangeSize = (t_size + rangesCount - 1) / rangesCount;
+
+        for (qint64 offset = 0; offset < t_size; offset += rangeSize)
+        {
+            QNetworkRequest request(QUrl(server.url("/bench")));
+            request.setRawHeader("Range", "bytes=" + QByteArray::number(offset) + "-"
+                                 + QByteArray::number(qMin(offset + rangeSize, t_size) - 1));
+
+            replies.append(nam.get(request));
+        }
+
+        qint64 bytesCount = 0;
+
+        for (QNetworkReply* reply : replies)
+        {
+            if (!reply->isFinished())
+            {
+                QEventLoop finishedLoop;
+                QObject::connect(reply, &QNetworkReply::finished, &finishedLoop, &QEventLoop::quit);
+                finishedLoop.exec();
+            }
+
+            bytesCount += reply->readAll().size();
+            reply->deleteLater();
+        }
+
+        if (bytesCount != t_size)
+        {
+            throw std::runtime_error("Range requests returned wrong amount of data.");
+        }
+    });
+}
+
+void runDownloadBenchmarks(BenchmarkRunner& t_runner)
+{
+    std::shared_ptr<CancellationTokenSource> tokenSource(new CancellationTokenSource());
+    CancellationToken token(tokenSource);
+
+    if (t_runner.isAnySelected({"chunked_download", "direct_download"}))
+    {
+        runMockedDownloadBenchmarks(t_runner, token);
+    }
+
+    if (t_runner.isSelected("chunked_download_to_file"))
+    {
+        runFileDownloadBenchmarks(t_runner, token);
+    }
+
+    if (t_runner.isAnySelected({"loopback_chunked_download", "loopback_chunked_download_faulty",
+                                "loopback_chunked_download_shaped"}))
+    {
+        runLoopbackDownloadBenchmarks(t_runner, token);
+    }
+
+    for (qint64 size : t_runner.sizes(shapedDownloadLimit))
+    {
+        measureParallelRanges(t_runner, "loopback_parallel_ranges", size);
+    }
+}
@@ -0,0 +1,39 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "benchmarks.h"
+
+#include "benchmarkrunner.h"
+#include "syntheticdata.h"
+
+#include "src/hashingstrategy.h"
+
+void runHashingBenchmarks(BenchmarkRunner& t_runner)
+{
+    if (!t_runner.isSelected("chunk_hashing"))
+    {
+        return;
+    }
+
+    for (qint64 size : t_runner.sizes())
+    {
+        // Large sizes hash the same buffer over and over, so they don't need the memory.
+        const qint64 bufferSize = qMin<qint64>(size, 64 * 1024 * 1024);
+        QByteArray buffer = SyntheticData::generate(bufferSize);
+
+        volatile THash result = 0;
+
+        t_runner.measure("chunk_hashing", size, [&]()
+        {
+            for (qint64 offset = 0; offset < size; offset += SyntheticData::chunkSize)
+            {
+                qint64 bufferOffset = offset % bufferSize;
+                int chunkSize = int(qMin<qint64>(SyntheticData::chunkSize, bufferSize - bufferOffset));
+
+                result = result ^ HashingStrategy::xxHash(QByteArray::fromRawData(buffer.constData() + bufferOffset, chunkSize));
+            }
+        });
+    }
+}
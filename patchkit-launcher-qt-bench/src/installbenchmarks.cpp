@@ -0,0 +1,108 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "benchmarks.h"
+
+#include <QTemporaryDir>
+#include <QDir>
+#include <QFileInfo>
+
+#include "benchmarkrunner.h"
+#include "syntheticdata.h"
+
+#include "src/ioutils.h"
+#include "src/cancellationtokensource.h"
+#include "src/locations.h"
+#include "src/localpatcherdata.h"
+
+static const qint64 zipSizeLimit = Q_INT64_C(8) * 1024 * 1024 * 1024;
+
+static void runZipExtractionBenchmarks(BenchmarkRunner& t_runner)
+{
+    QTemporaryDir tempDir;
+
+    if (!tempDir.isValid())
+    {
+        throw std::runtime_error("Couldn't create temporary directory.");
+    }
+
+    std::shared_ptr<CancellationTokenSource> tokenSource(new CancellationTokenSource());
+
+    QString zipPath = tempDir.path() + "/patcher.zip";
+    QString extractPath = tempDir.path() + "/extracted";
+
+    for (qint64 size : t_runner.sizes(zipSizeLimit))
+    {
+        SyntheticData::writeZip(zipPath, size, 16);
+
+        t_runner.measure("zip_extraction", size, [&]()
+        {
+            QStringList extractedEntries;
+            IOUtils::extractZip(zipPath, extractPath, extractedEntries, tokenSource);
+        },
+        [&]()
+        {
+            QDir(extractPath).removeRecursively();
+        });
+    }
+
+    QDir(extractPath).removeRecursively();
+}
+
+static void runIsInstalledBenchmarks(BenchmarkRunner& t_runner)
+{
+    QString patcherDirectoryPath = Locations::getInstance().patcherDirectoryPath();
+
+    // Never touch a real installation.
+    if (QDir(patcherDirectoryPath).exists())
+    {
+        return;
+    }
+
+    for (int entriesCount : {100, 10000})
+    {
+        QStringList entries;
+
+        for (int i = 0; i < entriesCount; i++)
+        {
+            QString entry = QString("data/%1/file%2.bin").arg(QString::number(i % 8), QString::number(i));
+
+            QFileInfo entryInfo(QDir::cleanPath(patcherDirectoryPath + "/" + entry));
+
+            IOUtils::createDir(entryInfo.absolutePath());
+            IOUtils::writeDataToFile(entryInfo.absoluteFilePath(), QByteArray());
+            entries.append(entry);
+        }
+
+        IOUtils::writeTextToFile(Locations::getInstance().patcherInstallationInfoFilePath(), entries.join('\n'));
+        IOUtils::writeTextToFile(Locations::getInstance().patcherVersionInfoFilePath(), "1");
+        IOUtils::writeTextToFile(Locations::getInstance().patcherIdInfoFilePath(), "bench");
+
+        LocalPatcherData localPatcher;
+
+        t_runner.measure("is_installed", 0, [&]()
+        {
+            if (!localPatcher.isInstalled())
+            {
+                throw std::runtime_error("Benchmark installation wasn't found.");
+            }
+        });
+
+        QDir(patcherDirectoryPath).removeRecursively();
+    }
+}
+
+void runInstallBenchmarks(BenchmarkRunner& t_runner)
+{
+    if (t_runner.isSelected("zip_extraction"))
+    {
+        runZipExtractionBenchmarks(t_runner);
+    }
+
+    if (t_runner.isSelected("is_installed"))
+    {
+        runIsInstalledBenchmarks(t_runner);
+    }
+}
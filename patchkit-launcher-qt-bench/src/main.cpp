@@ -0,0 +1,58 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include <QCoreApplication>
+#include <QThread>
+
+#include <iostream>
+
+#include "benchmarkrunner.h"
+#include "benchmarks.h"
+
+#include "src/logger.h"
+
+class BenchmarkThread : public QThread
+{
+public:
+    int exitCode = 0;
+
+private:
+    void run() override
+    {
+        // Benchmarks measure the code, not the logging.
+        Logger::setMinimumLevel(QtWarningMsg);
+
+        try
+        {
+            BenchmarkRunner runner(QCoreApplication::arguments());
+
+            runHashingBenchmarks(runner);
+            runContentSummaryBenchmarks(runner);
+            runDownloadBenchmarks(runner);
+            runInstallBenchmarks(runner);
+        }
+        catch (std::exception& exception)
+        {
+            std::cerr << "Benchmark failed - " << exception.what() << std::endl;
+            exitCode = 1;
+        }
+
+        QCoreApplication::quit();
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    BenchmarkThread benchmarkThread;
+    benchmarkThread.start();
+
+    app.exec();
+
+    benchmarkThread.wait();
+
+    return benchmarkThread.exitCode;
+}
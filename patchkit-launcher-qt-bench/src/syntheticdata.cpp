@@ -0,0 +1,125 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "syntheticdata.h"
+
+#include <limits>
+
+#include <quazip.h>
+#include <quazipfile.h>
+
+#include "src/hashingstrategy.h"
+
+QByteArray SyntheticData::generate(qint64 t_size, quint32 t_seed)
+{
+    if (t_size > std::numeric_limits<int>::max())
+    {
+        throw std::runtime_error("Synthetic data doesn't fit in QByteArray, generate it piece by piece.");
+    }
+
+    QByteArray data(int(t_size), Qt::Uninitialized);
+
+    // xorshift32 - fast and good enough to keep the data incompressible.
+    quint32 state = t_seed == 0 ? 1 : t_seed;
+
+    for (int i = 0; i < data.size(); i++)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+
+        data[i] = char(state);
+    }
+
+    return data;
+}
+
+ContentSummary SyntheticData::summarize(const QByteArray& t_data, int t_chunkSize)
+{
+    QVector<THash> chunkHashes;
+    chunkHashes.reserve(t_data.size() / t_chunkSize + 1);
+
+    for (int offset = 0; offset < t_data.size(); offset += t_chunkSize)
+    {
+        chunkHashes.append(HashingStrategy::xxHash(t_data.mid(offset, t_chunkSize)));
+    }
+
+    return ContentSummary(t_chunkSize, HashingStrategy::xxHash(t_data), "none", "none", "xxHash", chunkHashes, {});
+}
+
+QByteArray SyntheticData::contentSummaryJson(int t_chunksCount, int t_filesCount)
+{
+    QByteArray json;
+    json.reserve(t_chunksCount * 12 + t_filesCount * 64 + 256);
+
+    json += "{\"encryption_method\":\"none\",\"compression_method\":\"zip\",\"hashing_method\":\"xxhash\",";
+    json += "\"hash_code\":\"" + QByteArray::number(t_chunksCount, 16) + "\",\"files\":[";
+
+    for (int i = 0; i < t_filesCount; i++)
+    {
+        if (i > 0)
+        {
+            json += ",";
+        }
+
+        json += "{\"path\":\"patcher/data/file" + QByteArray::number(i) + ".bin\",";
+        json += "\"hash\":\"" + QByteArray::number(quint32(i) * 2654435761u, 16) + "\"}";
+    }
+
+    json += "],\"chunks\":{\"size\":" + QByteArray::number(chunkSize) + ",\"hashes\":[";
+
+    for (int i = 0; i < t_chunksCount; i++)
+    {
+        if (i > 0)
+        {
+            json += ",";
+        }
+
+        json += "\"" + QByteArray::number(quint32(i) * 2246822519u, 16) + "\"";
+    }
+
+    json += "]}}";
+
+    return json;
+}
+
+void SyntheticData::writeZip(const QString& t_zipPath, qint64 t_size, int t_filesCount)
+{
+    QuaZip zip(t_zipPath);
+
+    // Archives and entries above 4 GB need ZIP64.
+    zip.setZip64Enabled(true);
+
+    if (!zip.open(QuaZip::mdCreate))
+    {
+        throw std::runtime_error("Couldn't create zip file - " + t_zipPath.toStdString());
+    }
+
+    const qint64 pieceSize = qMin<qint64>(16 * 1024 * 1024, t_size);
+    QByteArray piece = generate(pieceSize);
+
+    qint64 fileSize = t_size / t_filesCount;
+
+    for (int i = 0; i < t_filesCount; i++)
+    {
+        QString fileName = QString("data/%1/file%2.bin").arg(QString::number(i % 8), QString::number(i));
+
+        QuaZipFile file(&zip);
+
+        if (!file.open(QIODevice::WriteOnly, QuaZipNewInfo(fileName)))
+        {
+            throw std::runtime_error("Couldn't add file to zip.");
+        }
+
+        for (qint64 written = 0; written < fileSize; written += pieceSize)
+        {
+            file.write(piece.constData(), qMin(pieceSize, fileSize - written));
+        }
+
+        file.close();
+    }
+
+    zip.close();
+}
@@ -0,0 +1,42 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#ifndef SYNTHETICDATA_H
+#define SYNTHETICDATA_H
+
+#include <QByteArray>
+#include <QString>
+
+#include "src/contentsummary.h"
+
+/**
+ * @brief
+ * Deterministic data used by the benchmarks, so results of different runs can be compared.
+ */
+namespace SyntheticData
+{
+    const int chunkSize = 1024 * 1024;
+
+    /**
+     * @brief generate
+     *
+     * Throws std::runtime_error when t_size doesn't fit in QByteArray.
+     */
+    QByteArray generate(qint64 t_size, quint32 t_seed = 1);
+
+    ContentSummary summarize(const QByteArray& t_data, int t_chunkSize = chunkSize);
+
+    QByteArray contentSummaryJson(int t_chunksCount, int t_filesCount);
+
+    /**
+     * @brief writeZip
+     *
+     * Writes a zip of t_filesCount files in nested directories with t_size bytes of data in total.
+     * Data is generated piece by piece, so the zip may be larger than the available memory.
+     */
+    void writeZip(const QString& t_zipPath, qint64 t_size, int t_filesCount);
+}
+
+#endif // SYNTHETICDATA_H
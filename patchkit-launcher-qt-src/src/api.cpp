@@ -7,54 +7,64 @@
 
 #include "downloader.h"
 #include "timeoutexception.h"
+#include "contentdecodingexception.h"
+#include "logger.h"
 #include "config.h"
+#include "timeoutestimator.h"
 
 #include "contentsummary.h"
 
-Api::Api(QObject* parent) : QObject(parent)
+Api::Api(QObject* parent)
+    : QObject(parent)
+    , m_networkAccessManager(nullptr)
 {
 }
 
-QString Api::downloadString(const QString& t_resourceUrl, CancellationToken t_cancellationToken) const
+void Api::setNetworkAccessManager(QNetworkAccessManager* t_networkAccessManager)
+{
+    m_networkAccessManager = t_networkAccessManager;
+}
+
+QByteArray Api::downloadBytes(const QString& t_resourceUrl, CancellationToken t_cancellationToken) const
 {
     QStringList cacheApiUrls = Config::cacheApiUrls;
-    return downloadString(t_resourceUrl, cacheApiUrls, false, t_cancellationToken);
+    return downloadBytes(t_resourceUrl, cacheApiUrls, nullptr, false, t_cancellationToken);
 }
 
-QJsonDocument Api::downloadContentSummary(const QString& t_resourceUrl, CancellationToken t_cancellationToken) const
+ContentSummary Api::downloadContentSummary(const QString& t_resourceUrl, CancellationToken t_cancellationToken) const
 {
-    const auto validator = [](const QString& data) -> bool
+    ContentSummary summary;
+
+    // Summary parsed by the validator is the one returned, so the body is parsed only once.
+    const auto validator = [&summary](const QByteArray& t_data) -> bool
     {
-        QJsonDocument doc = QJsonDocument::fromJson(data.toUtf8());
-        return !doc.isNull() && !doc.isEmpty();
+        summary = ContentSummary::fromJson(t_data);
+        return summary.isValid();
     };
 
     QStringList cacheApiUrls = Config::cacheApiUrls;
 
-    QString raw = downloadString(t_resourceUrl, cacheApiUrls, validator, false, t_cancellationToken);
-    return QJsonDocument::fromJson(raw.toUtf8());
-}
+    downloadBytes(t_resourceUrl, cacheApiUrls, validator, false, t_cancellationToken);
 
-QString Api::downloadString(const QString& t_resourceUrl, QStringList& t_cacheApiUrls, bool t_extendedTimeout, CancellationToken t_cancellationToken) const
-{
-    return downloadString(t_resourceUrl, t_cacheApiUrls, nullptr, t_extendedTimeout, t_cancellationToken);
+    return summary;
 }
 
-QString Api::downloadString(const QString& t_resourceUrl, QStringList& t_cacheApiUrls, TValidator t_validator, bool t_extendedTimeout, CancellationToken t_cancellationToken) const
+QByteArray Api::downloadBytes(const QString& t_resourceUrl, QStringList& t_cacheApiUrls, const TValidator& t_validator, bool t_extendedTimeout, CancellationToken t_cancellationToken) const
 {
-    QString result;
+    QByteArray result;
     int statusCode;
 
-    int timeout = t_extendedTimeout ? Config::maxConnectionTimeoutMsec : Config::minConnectionTimeoutMsec;
+    QString mainUrl = Config::mainApiUrl + "/" + t_resourceUrl;
+    int timeout = TimeoutEstimator::getInstance().getTimeout(mainUrl, t_extendedTimeout);
 
-    if (downloadStringFromServer(Config::mainApiUrl + "/" + t_resourceUrl, timeout, result, statusCode, t_cancellationToken))
+    if (downloadBytesFromServer(mainUrl, timeout, result, statusCode, t_cancellationToken))
     {
         if (!isVaild(statusCode))
         {
             throw std::runtime_error("API response error. Status code - " + std::to_string(statusCode));
         }
 
-        if (!t_validator || (t_validator && t_validator(result)))
+        if (!t_validator || t_validator(result))
             return result;
     }
     else
@@ -65,11 +75,14 @@ QString Api::downloadString(const QString& t_resourceUrl, QStringList& t_cacheAp
 
     for (int i = 0; i < t_cacheApiUrls.length(); i++)
     {
-        if (downloadStringFromServer(t_cacheApiUrls[i] + "/" + t_resourceUrl, timeout, result, statusCode, t_cancellationToken))
+        QString cacheUrl = t_cacheApiUrls[i] + "/" + t_resourceUrl;
+        timeout = TimeoutEstimator::getInstance().getTimeout(cacheUrl, t_extendedTimeout);
+
+        if (downloadBytesFromServer(cacheUrl, timeout, result, statusCode, t_cancellationToken))
         {
             if (isVaild(statusCode))
             {
-                if (!t_validator || (t_validator && t_validator(result)))
+                if (!t_validator || t_validator(result))
                     return result;
             }
 
@@ -87,7 +100,7 @@ QString Api::downloadString(const QString& t_resourceUrl, QStringList& t_cacheAp
         throw std::runtime_error("API connection error.");
     }
 
-    return downloadString(t_resourceUrl, t_cacheApiUrls, t_validator, true, t_cancellationToken);
+    return downloadBytes(t_resourceUrl, t_cacheApiUrls, t_validator, true, t_cancellationToken);
 }
 
 bool Api::isVaild(int t_statusCode) const
@@ -95,14 +108,15 @@ bool Api::isVaild(int t_statusCode) const
     return t_statusCode == 200;
 }
 
-bool Api::downloadStringFromServer(const QString& t_url, int t_timeout, QString& t_result, int& t_statusCode, CancellationToken t_cancellationToken) const
+bool Api::downloadBytesFromServer(const QString& t_url, int t_timeout, QByteArray& t_result, int& t_statusCode, CancellationToken t_cancellationToken) const
 {
-    QNetworkAccessManager remoteDataSource;
+    QNetworkAccessManager ownRemoteDataSource;
+    QNetworkAccessManager* remoteDataSource = m_networkAccessManager ? m_networkAccessManager : &ownRemoteDataSource;
 
     try
     {
-        Downloader downloader(&remoteDataSource, t_cancellationToken);
-        t_result = downloader.downloadString(t_url, t_timeout, t_statusCode);
+        Downloader downloader(remoteDataSource, t_cancellationToken);
+        t_result = downloader.downloadBytes(t_url, t_timeout, t_statusCode);
 
         if (t_statusCode == 500)
         {
@@ -115,4 +129,10 @@ bool Api::downloadStringFromServer(const QString& t_url, int t_timeout, QString&
     {
         return false;
     }
+    catch (ContentDecodingException& exception)
+    {
+        // Reply of a misbehaving server is treated like no reply, the next server is tried.
+        logWarning("Couldn't decode API reply from %1 - %2", .arg(t_url, QString(exception.what())));
+        return false;
+    }
 }
@@ -7,6 +7,10 @@
 
 #include <QObject>
 
+#include <functional>
+
+class QNetworkAccessManager;
+
 #include "cancellationtoken.h"
 
 #include "contentsummary.h"
@@ -15,24 +19,29 @@
 
 class Api : public QObject, public IApi
 {
-    typedef bool (*TValidator)(const QString&);
+    typedef std::function<bool(const QByteArray&)> TValidator;
 
     Q_OBJECT
 public:
     explicit Api(QObject* parent = nullptr);
 
-    QString downloadString(const QString& t_resourceUrl, CancellationToken t_cancellationToken) const override;
+    // Requests go through t_networkAccessManager, so that they reuse its (pre-warmed) connections.
+    // Without it, every request uses a network access manager of its own.
+    void setNetworkAccessManager(QNetworkAccessManager* t_networkAccessManager);
 
-    QJsonDocument downloadContentSummary(const QString& t_resourceUrl, CancellationToken t_cancellationToken) const override;
+    QByteArray downloadBytes(const QString& t_resourceUrl, CancellationToken t_cancellationToken) const override;
+
+    ContentSummary downloadContentSummary(const QString& t_resourceUrl, CancellationToken t_cancellationToken) const override;
 
 signals:
     void connectionIssue(bool isSerious) const;
 
 private:
-    QString downloadString(const QString& t_resourceUrl, QStringList& t_cacheApiUrls, bool t_extendedTimeout, CancellationToken t_cancellationToken) const;
-    QString downloadString(const QString& t_resourceUrl, QStringList& t_cacheApiUrls, TValidator t_validator, bool t_extendedTimeout, CancellationToken t_cancellationToken) const;
+    QByteArray downloadBytes(const QString& t_resourceUrl, QStringList& t_cacheApiUrls, const TValidator& t_validator, bool t_extendedTimeout, CancellationToken t_cancellationToken) const;
 
     bool isVaild(int t_statusCode) const;
 
-    bool downloadStringFromServer(const QString& t_url, int t_timeout, QString& t_result, int& t_statusCode, CancellationToken t_cancellationToken) const;
+    bool downloadBytesFromServer(const QString& t_url, int t_timeout, QByteArray& t_result, int& t_statusCode, CancellationToken t_cancellationToken) const;
+
+    QNetworkAccessManager* m_networkAccessManager;
 };
@@ -0,0 +1,153 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "byteranges.h"
+
+#include <QList>
+
+QByteArray ByteRanges::formatRangeHeader(const QVector<TRange>& t_ranges)
+{
+    QByteArray header = "bytes=";
+
+    for (int i = 0; i < t_ranges.size(); i++)
+    {
+        if (i > 0)
+        {
+            header += ",";
+        }
+
+        header += QByteArray::number(t_ranges[i].first) + "-";
+
+        if (t_ranges[i].second >= 0)
+        {
+            header += QByteArray::number(t_ranges[i].second);
+        }
+    }
+
+    return header;
+}
+
+bool ByteRanges::parseContentRange(const QByteArray& t_contentRange, qint64& t_first, qint64& t_last, qint64& t_totalSize)
+{
+    QByteArray value = t_contentRange.trimmed();
+
+    if (!value.toLower().startsWith("bytes "))
+    {
+        return false;
+    }
+
+    QList<QByteArray> rangeAndSize = value.mid(6).trimmed().split('/');
+
+    if (rangeAndSize.size() != 2)
+    {
+        return false;
+    }
+
+    QList<QByteArray> bounds = rangeAndSize[0].split('-');
+
+    if (bounds.size() != 2)
+    {
+        return false;
+    }
+
+    bool firstOk;
+    bool lastOk;
+
+    t_first = bounds[0].trimmed().toLongLong(&firstOk);
+    t_last = bounds[1].trimmed().toLongLong(&lastOk);
+
+    if (!firstOk || !lastOk || t_first < 0 || t_last < t_first)
+    {
+        return false;
+    }
+
+    if (rangeAndSize[1].trimmed() == "*")
+    {
+        t_totalSize = -1;
+        return true;
+    }
+
+    bool totalSizeOk;
+    t_totalSize = rangeAndSize[1].trimmed().toLongLong(&totalSizeOk);
+
+    return totalSizeOk && t_last < t_totalSize;
+}
+
+bool ByteRanges::parseRangeHeader(const QByteArray& t_rangeHeader, qint64 t_size, QVector<TRange>& t_ranges)
+{
+    QByteArray value = t_rangeHeader.trimmed();
+
+    t_ranges.clear();
+
+    if (!value.toLower().startsWith("bytes="))
+    {
+        return false;
+    }
+
+    for (const QByteArray& range : value.mid(6).split(','))
+    {
+        QList<QByteArray> bounds = range.trimmed().split('-');
+
+        if (bounds.size() != 2)
+        {
+            return false;
+        }
+
+        bool ok;
+        qint64 first = bounds[0].trimmed().toLongLong(&ok);
+
+        if (!ok || first < 0 || first >= t_size)
+        {
+            return false;
+        }
+
+        qint64 last = t_size - 1;
+
+        if (!bounds[1].trimmed().isEmpty())
+        {
+            last = bounds[1].trimmed().toLongLong(&ok);
+
+            if (!ok || last < first)
+            {
+                return false;
+            }
+
+            last = qMin(last, t_size - 1);
+        }
+
+        t_ranges.append(TRange(first, last));
+    }
+
+    return !t_ranges.isEmpty();
+}
+
+bool ByteRanges::isMultipart(const QByteArray& t_contentType)
+{
+    return t_contentType.trimmed().toLower().startsWith("multipart/byteranges");
+}
+
+QByteArray ByteRanges::parseBoundary(const QByteArray& t_contentType)
+{
+    for (const QByteArray& parameter : t_contentType.split(';'))
+    {
+        QByteArray trimmed = parameter.trimmed();
+
+        if (!trimmed.toLower().startsWith("boundary="))
+        {
+            continue;
+        }
+
+        QByteArray boundary = trimmed.mid(9);
+
+        if (boundary.size() >= 2 && boundary.startsWith('"') && boundary.endsWith('"'))
+        {
+            boundary = boundary.mid(1, boundary.size() - 2);
+        }
+
+        return boundary;
+    }
+
+    return QByteArray();
+}
@@ -0,0 +1,61 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#ifndef BYTERANGES_H
+#define BYTERANGES_H
+
+#include <QByteArray>
+#include <QPair>
+#include <QVector>
+
+/**
+ * @brief
+ * Helpers for HTTP byte range requests (RFC 7233).
+ */
+class ByteRanges
+{
+public:
+    // First and last byte of a range, the last byte is -1 for a range reaching the end of the file.
+    typedef QPair<qint64, qint64> TRange;
+
+    /**
+     * @brief formatRangeHeader
+     *
+     * @return
+     * Value of the Range header requesting all the ranges, e.g. "bytes=0-99,200-".
+     */
+    static QByteArray formatRangeHeader(const QVector<TRange>& t_ranges);
+
+    /**
+     * @brief parseContentRange
+     *
+     * Parses the value of a Content-Range header, e.g. "bytes 0-99/1000".
+     * t_totalSize is -1 if the server doesn't know it ("bytes 0-99/*").
+     */
+    static bool parseContentRange(const QByteArray& t_contentRange, qint64& t_first, qint64& t_last, qint64& t_totalSize);
+
+    /**
+     * @brief parseRangeHeader
+     *
+     * Parses the value of a Range header, e.g. "bytes=0-99,200-", into ranges of a resource of t_size bytes.
+     * Ranges reaching past the end or left open are clipped to the last byte, so the last byte is never -1.
+     *
+     * @return
+     * False if the header is malformed or any of the ranges starts past the end (not satisfiable).
+     */
+    static bool parseRangeHeader(const QByteArray& t_rangeHeader, qint64 t_size, QVector<TRange>& t_ranges);
+
+    static bool isMultipart(const QByteArray& t_contentType);
+
+    /**
+     * @brief parseBoundary
+     *
+     * @return
+     * Boundary of a "multipart/byteranges; boundary=..." content type, empty if there is none.
+     */
+    static QByteArray parseBoundary(const QByteArray& t_contentType);
+};
+
+#endif // BYTERANGES_H
@@ -7,6 +7,8 @@
 
 #include <QObject>
 
+#include <atomic>
+
 class CancellationTokenSource : public QObject
 {
     Q_OBJECT
@@ -16,16 +18,17 @@ public:
     {
     }
 
+    // Safe to call from any thread, cheap enough to be checked in tight I/O loops.
     bool isCancelled() const
     {
-        return m_isCancelled;
+        return m_isCancelled.load(std::memory_order_acquire);
     }
 
+    // Safe to call from any thread, the cancelled signal is emitted only once.
     void cancel()
     {
-        if (!m_isCancelled)
+        if (!m_isCancelled.exchange(true, std::memory_order_acq_rel))
         {
-            m_isCancelled = true;
             emit cancelled();
         }
     }
@@ -34,5 +37,5 @@ signals:
     void cancelled();
 
 private:
-    bool m_isCancelled;
+    std::atomic<bool> m_isCancelled;
 };
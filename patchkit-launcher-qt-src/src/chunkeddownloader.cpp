@@ -12,163 +12,665 @@
 #include "downloader.h"
 #include "logger.h"
 #include "staledownloadexception.h"
+#include "telemetry.h"
+#include "multipartreader.h"
+#include "mirrorcapabilities.h"
+#include "config.h"
 
 ChunkedDownloader::ChunkedDownloader(
         QNetworkAccessManager* t_dataSource,
         const ContentSummary& t_contentSummary,
-        HashFunc t_hashingStrategy,
+        HashStreamFunc t_hashingStrategy,
         CancellationToken t_cancellationToken
         )
     : Downloader(t_dataSource, t_cancellationToken)
     , m_contentSummary(t_contentSummary)
-    , m_lastValidChunkIndex(0)
     , m_hashingStrategy(t_hashingStrategy)
     , m_running(true)
+    , m_validChunksCount(0)
+    , m_requestOffset(0)
+    , m_contentSize(-1)
+    , m_streamOffset(0)
+    , m_bytesToSkip(0)
+    , m_chunkIndex(-1)
+    , m_chunkBytesCount(0)
+    , m_isEndgameStarted(false)
 {
+    restart();
 }
 
 QByteArray ChunkedDownloader::downloadFile(const QString& t_urlPath, int t_requestTimeoutMsec, int* t_replyStatusCode)
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+
+    buffer.open(QIODevice::WriteOnly);
+
+    // Chunks received by earlier calls aren't in the new buffer.
+    restart();
+
+    downloadFile(t_urlPath, buffer, t_requestTimeoutMsec, t_replyStatusCode);
+
+    return data;
+}
+
+void ChunkedDownloader::downloadFile(const QString& t_urlPath, QIODevice& t_target, int t_requestTimeoutMsec, int* t_replyStatusCode)
 {
     if (!m_hashingStrategy)
     {
         throw std::runtime_error("No hashing strategy specified.");
     }
 
-    QByteArray data;
-    QNetworkRequest request;
+    if (!m_chunkHash)
+    {
+        m_chunkHash = m_hashingStrategy();
+    }
 
     QUrl url(t_urlPath);
-
-    request = QNetworkRequest(url);
+    QNetworkRequest request(url);
 
     m_running = true;
+    m_requestOffset = 0;
+
+    m_url = t_urlPath;
+    stopEndgame();
+
+    // Download broken off by an earlier call is resumed with the missing ranges right away.
+    if (getReceivedBytesCount() > 0)
+    {
+        request = createRangeRequest(url);
+    }
 
     int replyStatusCode = -1;
+    int idleRequestsCount = 0;
 
     while (!shouldStop())
     {
-        try
+        qint64 receivedBytesCount = getReceivedBytesCount();
+
+        transfer(request, t_target, t_requestTimeoutMsec, replyStatusCode);
+
+        // Duplicated requests may still bring the chunks which the transfer hasn't.
+        finishEndgame(t_target, t_requestTimeoutMsec);
+
+        if (t_replyStatusCode != nullptr)
         {
-            data = Downloader::downloadFile(request, t_requestTimeoutMsec, &replyStatusCode);
+            *t_replyStatusCode = replyStatusCode;
+        }
 
-            if (t_replyStatusCode != nullptr)
-            {
-                *t_replyStatusCode = replyStatusCode;
-            }
+        if (!doesStatusCodeIndicateSuccess(replyStatusCode))
+        {
+            throw std::runtime_error(QString("Chunked download failed, status code was %1.").arg(replyStatusCode).toStdString());
+        }
 
-            if (!doesStatusCodeIndicateSuccess(replyStatusCode))
-            {
-                throw std::runtime_error(QString("Chunked download failed, status code was %1.").arg(replyStatusCode).toStdString());
-            }
+        if (m_validChunksCount == m_contentSummary.getChunksCount())
+        {
+            return;
+        }
+
+        idleRequestsCount = getReceivedBytesCount() > receivedBytesCount ? 0 : idleRequestsCount + 1;
+
+        if (idleRequestsCount >= Config::chunkedDownloadMaxIdleRequests)
+        {
+            throw std::runtime_error("Chunked download doesn't make any progress.");
+        }
+
+        request = createRangeRequest(url);
+    }
+
+    // Aborted download must not be mistaken for a complete one.
+    throw CancelledException();
+}
+
+void ChunkedDownloader::restart()
+{
+    m_validChunks = QBitArray(m_contentSummary.getChunksCount());
+    m_validChunksCount = 0;
+    m_requestOffset = 0;
+
+    m_contentSize = -1;
+    m_chunkIndex = -1;
+    m_chunkBytesCount = 0;
+    m_chunkHash.reset();
+
+    m_isEndgameStarted = false;
+}
+
+QNetworkRequest ChunkedDownloader::createRangeRequest(const QUrl& t_url)
+{
+    QNetworkRequest request(t_url);
+
+    // Range request to a mirror which ignores them would only bring the whole file anyway.
+    if (MirrorCapabilities::getInstance().getRangeSupport(t_url.toString()) == MirrorCapabilities::Unsupported)
+    {
+        logInfo("Mirror doesn't support Range requests, requesting the whole file again, URL: %1", .arg(t_url.toString()));
+
+        m_requestOffset = 0;
+
+        return request;
+    }
+
+    QVector<ByteRanges::TRange> missingRanges = getMissingRanges();
+    QByteArray header = ByteRanges::formatRangeHeader(missingRanges);
+
+    logInfo("Requesting %1 missing ranges, URL: %2, Range header: %3",
+            .arg(QString::number(missingRanges.size()), t_url.toString(), (QString)header));
+
+    m_requestOffset = getReceivedBytesCount();
+
+    request.setRawHeader("Range", header);
+
+    return request;
+}
+
+bool ChunkedDownloader::usesRangeRequests() const
+{
+    return true;
+}
+
+void ChunkedDownloader::setMirrorUrls(const QStringList& t_mirrorUrls)
+{
+    m_mirrorUrls = t_mirrorUrls;
+}
+
+void ChunkedDownloader::onDownloadProgressChanged(const TByteCount &t_bytesDownloaded, const TByteCount &t_totalBytes)
+{
+    emit Downloader::downloadProgressChanged(m_requestOffset + t_bytesDownloaded, m_requestOffset + t_totalBytes);
+}
+
+bool ChunkedDownloader::shouldStop() const
+{
+    return !m_running || m_cancellationToken.isCancelled();
+}
 
-            if (validateReceivedData(data))
+void ChunkedDownloader::abort()
+{
+    m_running = false;
+
+    Downloader::abort();
+}
+
+void ChunkedDownloader::transfer(const QNetworkRequest& t_request, QIODevice& t_target, int t_requestTimeoutMsec, int& t_replyStatusCode)
+{
+    TRemoteDataReply reply;
+
+    fetchReply(t_request, reply);
+
+    reply->setReadBufferSize(Config::downloadReadBufferSize);
+
+    connect(reply.data(), &QNetworkReply::downloadProgress, this, &Downloader::onDownloadProgressChanged);
+
+    waitForReply(reply, t_requestTimeoutMsec);
+    validateReply(reply);
+
+    t_replyStatusCode = getReplyStatusCode(reply);
+
+    QString url = t_request.url().toString();
+    MirrorCapabilities& mirrorCapabilities = MirrorCapabilities::getInstance();
+
+    mirrorCapabilities.recordResponse(url, MirrorCapabilities::Response::fromReply(*reply));
+
+    if (!doesStatusCodeIndicateSuccess(t_replyStatusCode))
+    {
+        return;
+    }
+
+    qint64 contentSize = mirrorCapabilities.getContentSize(url);
+
+    if (contentSize >= 0 && !isContentSizeValid(contentSize))
+    {
+        throw std::runtime_error(QString("Mirror serves content of unexpected size - %1 bytes.").arg(contentSize).toStdString());
+    }
+
+    if (contentSize >= 0)
+    {
+        m_contentSize = contentSize;
+    }
+
+    // Whole file is sent again, progress starts over.
+    if (t_replyStatusCode == 200)
+    {
+        m_requestOffset = 0;
+    }
+
+    const auto dataSink = [this, &t_target](const QByteArray& t_data) -> bool
+    {
+        return acceptData(t_data, t_target);
+    };
+
+    // Transfer is stopped as soon as duplicated requests bring the rest of the chunks.
+    const auto pollHandler = [this, &t_target]() -> bool
+    {
+        if (canStartEndgame())
+        {
+            startEndgame();
+        }
+
+        pollEndgame(t_target);
+
+        return m_validChunksCount < m_contentSummary.getChunksCount();
+    };
+
+    QByteArray contentType = reply->rawHeader("Content-Type");
+
+    if (t_replyStatusCode == 206 && ByteRanges::isMultipart(contentType))
+    {
+        QByteArray boundary = ByteRanges::parseBoundary(contentType);
+
+        if (boundary.isEmpty())
+        {
+            throw std::runtime_error("Malformed multipart response.");
+        }
+
+        const auto partHandler = [this, &t_target](qint64 t_offset)
+        {
+            finishPart();
+            beginPart(t_offset);
+        };
+
+        MultipartReader reader(boundary, partHandler, dataSink);
+
+        readReplyData(reply, [&reader](const QByteArray& t_data) -> bool
+        {
+            return reader.read(t_data);
+        }, pollHandler, t_requestTimeoutMsec);
+    }
+    else
+    {
+        // Server which doesn't support ranges sends the whole file with 200.
+        qint64 offset = 0;
+
+        if (t_replyStatusCode == 206)
+        {
+            qint64 last;
+            qint64 totalSize;
+
+            if (!ByteRanges::parseContentRange(reply->rawHeader("Content-Range"), offset, last, totalSize))
             {
-                break;
+                throw std::runtime_error("Invalid Content-Range header.");
             }
-            else
-            {
-                int startIndex = m_lastValidChunkIndex + 1;
-                if (m_lastValidChunkIndex == 0)
-                {
-                    startIndex = 0;
-                }
+        }
+
+        beginPart(offset);
+        readReplyData(reply, dataSink, pollHandler, t_requestTimeoutMsec);
+    }
+
+    finishPart();
+
+    disconnect(reply.data(), &QNetworkReply::downloadProgress, this, &Downloader::onDownloadProgressChanged);
+}
+
+void ChunkedDownloader::beginPart(qint64 t_offset)
+{
+    const int chunkSize = getChunkSize();
+
+    m_streamOffset = t_offset;
+    m_bytesToSkip = 0;
+
+    // Part which continues the partially received chunk resumes hashing where it has stopped.
+    if (m_chunkIndex >= 0 && t_offset == getChunkOffset(m_chunkIndex) + m_chunkBytesCount)
+    {
+        return;
+    }
+
+    m_chunkIndex = -1;
 
-                QByteArray header = "bytes=" + QByteArray::number(startIndex * getChunkSize()) + "-";
+    // Data before the first chunk boundary of a part can't be validated.
+    m_bytesToSkip = (chunkSize - t_offset % chunkSize) % chunkSize;
+}
+
+bool ChunkedDownloader::acceptData(const QByteArray& t_data, QIODevice& t_target)
+{
+    int position = int(qMin<qint64>(m_bytesToSkip, t_data.size()));
 
-                logInfo("Reformulating request URL: %1, Range header: %2", .arg(url.toString(), (QString)header));
+    m_bytesToSkip -= position;
+    m_streamOffset += position;
 
-                request = QNetworkRequest(url);
-                request.setRawHeader("Range", header);
+    while (position < t_data.size())
+    {
+        if (m_chunkIndex < 0)
+        {
+            int index = int(m_streamOffset / getChunkSize());
+
+            // Data beyond the last chunk isn't described by the content summary.
+            if (index >= m_contentSummary.getChunksCount())
+            {
+                return false;
             }
+
+            m_chunkIndex = index;
+            m_chunkBytesCount = 0;
+            m_chunkHash->reset();
         }
-        catch (CancelledException&)
+
+        int length = int(qMin<qint64>(getChunkLength(m_chunkIndex) - m_chunkBytesCount, t_data.size() - position));
+
+        // Chunks which are already valid are only passed over.
+        if (!m_validChunks.testBit(m_chunkIndex))
         {
-            throw;
+            m_chunkHash->update(t_data.constData() + position, length);
+
+            qint64 offset = m_streamOffset;
+
+            if ((t_target.pos() != offset && !t_target.seek(offset))
+                || t_target.write(t_data.constData() + position, length) != length)
+            {
+                throw std::runtime_error("Couldn't write downloaded data.");
+            }
         }
-        catch (TimeoutException&)
+
+        position += length;
+        m_streamOffset += length;
+        m_chunkBytesCount += length;
+
+        if (m_chunkBytesCount == getChunkLength(m_chunkIndex))
         {
-            throw;
+            validateChunk();
         }
     }
 
-    QByteArray reassembledData;
-    for (QByteArray chunk : m_chunks)
+    return true;
+}
+
+void ChunkedDownloader::finishPart()
+{
+    // Without the content size the end of the part is the only hint that the last chunk is complete.
+    if (m_chunkIndex == m_contentSummary.getChunksCount() - 1 && m_contentSize < 0)
     {
-        reassembledData += chunk;
+        validateChunk();
     }
-
-    return reassembledData;
 }
 
-void ChunkedDownloader::onDownloadProgressChanged(const TByteCount &t_bytesDownloaded, const TByteCount &t_totalBytes)
+void ChunkedDownloader::validateChunk()
 {
-    TByteCount bytesInValidChunksDownloadedSoFar = m_lastValidChunkIndex * getChunkSize();
-    emit Downloader::downloadProgressChanged(bytesInValidChunksDownloadedSoFar + t_bytesDownloaded, bytesInValidChunksDownloadedSoFar+ t_totalBytes);
+    m_cancellationToken.throwIfCancelled();
+
+    int index = m_chunkIndex;
+
+    m_chunkIndex = -1;
+
+    if (m_validChunks.testBit(index))
+    {
+        return;
+    }
+
+    if (m_chunkHash->digest() != m_contentSummary.getChunkHash(index))
+    {
+        logWarning("Chunk %1 is invalid.", .arg(QString::number(index)));
+        Telemetry::getInstance().addCounter("chunks_rejected");
+        return;
+    }
+
+    m_validChunks.setBit(index);
+    m_validChunksCount++;
 }
 
-bool ChunkedDownloader::shouldStop() const
+bool ChunkedDownloader::canStartEndgame() const
 {
-    return !m_running;
+    int outstandingChunksCount = m_contentSummary.getChunksCount() - m_validChunksCount;
+
+    return !m_isEndgameStarted
+        && m_validChunksCount > 0
+        && outstandingChunksCount > 0
+        && outstandingChunksCount <= Config::chunkedDownloadEndgameChunksCount
+        && getPriority() == RateLimiter::Foreground
+        && RateLimiter::getInstance(RateLimiter::Foreground).getBytesPerSecond() == 0;
 }
 
-void ChunkedDownloader::abort()
+void ChunkedDownloader::startEndgame()
 {
-    Downloader::abort();
+    m_isEndgameStarted = true;
 
-    m_running = false;
+    QStringList mirrorUrls;
+
+    for (const QString& url : MirrorCapabilities::getInstance().planRangeDownloads(m_mirrorUrls))
+    {
+        if (url != m_url && mirrorUrls.size() < Config::chunkedDownloadEndgameMirrorsCount
+            && MirrorCapabilities::getInstance().getRangeSupport(url) != MirrorCapabilities::Unsupported)
+        {
+            mirrorUrls.append(url);
+        }
+    }
+
+    if (mirrorUrls.isEmpty())
+    {
+        return;
+    }
+
+    logInfo("Endgame - requesting %1 outstanding chunks from %2 other mirrors.",
+            .arg(QString::number(m_contentSummary.getChunksCount() - m_validChunksCount), QString::number(mirrorUrls.size())));
+
+    Telemetry::getInstance().addCounter("endgame_downloads");
+
+    // Every outstanding chunk is requested from one other mirror before any is requested from a second one.
+    for (const QString& url : mirrorUrls)
+    {
+        for (int index = 0; index < m_contentSummary.getChunksCount(); index++)
+        {
+            if (m_validChunks.testBit(index))
+            {
+                continue;
+            }
+
+            if (m_endgameRequests.size() >= Config::chunkedDownloadEndgameMaxRequestsCount)
+            {
+                return;
+            }
+
+            bool isLastChunk = index == m_contentSummary.getChunksCount() - 1;
+
+            qint64 firstByte = getChunkOffset(index);
+            qint64 lastByte = isLastChunk ? -1 : firstByte + getChunkSize() - 1;
+
+            QNetworkRequest request((QUrl(url)));
+            request.setRawHeader("Range", ByteRanges::formatRangeHeader({ByteRanges::TRange(firstByte, lastByte)}));
+
+            EndgameRequest endgameRequest;
+            endgameRequest.chunkIndex = index;
+            endgameRequest.hash = std::shared_ptr<HashStream>(m_hashingStrategy());
+
+            fetchReply(request, endgameRequest.reply);
+
+            connect(endgameRequest.reply.data(), &QNetworkReply::readyRead, this, &Downloader::replyActivity);
+            connect(endgameRequest.reply.data(), &QNetworkReply::finished, this, &Downloader::replyActivity);
+
+            m_endgameRequests.append(endgameRequest);
+        }
+    }
 }
 
-QVector<QByteArray> ChunkedDownloader::processChunks(QByteArray& t_data) const
+bool ChunkedDownloader::pollEndgame(QIODevice& t_target)
 {
-    QVector<QByteArray> chunks;
+    bool isActive = false;
 
-    const int chunkSize = getChunkSize();
-    for (int i = 0; i < t_data.size(); i += chunkSize)
+    for (int i = 0; i < m_endgameRequests.size();)
     {
-        // Get the chunk
-        QByteArray chunk = t_data.mid(i, chunkSize);
+        EndgameRequest& request = m_endgameRequests[i];
+        QNetworkReply* reply = request.reply.data();
+
+        QVariant statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute);
+
+        bool isValid = reply->error() == QNetworkReply::NoError
+                    && !m_validChunks.testBit(request.chunkIndex)
+                    && (!statusCode.isValid() || statusCode.toInt() == 206);
+
+        if (isValid && reply->bytesAvailable() > 0)
+        {
+            QByteArray data = reply->readAll();
+
+            Telemetry::getInstance().addCounter("downloaded_bytes", data.size());
+
+            request.data += data;
+            request.hash->update(data.constData(), data.size());
+            isActive = true;
 
-        chunks.push_back(chunk);
+            // Mirror which sends more than a chunk doesn't honor the range.
+            isValid = request.data.size() <= getChunkSize();
+        }
+
+        if (isValid && !reply->isFinished())
+        {
+            i++;
+            continue;
+        }
+
+        if (isValid && request.hash->digest() == m_contentSummary.getChunkHash(request.chunkIndex))
+        {
+            acceptEndgameChunk(request.chunkIndex, request.data, t_target);
+        }
+
+        request.reply->abort();
+        m_endgameRequests.removeAt(i);
+
+        isActive = true;
     }
 
-    return chunks;
+    return isActive;
 }
 
-bool ChunkedDownloader::validateReceivedData(QByteArray& t_data)
+void ChunkedDownloader::finishEndgame(QIODevice& t_target, int t_requestTimeoutMsec)
 {
-    QVector<QByteArray> chunks = processChunks(t_data);
+    if (m_endgameRequests.isEmpty())
+    {
+        return;
+    }
+
+    QEventLoop waitLoop;
+    QTimer staleTimer;
+
+    staleTimer.setSingleShot(true);
+    staleTimer.setInterval(t_requestTimeoutMsec);
 
-    m_chunks += chunks;
+    connect(this, &Downloader::replyActivity, &waitLoop, &QEventLoop::quit);
+    connect(&m_cancellationToken, &CancellationToken::cancelled, &waitLoop, &QEventLoop::quit);
+    connect(&staleTimer, &QTimer::timeout, &waitLoop, &QEventLoop::quit);
 
-    for (int i = m_lastValidChunkIndex; i < m_chunks.size(); i++)
+    staleTimer.start();
+
+    while (!m_endgameRequests.isEmpty() && m_validChunksCount < m_contentSummary.getChunksCount())
     {
-        // Get the content summary hash
-        THash valid_hash = m_contentSummary.getChunkHash(i);
+        m_cancellationToken.throwIfCancelled();
 
-        // At this point the m_hashingStrategy is guaranteed to be valid, no need to check if it's null.
-        THash hash = m_hashingStrategy(m_chunks.at(i));
+        if (pollEndgame(t_target))
+        {
+            staleTimer.start();
+            continue;
+        }
 
-        if (valid_hash != hash)
+        if (!staleTimer.isActive())
         {
-            // Mark the previous index as the last valid
-            m_lastValidChunkIndex = i - 1;
+            logWarning("Endgame requests have stalled.");
+            break;
+        }
 
-            if (m_lastValidChunkIndex < 0)
-                m_lastValidChunkIndex = 0;
+        waitLoop.exec();
+    }
 
-            // Rend the remaining invalid chunks
-            m_chunks.remove(i, m_chunks.size() - i);
+    stopEndgame();
+}
 
-            // Signal to restart download
-            return false;
+void ChunkedDownloader::stopEndgame()
+{
+    for (EndgameRequest& request : m_endgameRequests)
+    {
+        request.reply->abort();
+    }
+
+    m_endgameRequests.clear();
+}
+
+void ChunkedDownloader::acceptEndgameChunk(int t_index, const QByteArray& t_data, QIODevice& t_target)
+{
+    qint64 offset = getChunkOffset(t_index);
+
+    if ((t_target.pos() != offset && !t_target.seek(offset)) || t_target.write(t_data) != t_data.size())
+    {
+        throw std::runtime_error("Couldn't write downloaded data.");
+    }
+
+    logInfo("Endgame - chunk %1 was delivered by another mirror first.", .arg(QString::number(t_index)));
+    Telemetry::getInstance().addCounter("endgame_chunks");
+
+    m_validChunks.setBit(t_index);
+    m_validChunksCount++;
+}
+
+QVector<ByteRanges::TRange> ChunkedDownloader::getMissingRanges() const
+{
+    QVector<ByteRanges::TRange> ranges;
+
+    const qint64 chunkSize = getChunkSize();
+    const int chunksCount = m_contentSummary.getChunksCount();
+
+    int index = 0;
+
+    while (index < chunksCount && ranges.size() < Config::chunkedDownloadMaxRangesPerRequest)
+    {
+        if (m_validChunks.testBit(index))
+        {
+            index++;
+            continue;
         }
-        else
+
+        int first = index;
+
+        while (index < chunksCount && !m_validChunks.testBit(index))
         {
-            m_lastValidChunkIndex = i;
+            index++;
         }
+
+        qint64 firstByte = first * chunkSize;
+
+        // Partially received chunk is resumed at the first byte which hasn't arrived.
+        if (first == m_chunkIndex)
+        {
+            firstByte += m_chunkBytesCount;
+        }
+
+        // Range reaching the last chunk is left open, as the last chunk may be shorter.
+        qint64 lastByte = index == chunksCount ? -1 : index * chunkSize - 1;
+
+        ranges.append(ByteRanges::TRange(firstByte, lastByte));
+    }
+
+    return ranges;
+}
+
+bool ChunkedDownloader::isContentSizeValid(qint64 t_contentSize) const
+{
+    const qint64 chunkSize = getChunkSize();
+    const qint64 chunksCount = m_contentSummary.getChunksCount();
+
+    // Only the last chunk can be shorter than the chunk size.
+    return t_contentSize > (chunksCount - 1) * chunkSize && t_contentSize <= chunksCount * chunkSize;
+}
+
+qint64 ChunkedDownloader::getReceivedBytesCount() const
+{
+    qint64 count = qint64(m_validChunksCount) * getChunkSize();
+
+    if (m_chunkIndex >= 0 && !m_validChunks.testBit(m_chunkIndex))
+    {
+        count += m_chunkBytesCount;
+    }
+
+    return count;
+}
+
+qint64 ChunkedDownloader::getChunkOffset(int t_index) const
+{
+    return qint64(t_index) * getChunkSize();
+}
+
+qint64 ChunkedDownloader::getChunkLength(int t_index) const
+{
+    // Only the last chunk can be shorter, its length is known only with the content size.
+    if (t_index == m_contentSummary.getChunksCount() - 1 && m_contentSize >= 0)
+    {
+        return m_contentSize - getChunkOffset(t_index);
     }
 
-    return m_chunks.size() == m_contentSummary.getChunksCount();
+    return getChunkSize();
 }
 
 const int ChunkedDownloader::getChunkSize() const
@@ -8,11 +8,14 @@
 
 #include <QObject>
 #include <QVector>
-#include <QStack>
+#include <QBitArray>
+
+#include <atomic>
 
 #include "downloader.h"
 
 #include "hashingstrategy.h"
+#include "byteranges.h"
 
 class ContentSummary;
 
@@ -25,17 +28,37 @@ class QNetworkAccessManager;
  * Downloads files in chunks which are specified by the Content Summary.
  *
  * @details
- * As it is implemented now, the Chunked Downloader downloads the data through the QNetworkReply.
- * When the connection is broken or for any other reason the download has stopped, it validates all the downloaded data.
- * Once the data is validated the ChunkedDownloader proceeds to restart the download from the first invalid chunk (or from the start if no chunks were received)
+ * The Chunked Downloader streams the data from the QNetworkReply into the target device, each chunk at its own offset,
+ * so the target device has to be seekable. Chunks are hashed incrementally as the data arrives and validated as soon
+ * as they are complete - no chunk of the main transfer is kept in memory, regardless of the chunk or file size.
+ *
+ * Once a transfer is over - finished, broken or for any other reason stopped - the chunks which are invalid
+ * or missing are downloaded again, and only them. A chunk broken off in the middle is resumed at the first byte
+ * which hasn't arrived, with its hashing state kept from the previous transfer, so no received byte is downloaded twice. Neighbouring chunks are coalesced into a single range and
+ * all the ranges are requested at once; the response can be a "multipart/byteranges" body, a single range
+ * (the server may serve fewer ranges than requested, the rest is requested again) or the whole file.
+ * Mirrors known to ignore Range requests (see MirrorCapabilities) are asked for the whole file right away,
+ * and mirrors serving content of a size which doesn't match the Content Summary are rejected.
+ *
+ * Endgame mode - once only Config::chunkedDownloadEndgameChunksCount chunks are outstanding, each of them is
+ * requested from up to Config::chunkedDownloadEndgameMirrorsCount other mirrors in parallel with the running
+ * transfer. The first valid copy of a chunk is written and the other requests for it are aborted, so a slow
+ * mirror doesn't hold up the end of the download. Endgame is started once per download, and only for
+ * foreground downloads without a bandwidth limit, as duplicated requests wouldn't be any faster under a limit.
+ * A duplicated copy is hashed as it arrives, but kept in memory until it's complete, as only a valid copy
+ * may overwrite what the main transfer has written. At most Config::chunkedDownloadEndgameMaxRequestsCount
+ * duplicated requests run at once, which bounds the memory to as many chunks.
+ *
+ * State of the download is kept between the calls of downloadFile with a target device, so a retry after a timeout
+ * or an error - from the same mirror or another one - continues where the previous call has stopped.
+ * A transfer which doesn't bring any data for the request timeout is broken off with a TimeoutException.
  *
  * The t_staleDownloadTimeoutMsec parameter (passed in constructor) controls the time needed to cause
  * the stale download exception - if no good chunks have been downloaded in this time, the download will terminate
  * and an exception will be thrown.
  *
  * @note
- * This means that if in a set of 20 chunks the chunk #5 happened to be invalid but all the other ones were valid
- * the download will resume from the 5th chunk.
+ * This means that if in a set of 20 chunks the chunk #5 happened to be invalid, only the 5th chunk is downloaded again.
  */
 class ChunkedDownloader : public Downloader
 {
@@ -45,12 +68,42 @@ public:
     ChunkedDownloader(
             QNetworkAccessManager* t_dataSource,
             const ContentSummary& t_contentSummary,
-            HashFunc t_hashingStrategy,
+            HashStreamFunc t_hashingStrategy,
             CancellationToken t_cancellationToken
             );
 
+    /**
+     * @brief downloadFile
+     *
+     * Downloads the whole file into a new buffer, chunks received by earlier calls are forgotten.
+     */
     QByteArray downloadFile(const QString& t_urlPath, int t_requestTimeoutMsec, int* t_replyStatusCode = nullptr) override;
 
+    /**
+     * @brief downloadFile
+     *
+     * Continues the download into t_target - chunks received by earlier calls, from this or any other mirror,
+     * stay valid and only the missing ranges are requested. t_target has to be the same device every time.
+     */
+    void downloadFile(const QString& t_urlPath, QIODevice& t_target, int t_requestTimeoutMsec, int* t_replyStatusCode = nullptr) override;
+
+    /**
+     * @brief restart
+     *
+     * Forgets the chunks received so far, the next download starts from the first byte.
+     */
+    void restart();
+
+    bool usesRangeRequests() const override;
+
+    /**
+     * @brief setMirrorUrls
+     *
+     * Mirrors serving the same content. When only a few chunks are outstanding, they are requested
+     * from other mirrors too, see the endgame mode.
+     */
+    void setMirrorUrls(const QStringList& t_mirrorUrls);
+
 public slots:
     virtual void abort() override;
 
@@ -58,16 +111,57 @@ protected slots:
     virtual void onDownloadProgressChanged(const TByteCount& t_bytesDownloaded, const TByteCount& t_totalBytes) override;
 
 private:
-    bool                    m_running;
-
-    QVector<QByteArray>     m_chunks;
-    int                     m_lastValidChunkIndex;
-    HashFunc                m_hashingStrategy;
     const ContentSummary&   m_contentSummary;
-
-    QVector<QByteArray> processChunks(QByteArray& t_data) const;
-
-    bool        validateReceivedData(QByteArray& t_data);
+    HashStreamFunc          m_hashingStrategy;
+    std::atomic<bool>       m_running;
+
+    QBitArray               m_validChunks;
+    int                     m_validChunksCount;
+    qint64                  m_requestOffset;
+    qint64                  m_contentSize;
+
+    qint64                  m_streamOffset;
+    qint64                  m_bytesToSkip;
+
+    // Chunk which is being received, kept between transfers so that it can be resumed at any byte.
+    int                         m_chunkIndex;
+    qint64                      m_chunkBytesCount;
+    std::unique_ptr<HashStream> m_chunkHash;
+
+    struct EndgameRequest
+    {
+        int                         chunkIndex;
+        TRemoteDataReply            reply;
+        QByteArray                  data;
+        std::shared_ptr<HashStream> hash;
+    };
+
+    QStringList             m_mirrorUrls;
+    QString                 m_url;
+    bool                    m_isEndgameStarted;
+    QList<EndgameRequest>   m_endgameRequests;
+
+    QNetworkRequest createRangeRequest(const QUrl& t_url);
+    void        transfer(const QNetworkRequest& t_request, QIODevice& t_target, int t_requestTimeoutMsec, int& t_replyStatusCode);
+
+    void        beginPart(qint64 t_offset);
+    bool        acceptData(const QByteArray& t_data, QIODevice& t_target);
+    void        finishPart();
+    void        validateChunk();
+
+    bool        canStartEndgame() const;
+    void        startEndgame();
+    bool        pollEndgame(QIODevice& t_target);
+    void        finishEndgame(QIODevice& t_target, int t_requestTimeoutMsec);
+    void        stopEndgame();
+    void        acceptEndgameChunk(int t_index, const QByteArray& t_data, QIODevice& t_target);
+
+    QVector<ByteRanges::TRange> getMissingRanges() const;
+
+    bool        isContentSizeValid(qint64 t_contentSize) const;
+    qint64      getReceivedBytesCount() const;
+    qint64      getChunkOffset(int t_index) const;
+    qint64      getChunkLength(int t_index) const;
     const int   getChunkSize() const;
 
     bool        shouldStop() const;
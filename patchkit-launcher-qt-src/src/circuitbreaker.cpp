@@ -0,0 +1,42 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "circuitbreaker.h"
+
+CircuitBreaker::CircuitBreaker(int t_failureThreshold, int t_openDurationMsec)
+    : m_failureThreshold(t_failureThreshold)
+    , m_openDurationMsec(t_openDurationMsec)
+{
+    m_clock.start();
+}
+
+bool CircuitBreaker::isAllowed(const QString& t_mirror) const
+{
+    auto it = m_states.find(t_mirror);
+
+    if (it == m_states.end() || it.value().failures < m_failureThreshold)
+    {
+        return true;
+    }
+
+    return m_clock.elapsed() - it.value().openedAtMsec >= m_openDurationMsec;
+}
+
+void CircuitBreaker::recordSuccess(const QString& t_mirror)
+{
+    m_states.remove(t_mirror);
+}
+
+void CircuitBreaker::recordFailure(const QString& t_mirror)
+{
+    State& state = m_states[t_mirror];
+
+    state.failures++;
+
+    if (state.failures >= m_failureThreshold)
+    {
+        state.openedAtMsec = m_clock.elapsed();
+    }
+}
@@ -0,0 +1,51 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#ifndef CIRCUITBREAKER_H
+#define CIRCUITBREAKER_H
+
+#include <QString>
+#include <QHash>
+#include <QElapsedTimer>
+
+/**
+ * @brief
+ * Stops using a mirror for a while after it has failed several times in a row.
+ *
+ * @details
+ * After t_failureThreshold consecutive failures the circuit of a mirror is open and the mirror is skipped.
+ * Once t_openDurationMsec has passed the mirror is given a single attempt (half-open circuit) -
+ * a success closes the circuit, a failure opens it again.
+ */
+class CircuitBreaker
+{
+public:
+    CircuitBreaker(int t_failureThreshold, int t_openDurationMsec);
+
+    bool    isAllowed(const QString& t_mirror) const;
+
+    void    recordSuccess(const QString& t_mirror);
+    void    recordFailure(const QString& t_mirror);
+
+private:
+    struct State
+    {
+        State()
+            : failures(0)
+            , openedAtMsec(0)
+        {
+        }
+
+        int     failures;
+        qint64  openedAtMsec;
+    };
+
+    int                     m_failureThreshold;
+    int                     m_openDurationMsec;
+    QElapsedTimer           m_clock;
+    QHash<QString, State>   m_states;
+};
+
+#endif // CIRCUITBREAKER_H
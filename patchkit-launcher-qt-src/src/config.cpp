@@ -6,6 +6,10 @@
 #include "config.h"
 
 const QString Config::logFileName = "launcher-log.txt";
+const int Config::logFlushIntervalMsec = 250;
+const QString Config::logLevelArg = "--log-level";
+const QString Config::telemetryReportFileName = "launcher-telemetry.json";
+const QString Config::telemetryReportArg = "--telemetry-report";
 
 const QString Config::dataFileName = "launcher.dat";
 const int Config::dataResourceId = 3151;
@@ -19,18 +23,40 @@ const QString Config::patcherManifestFileName = "patcher.manifest";
 
 const QString Config::applicationDirectoryName = "app";
 
+const QString Config::patcherStagingDirectoryName = "patcher_staging";
+const QString Config::patcherStagingArchiveFileName = "patcher.zip";
+const QString Config::patcherStagingLockFileName = "staging.lock";
+const int Config::patcherStagingLockTimeoutMsec = 5000;
+
+const int Config::workerCancellationTimeoutMsec = 10000;
+
 const int Config::minConnectionTimeoutMsec = 10000;
 const int Config::maxConnectionTimeoutMsec = 30000;
+const int Config::adaptiveMinConnectionTimeoutMsec = 500;
 
 const int Config::chunkedDownloadStaleTimeoutMsec = 120000;
+const int Config::chunkedDownloadMaxIdleRequests = 3;
+const int Config::chunkedDownloadMaxRangesPerRequest = 32;
+const int Config::chunkedDownloadEndgameChunksCount = 4;
+const int Config::chunkedDownloadEndgameMirrorsCount = 2;
+const int Config::chunkedDownloadEndgameMaxRequestsCount = 4;
+
+const int Config::contentUrlsBackoffBaseMsec = 1000;
+const int Config::contentUrlsBackoffCapMsec = 30000;
 
-const int Config::timeBetweenContentUrlsIterations = 10000;
+const int Config::contentUrlFailureThreshold = 3;
+const int Config::contentUrlCircuitOpenMsec = 60000;
 
 const QString Config::mainApiUrl = "http://api.patchkit.net";
 const QStringList Config::cacheApiUrls = (QStringList() << "http://api-cache-1.patchkit.net"
     << "http://api-cache-2.patchkit.net"
     << "http://api-cache-3.patchkit.net");
 
+const int Config::connectionWarmupMaxContentHosts = 3;
+
+const int Config::progressReportIntervalMsec = 100;
+const double Config::progressSpeedSmoothingFactor = 0.3;
+
 const QString Config::pingTarget = "8.8.8.8";
 
 #if defined(_WIN64) || defined(_WIN32)
@@ -38,3 +64,30 @@ const QString Config::pingCountArg = "-n";
 #else
 const QString Config::pingCountArg = "-c";
 #endif
+
+const QString Config::contentSummaryCacheDirectoryName = "content_summaries";
+const int Config::contentSummaryCacheSize = 4;
+
+const QString Config::peerSharingArg = "--peer-sharing";
+const QString Config::peerSharingInterfaceArg = "--peer-sharing-interface";
+const QString Config::peerCacheDirectoryName = "peer_cache";
+const quint16 Config::peerDiscoveryPort = 43187;
+const int Config::peerDiscoveryTimeoutMsec = 1000;
+
+const QString Config::downloadRateLimitArg = "--download-rate-limit";
+const QString Config::backgroundDownloadRateLimitArg = "--background-download-rate-limit";
+const qint64 Config::defaultBackgroundDownloadRateLimit = 512 * 1024;
+const qint64 Config::downloadReadBufferSize = 1024 * 1024;
+
+const QString Config::http2Arg = "--http2";
+
+const QString Config::prefetchArg = "--prefetch";
+const QString Config::prefetchHelperArg = "--prefetch-helper";
+const QString Config::prefetchLogFileName = "launcher-prefetch-log.txt";
+const QString Config::prefetchTelemetryReportFileName = "launcher-prefetch-telemetry.json";
+const QString Config::prefetchLockFileName = "prefetch.lock";
+const int Config::prefetchPollIntervalMsec = 15 * 60 * 1000;
+const int Config::prefetchLifetimeMsec = 4 * 60 * 60 * 1000;
+
+const QString Config::fastLaunchArg = "--fast-launch";
+const qint64 Config::fastLaunchMaxStalenessMsec = qint64(7) * 24 * 60 * 60 * 1000;
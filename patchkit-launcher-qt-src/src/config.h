@@ -11,6 +11,10 @@ class Config
 {
 public:
     const static QString logFileName;
+    const static int logFlushIntervalMsec;
+    const static QString logLevelArg;
+    const static QString telemetryReportFileName;
+    const static QString telemetryReportArg;
 
     const static QString dataFileName;
     const static int dataResourceId;
@@ -24,16 +28,65 @@ public:
 
     const static QString applicationDirectoryName;
 
+    const static QString patcherStagingDirectoryName;
+    const static QString patcherStagingArchiveFileName;
+    const static QString patcherStagingLockFileName;
+    const static int patcherStagingLockTimeoutMsec;
+
+    const static int workerCancellationTimeoutMsec;
+
     const static int minConnectionTimeoutMsec;
     const static int maxConnectionTimeoutMsec;
+    const static int adaptiveMinConnectionTimeoutMsec;
 
     const static int chunkedDownloadStaleTimeoutMsec;
+    const static int chunkedDownloadMaxIdleRequests;
+    const static int chunkedDownloadMaxRangesPerRequest;
+    const static int chunkedDownloadEndgameChunksCount;
+    const static int chunkedDownloadEndgameMirrorsCount;
+    const static int chunkedDownloadEndgameMaxRequestsCount;
+
+    const static int contentUrlsBackoffBaseMsec;
+    const static int contentUrlsBackoffCapMsec;
 
-    const static int timeBetweenContentUrlsIterations;
+    const static int contentUrlFailureThreshold;
+    const static int contentUrlCircuitOpenMsec;
 
     const static QString mainApiUrl;
     const static QStringList cacheApiUrls;
 
+    const static int connectionWarmupMaxContentHosts;
+
+    const static int progressReportIntervalMsec;
+    const static double progressSpeedSmoothingFactor;
+
     const static QString pingTarget;
     const static QString pingCountArg;
+
+    const static QString contentSummaryCacheDirectoryName;
+    const static int contentSummaryCacheSize;
+
+    const static QString peerSharingArg;
+    const static QString peerSharingInterfaceArg;
+    const static QString peerCacheDirectoryName;
+    const static quint16 peerDiscoveryPort;
+    const static int peerDiscoveryTimeoutMsec;
+
+    const static QString downloadRateLimitArg;
+    const static QString backgroundDownloadRateLimitArg;
+    const static qint64 defaultBackgroundDownloadRateLimit;
+    const static qint64 downloadReadBufferSize;
+
+    const static QString http2Arg;
+
+    const static QString prefetchArg;
+    const static QString prefetchHelperArg;
+    const static QString prefetchLogFileName;
+    const static QString prefetchTelemetryReportFileName;
+    const static QString prefetchLockFileName;
+    const static int prefetchPollIntervalMsec;
+    const static int prefetchLifetimeMsec;
+
+    const static QString fastLaunchArg;
+    const static qint64 fastLaunchMaxStalenessMsec;
 };
@@ -0,0 +1,168 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "connectionwarmer.h"
+
+#include <QNetworkAccessManager>
+#include <QSettings>
+
+#include "config.h"
+#include "logger.h"
+#include "telemetry.h"
+
+const QString ConnectionWarmer::defaultSettingsName = "launcher-content-hosts";
+
+ConnectionWarmer::ConnectionWarmer(const QString& t_settingsName)
+    : m_settingsName(t_settingsName)
+{
+    load();
+}
+
+void ConnectionWarmer::rememberContentUrls(const QStringList& t_urls)
+{
+    QList<QUrl> origins;
+
+    for (const QString& url : t_urls)
+    {
+        QUrl origin = getOrigin(url);
+
+        if (!origin.isValid() || origins.contains(origin))
+        {
+            continue;
+        }
+
+        origins.append(origin);
+
+        if (origins.size() >= Config::connectionWarmupMaxContentHosts)
+        {
+            break;
+        }
+    }
+
+    if (origins.isEmpty())
+    {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    if (origins == m_contentOrigins)
+    {
+        return;
+    }
+
+    m_contentOrigins = origins;
+
+    save();
+}
+
+QList<QUrl> ConnectionWarmer::getContentOrigins() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_contentOrigins;
+}
+
+QList<QUrl> ConnectionWarmer::getWarmupOrigins() const
+{
+    QList<QUrl> origins;
+
+    for (const QString& url : QStringList(Config::mainApiUrl) + Config::cacheApiUrls)
+    {
+        QUrl origin = getOrigin(url);
+
+        if (origin.isValid() && !origins.contains(origin))
+        {
+            origins.append(origin);
+        }
+    }
+
+    for (const QUrl& origin : getContentOrigins())
+    {
+        if (!origins.contains(origin))
+        {
+            origins.append(origin);
+        }
+    }
+
+    return origins;
+}
+
+void ConnectionWarmer::warmUp(QNetworkAccessManager& t_networkAccessManager) const
+{
+    for (const QUrl& origin : getWarmupOrigins())
+    {
+        logDebug("Warming up connection to %1", .arg(origin.toString()));
+
+        if (origin.scheme() == "https")
+        {
+#ifndef QT_NO_SSL
+            t_networkAccessManager.connectToHostEncrypted(origin.host(), origin.port(443));
+#endif
+        }
+        else
+        {
+            t_networkAccessManager.connectToHost(origin.host(), origin.port(80));
+        }
+
+        Telemetry::getInstance().addCounter("connection_warmups");
+    }
+}
+
+void ConnectionWarmer::load()
+{
+    if (m_settingsName.isEmpty())
+    {
+        return;
+    }
+
+    QSettings settings("UpSoft", m_settingsName);
+
+    for (const QString& url : settings.value("content_origins").toStringList())
+    {
+        QUrl origin = getOrigin(url);
+
+        if (origin.isValid() && !m_contentOrigins.contains(origin))
+        {
+            m_contentOrigins.append(origin);
+        }
+    }
+}
+
+void ConnectionWarmer::save() const
+{
+    if (m_settingsName.isEmpty())
+    {
+        return;
+    }
+
+    QStringList urls;
+
+    for (const QUrl& origin : m_contentOrigins)
+    {
+        urls.append(origin.toString());
+    }
+
+    QSettings settings("UpSoft", m_settingsName);
+
+    settings.setValue("content_origins", urls);
+}
+
+QUrl ConnectionWarmer::getOrigin(const QString& t_url)
+{
+    QUrl url(t_url);
+
+    if (url.host().isEmpty() || (url.scheme() != "http" && url.scheme() != "https"))
+    {
+        return QUrl();
+    }
+
+    QUrl origin;
+    origin.setScheme(url.scheme());
+    origin.setHost(url.host());
+    origin.setPort(url.port());
+
+    return origin;
+}
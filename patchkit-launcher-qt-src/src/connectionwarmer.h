@@ -0,0 +1,75 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#ifndef CONNECTIONWARMER_H
+#define CONNECTIONWARMER_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QUrl>
+#include <QMutex>
+
+class QNetworkAccessManager;
+
+/**
+ * @brief
+ * Opens connections to the hosts the launcher is about to talk to, before any request is sent.
+ *
+ * @details
+ * Content urls are known only after several API round trips, but they rarely change between runs.
+ * Origins (scheme, host and port) of the last content urls are stored in QSettings under t_settingsName,
+ * so that the next run can connect to them together with the API servers as soon as it starts -
+ * TCP and TLS handshakes overlap with the metadata phase instead of delaying the first byte of the content.
+ *
+ * Connections are opened with the network access manager which will send the requests,
+ * otherwise they wouldn't be reused. Empty t_settingsName disables storing.
+ */
+class ConnectionWarmer
+{
+public:
+    ConnectionWarmer(const QString& t_settingsName);
+
+    static ConnectionWarmer& getInstance()
+    {
+        static ConnectionWarmer instance(defaultSettingsName);
+
+        return instance;
+    }
+
+    /**
+     * @brief rememberContentUrls
+     *
+     * Replaces the remembered content origins with the ones of t_urls (up to Config::connectionWarmupMaxContentHosts).
+     * Urls without a host are skipped.
+     */
+    void        rememberContentUrls(const QStringList& t_urls);
+
+    QList<QUrl> getContentOrigins() const;
+
+    /**
+     * @brief getWarmupOrigins
+     *
+     * @return
+     * Origins of the API servers followed by the remembered content origins, without duplicates.
+     */
+    QList<QUrl> getWarmupOrigins() const;
+
+    void        warmUp(QNetworkAccessManager& t_networkAccessManager) const;
+
+    const static QString defaultSettingsName;
+
+private:
+    mutable QMutex  m_mutex;
+    QString         m_settingsName;
+    QList<QUrl>     m_contentOrigins;
+
+    void load();
+    void save() const;
+
+    static QUrl getOrigin(const QString& t_url);
+};
+
+#endif // CONNECTIONWARMER_H
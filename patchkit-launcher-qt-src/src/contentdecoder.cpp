@@ -0,0 +1,172 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "contentdecoder.h"
+
+#include <zlib.h>
+
+#include "contentdecodingexception.h"
+
+const QByteArray ContentDecoder::acceptedEncodings = "gzip, deflate";
+
+ContentDecoder::ContentDecoder(const QByteArray& t_contentEncoding)
+    : m_stream(new z_stream_s())
+    , m_isInitialized(false)
+    , m_isFinished(false)
+{
+    bool isSupported;
+    m_encoding = parseEncoding(t_contentEncoding, isSupported);
+
+    if (!isSupported)
+    {
+        throw ContentDecodingException("Unsupported content encoding - " + t_contentEncoding.toStdString());
+    }
+
+    if (m_encoding == Gzip)
+    {
+        // +32 - gzip or zlib header is detected automatically.
+        initialize(MAX_WBITS + 32);
+    }
+}
+
+ContentDecoder::~ContentDecoder()
+{
+    if (m_isInitialized)
+    {
+        inflateEnd(m_stream.get());
+    }
+}
+
+bool ContentDecoder::isSupported(const QByteArray& t_contentEncoding)
+{
+    bool isSupported;
+    parseEncoding(t_contentEncoding, isSupported);
+
+    return isSupported;
+}
+
+bool ContentDecoder::isEncoded() const
+{
+    return m_encoding != Identity;
+}
+
+QByteArray ContentDecoder::decode(const QByteArray& t_data)
+{
+    if (m_encoding == Identity)
+    {
+        return t_data;
+    }
+
+    if (m_isInitialized)
+    {
+        return inflate(t_data);
+    }
+
+    // Deflate may come with or without the zlib header, it's known after the first two bytes.
+    m_header += t_data;
+
+    if (m_header.size() < 2)
+    {
+        return QByteArray();
+    }
+
+    unsigned char first = static_cast<unsigned char>(m_header[0]);
+    unsigned char second = static_cast<unsigned char>(m_header[1]);
+
+    bool hasZlibHeader = (first & 0x0f) == Z_DEFLATED && (first * 256 + second) % 31 == 0;
+
+    initialize(hasZlibHeader ? MAX_WBITS : -MAX_WBITS);
+
+    QByteArray data = m_header;
+    m_header.clear();
+
+    return inflate(data);
+}
+
+void ContentDecoder::finish()
+{
+    if (m_encoding != Identity && !m_isFinished)
+    {
+        throw ContentDecodingException("Encoded content is truncated.");
+    }
+}
+
+void ContentDecoder::initialize(int t_windowBits)
+{
+    if (inflateInit2(m_stream.get(), t_windowBits) != Z_OK)
+    {
+        throw ContentDecodingException("Couldn't initialize content decoder.");
+    }
+
+    m_isInitialized = true;
+}
+
+QByteArray ContentDecoder::inflate(const QByteArray& t_data)
+{
+    QByteArray result;
+
+    if (m_isFinished || t_data.isEmpty())
+    {
+        return result;
+    }
+
+    char buffer[16384];
+
+    m_stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(t_data.constData()));
+    m_stream->avail_in = static_cast<uInt>(t_data.size());
+
+    do
+    {
+        m_stream->next_out = reinterpret_cast<Bytef*>(buffer);
+        m_stream->avail_out = sizeof(buffer);
+
+        int status = ::inflate(m_stream.get(), Z_NO_FLUSH);
+
+        if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR)
+        {
+            throw ContentDecodingException("Couldn't decode encoded content.");
+        }
+
+        result.append(buffer, int(sizeof(buffer) - m_stream->avail_out));
+
+        if (status == Z_STREAM_END)
+        {
+            m_isFinished = true;
+        }
+        else if (status == Z_BUF_ERROR)
+        {
+            break;
+        }
+    }
+    while (!m_isFinished && (m_stream->avail_in > 0 || m_stream->avail_out == 0));
+
+    return result;
+}
+
+ContentDecoder::Encoding ContentDecoder::parseEncoding(const QByteArray& t_contentEncoding, bool& t_isSupported)
+{
+    QByteArray encoding = t_contentEncoding.trimmed().toLower();
+
+    t_isSupported = true;
+
+    if (encoding.isEmpty() || encoding == "identity")
+    {
+        return Identity;
+    }
+
+    if (encoding == "gzip" || encoding == "x-gzip")
+    {
+        return Gzip;
+    }
+
+    if (encoding == "deflate")
+    {
+        return Deflate;
+    }
+
+    t_isSupported = false;
+
+    return Identity;
+}
@@ -0,0 +1,67 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#ifndef CONTENTDECODER_H
+#define CONTENTDECODER_H
+
+#include <QByteArray>
+#include <memory>
+
+struct z_stream_s;
+
+/**
+ * @brief
+ * Decodes HTTP bodies sent with Content-Encoding gzip or deflate, as they arrive.
+ *
+ * @details
+ * Decoding is done with zlib. gzip and zlib wrapped deflate are detected from the stream header,
+ * raw deflate (sent by some servers as "deflate") is accepted as well.
+ * Bodies without Content-Encoding (or with identity) are passed through.
+ *
+ * Errors are reported with ContentDecodingException - from the constructor for an unsupported encoding,
+ * from decode() for corrupted data and from finish() for a truncated stream.
+ */
+class ContentDecoder
+{
+public:
+    ContentDecoder(const QByteArray& t_contentEncoding);
+    ~ContentDecoder();
+
+    ContentDecoder(const ContentDecoder&) = delete;
+    void operator=(const ContentDecoder&) = delete;
+
+    static bool isSupported(const QByteArray& t_contentEncoding);
+
+    bool        isEncoded() const;
+
+    QByteArray  decode(const QByteArray& t_data);
+
+    // Throws if the stream has ended before all of the content was decoded.
+    void        finish();
+
+    // Value of Accept-Encoding for requests whose replies go through the decoder.
+    const static QByteArray acceptedEncodings;
+
+private:
+    enum Encoding
+    {
+        Identity,
+        Gzip,
+        Deflate
+    };
+
+    Encoding                    m_encoding;
+    std::unique_ptr<z_stream_s> m_stream;
+    bool                        m_isInitialized;
+    bool                        m_isFinished;
+    QByteArray                  m_header;
+
+    void initialize(int t_windowBits);
+    QByteArray inflate(const QByteArray& t_data);
+
+    static Encoding parseEncoding(const QByteArray& t_contentEncoding, bool& t_isSupported);
+};
+
+#endif // CONTENTDECODER_H
@@ -0,0 +1,22 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#ifndef CONTENTDECODINGEXCEPTION_H
+#define CONTENTDECODINGEXCEPTION_H
+
+#include <stdexcept>
+#include <string>
+
+// Reply body couldn't be decoded - it's a fault of the server which sent it, not of the connection.
+class ContentDecodingException : public std::runtime_error
+{
+public:
+    ContentDecodingException(const std::string& t_message)
+        : std::runtime_error(t_message)
+    {
+    }
+};
+
+#endif // CONTENTDECODINGEXCEPTION_H
@@ -6,6 +6,7 @@
 #include "contentsummary.h"
 
 #include "logger.h"
+#include "contentsummaryparser.h"
 
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -13,6 +14,9 @@
 #include <QJsonArray>
 #include <QStringList>
 #include <QVariantList>
+#include <QtEndian>
+
+#include <cstring>
 
 const QString   ContentSummary::encryptionMethodToken   = QString("encryption_method");
 const QString   ContentSummary::compressionMethodToken  = QString("compression_method");
@@ -27,6 +31,52 @@ const QString   ContentSummary::sizeToken               = QString("size");
 
 const FileData& FileData::dummy = FileData("dummy", 0);
 
+const quint32   ContentSummary::binaryMagic             = 0x53434B50; // "PKCS"
+const quint32   ContentSummary::binaryFormatVersion     = 1;
+const int       ContentSummary::binaryHeaderSize        = 7 * 4;
+
+static void appendUInt32(QByteArray& t_data, quint32 t_value)
+{
+    uchar bytes[4];
+    qToLittleEndian(t_value, bytes);
+
+    t_data.append(reinterpret_cast<const char*>(bytes), 4);
+}
+
+static void appendString(QByteArray& t_data, const QString& t_value)
+{
+    QByteArray utf8 = t_value.toUtf8();
+
+    appendUInt32(t_data, quint32(utf8.size()));
+    t_data.append(utf8);
+}
+
+static quint32 readUInt32(const char* t_data)
+{
+    return qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(t_data));
+}
+
+static bool readString(const char*& t_position, const char* t_end, QString& t_value)
+{
+    if (t_end - t_position < 4)
+    {
+        return false;
+    }
+
+    quint32 length = readUInt32(t_position);
+    t_position += 4;
+
+    if (quint64(t_end - t_position) < length)
+    {
+        return false;
+    }
+
+    t_value = QString::fromUtf8(t_position, int(length));
+    t_position += length;
+
+    return true;
+}
+
 ContentSummary::ContentSummary()
     : m_isValid(false)
 {
@@ -37,7 +87,8 @@ ContentSummary::ContentSummary(int t_chunkSize, THash t_hashCode
                                , QString t_compressionMethod
                                , QString t_hashingMethod, QVector<THash> t_chunkHashes
                                , QVector<FileData> t_filesSummary)
-    : m_chunkSize(t_chunkSize)
+    : m_isValid(true)
+    , m_chunkSize(t_chunkSize)
     , m_hashCode(t_hashCode)
     , m_encryptionMethod(t_encryptionMethod)
     , m_compressionMethod(t_compressionMethod)
@@ -47,6 +98,13 @@ ContentSummary::ContentSummary(int t_chunkSize, THash t_hashCode
 {
 }
 
+ContentSummary ContentSummary::fromJson(const QByteArray& t_json)
+{
+    ContentSummaryParser parser(t_json);
+
+    return parser.parse();
+}
+
 ContentSummary::ContentSummary(const QJsonDocument& t_document)
     : m_isValid(false)
 {
@@ -226,6 +284,136 @@ QJsonDocument ContentSummary::toJson() const
     return QJsonDocument(root);
 }
 
+QByteArray ContentSummary::toBinary() const
+{
+    QByteArray strings;
+
+    appendString(strings, m_encryptionMethod);
+    appendString(strings, m_compressionMethod);
+    appendString(strings, m_hashingMethod);
+
+    for (const FileData& fileData : m_filesSummary)
+    {
+        appendUInt32(strings, fileData.hash);
+        appendString(strings, fileData.path);
+    }
+
+    QByteArray data;
+    data.reserve(binaryHeaderSize + m_chunkHashes.size() * 4 + strings.size() + 4);
+
+    appendUInt32(data, binaryMagic);
+    appendUInt32(data, binaryFormatVersion);
+    appendUInt32(data, quint32(m_chunkSize));
+    appendUInt32(data, m_hashCode);
+    appendUInt32(data, quint32(m_chunkHashes.size()));
+    appendUInt32(data, quint32(m_filesSummary.size()));
+    appendUInt32(data, quint32(strings.size()));
+
+    for (THash hash : m_chunkHashes)
+    {
+        appendUInt32(data, hash);
+    }
+
+    data.append(strings);
+
+    appendUInt32(data, HashingStrategy::xxHash(data));
+
+    return data;
+}
+
+ContentSummary ContentSummary::fromBinary(const QByteArray& t_data)
+{
+    return fromBinary(t_data.constData(), t_data.size());
+}
+
+ContentSummary ContentSummary::fromBinary(const char* t_data, qint64 t_size)
+{
+    if (t_size < binaryHeaderSize + 4)
+    {
+        return ContentSummary();
+    }
+
+    qint64 checkedSize = t_size - 4;
+
+    if (XXH32(t_data, size_t(checkedSize), HashingStrategy::xxHashSeed) != readUInt32(t_data + checkedSize))
+    {
+        return ContentSummary();
+    }
+
+    if (readUInt32(t_data) != binaryMagic || readUInt32(t_data + 4) != binaryFormatVersion)
+    {
+        return ContentSummary();
+    }
+
+    quint32 chunksCount = readUInt32(t_data + 16);
+    quint32 filesCount = readUInt32(t_data + 20);
+    quint32 stringsSize = readUInt32(t_data + 24);
+
+    if (quint64(binaryHeaderSize) + quint64(chunksCount) * 4 + stringsSize != quint64(checkedSize))
+    {
+        return ContentSummary();
+    }
+
+    ContentSummary summary;
+    summary.m_chunkSize = int(readUInt32(t_data + 8));
+    summary.m_hashCode = readUInt32(t_data + 12);
+
+    const char* position = t_data + binaryHeaderSize;
+
+    summary.m_chunkHashes.resize(int(chunksCount));
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    std::memcpy(summary.m_chunkHashes.data(), position, chunksCount * 4);
+#else
+    for (quint32 i = 0; i < chunksCount; i++)
+    {
+        summary.m_chunkHashes[int(i)] = readUInt32(position + i * 4);
+    }
+#endif
+
+    position += chunksCount * 4;
+
+    const char* end = t_data + checkedSize;
+
+    if (!readString(position, end, summary.m_encryptionMethod)
+        || !readString(position, end, summary.m_compressionMethod)
+        || !readString(position, end, summary.m_hashingMethod))
+    {
+        return ContentSummary();
+    }
+
+    summary.m_filesSummary.reserve(int(qMin<quint64>(filesCount, quint64(end - position) / 8)));
+
+    for (quint32 i = 0; i < filesCount; i++)
+    {
+        FileData fileData;
+
+        if (end - position < 4)
+        {
+            return ContentSummary();
+        }
+
+        fileData.hash = readUInt32(position);
+        position += 4;
+
+        if (!readString(position, end, fileData.path))
+        {
+            return ContentSummary();
+        }
+
+        summary.m_filesSummary.append(fileData);
+    }
+
+    if (position != end)
+    {
+        return ContentSummary();
+    }
+
+    summary.m_isValid = true;
+
+    return summary;
+}
+
 bool ContentSummary::parseFiles(QJsonObject& t_document)
 {
     if (!t_document.contains(filesToken))
@@ -243,13 +431,15 @@ bool ContentSummary::parseFiles(QJsonObject& t_document)
             return false;
         }
 
-        if (!(f.toObject().contains(hashToken) && f.toObject().contains(pathToken)))
+        QJsonObject file = f.toObject();
+
+        if (!(file.contains(hashToken) && file.contains(pathToken)))
         {
             return false;
         }
 
-        QString path = f.toObject()[pathToken].toString();
-        THash hash = f.toObject()[hashToken].toString().toUInt(&ok, 16);
+        QString path = file[pathToken].toString();
+        THash hash = file[hashToken].toString().toUInt(&ok, 16);
 
         if (!ok)
         {
@@ -297,6 +487,7 @@ bool ContentSummary::parseChunks(QJsonObject& t_document)
     }
 
     QVector<THash> hash_list;
+    hash_list.reserve(hashes.size());
 
     bool ok;
     for (QJsonValueRef item : hashes)
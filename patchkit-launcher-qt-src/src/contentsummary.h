@@ -57,6 +57,16 @@ public:
     ContentSummary(const QJsonDocument& t_document);
     ContentSummary();
 
+    /**
+     * @brief fromJson
+     *
+     * Parses the JSON bytes directly, without building a QJsonDocument. Much faster for large summaries.
+     *
+     * @return
+     * Invalid content summary if the JSON can't be parsed.
+     */
+    static ContentSummary fromJson(const QByteArray& t_json);
+
     ContentSummary(int t_chunkSize, THash t_hashCode, QString t_encryptionMethod
                    , QString t_compressionMethod, QString t_hashingMethod
                    , QVector<THash> t_chunkHashes, QVector<FileData> t_filesSummary);
@@ -98,7 +108,33 @@ public:
 
     QJsonDocument   toJson() const;
 
+    /**
+     * @brief toBinary
+     *
+     * Serializes the summary to a compact little-endian binary format:
+     * a header (magic, format version, chunk size, hash code, chunks count, files count, strings size),
+     * chunk hashes as a contiguous array of 32-bit values, length-prefixed UTF-8 method names and file entries,
+     * followed by a xxHash checksum of everything before it.
+     */
+    QByteArray      toBinary() const;
+
+    /**
+     * @brief fromBinary
+     *
+     * Reads a summary written by toBinary, t_data may point to a memory mapped file.
+     * Chunk hashes are copied with a single allocation.
+     *
+     * @return
+     * Invalid content summary if the data is truncated, corrupted or of a different format version.
+     */
+    static ContentSummary fromBinary(const char* t_data, qint64 t_size);
+    static ContentSummary fromBinary(const QByteArray& t_data);
+
 private:
+    const static quint32 binaryMagic;
+    const static quint32 binaryFormatVersion;
+    const static int     binaryHeaderSize;
+
     bool parseFiles(QJsonObject& t_document);
     bool parseChunks(QJsonObject& t_document);
 
@@ -0,0 +1,94 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "contentsummarycache.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QCryptographicHash>
+
+#include "logger.h"
+#include "ioutils.h"
+
+ContentSummaryCache::ContentSummaryCache(const QString& t_dirPath, int t_maxEntries)
+    : m_dirPath(t_dirPath)
+    , m_maxEntries(t_maxEntries)
+{
+}
+
+ContentSummary ContentSummaryCache::load(const QString& t_patcherSecret, int t_version) const
+{
+    QFile file(filePath(t_patcherSecret, t_version));
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return ContentSummary();
+    }
+
+    ContentSummary summary;
+    uchar* data = file.map(0, file.size());
+
+    if (data)
+    {
+        summary = ContentSummary::fromBinary(reinterpret_cast<const char*>(data), file.size());
+        file.unmap(data);
+    }
+    else
+    {
+        summary = ContentSummary::fromBinary(file.readAll());
+    }
+
+    if (!summary.isValid())
+    {
+        logWarning("Cached content summary is damaged, removing it.");
+        file.close();
+        file.remove();
+    }
+
+    return summary;
+}
+
+void ContentSummaryCache::store(const QString& t_patcherSecret, int t_version, const ContentSummary& t_summary) const
+{
+    IOUtils::createDir(m_dirPath);
+
+    // Written under a temporary name and renamed, so a half written file is never loaded.
+    QSaveFile file(filePath(t_patcherSecret, t_version));
+
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        logWarning("Couldn't write content summary to the cache.");
+        return;
+    }
+
+    file.write(t_summary.toBinary());
+
+    if (!file.commit())
+    {
+        logWarning("Couldn't write content summary to the cache.");
+        return;
+    }
+
+    removeOldEntries();
+}
+
+QString ContentSummaryCache::filePath(const QString& t_patcherSecret, int t_version) const
+{
+    // Secret isn't stored on disk in plain text.
+    QByteArray secretHash = QCryptographicHash::hash(t_patcherSecret.toUtf8(), QCryptographicHash::Sha1).toHex().left(16);
+
+    return QDir::cleanPath(m_dirPath + "/" + QString::fromLatin1(secretHash) + "_" + QString::number(t_version) + ".bin");
+}
+
+void ContentSummaryCache::removeOldEntries() const
+{
+    QFileInfoList entries = QDir(m_dirPath).entryInfoList(QStringList("*.bin"), QDir::Files, QDir::Time);
+
+    for (int i = m_maxEntries; i < entries.size(); i++)
+    {
+        QFile::remove(entries[i].absoluteFilePath());
+    }
+}
@@ -0,0 +1,44 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#ifndef CONTENTSUMMARYCACHE_H
+#define CONTENTSUMMARYCACHE_H
+
+#include <QString>
+
+#include "contentsummary.h"
+
+/**
+ * @brief
+ * On-disk cache of content summaries in the binary format, keyed by patcher and version.
+ *
+ * @details
+ * Content summary of a version never changes, so a cached summary is used instead of downloading it again.
+ * Cache files are memory mapped when loaded. Only the most recently stored summaries are kept.
+ */
+class ContentSummaryCache
+{
+public:
+    ContentSummaryCache(const QString& t_dirPath, int t_maxEntries);
+
+    /**
+     * @brief load
+     *
+     * @return
+     * Cached summary, invalid if there is none or the cache file is damaged.
+     */
+    ContentSummary load(const QString& t_patcherSecret, int t_version) const;
+
+    void store(const QString& t_patcherSecret, int t_version, const ContentSummary& t_summary) const;
+
+private:
+    QString m_dirPath;
+    int     m_maxEntries;
+
+    QString filePath(const QString& t_patcherSecret, int t_version) const;
+    void    removeOldEntries() const;
+};
+
+#endif // CONTENTSUMMARYCACHE_H
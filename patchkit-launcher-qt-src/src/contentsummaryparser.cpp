@@ -0,0 +1,888 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "contentsummaryparser.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+const int ContentSummaryParser::maxDepth = 64;
+
+static bool isDigit(char t_character)
+{
+    return t_character >= '0' && t_character <= '9';
+}
+
+static void skipDigits(const char*& t_position, const char* t_end)
+{
+    while (t_position < t_end && isDigit(*t_position))
+    {
+        t_position++;
+    }
+}
+
+static bool isContinuationByte(const char* t_position, const char* t_end, unsigned char t_min = 0x80, unsigned char t_max = 0xBF)
+{
+    if (t_position >= t_end)
+    {
+        return false;
+    }
+
+    unsigned char byte = static_cast<unsigned char>(*t_position);
+
+    return byte >= t_min && byte <= t_max;
+}
+
+// Skips a multibyte UTF-8 character. Overlong forms, surrogates and code points above U+10FFFF are invalid,
+// QJsonDocument rejects them as well.
+static bool skipUtf8Character(const char*& t_position, const char* t_end)
+{
+    unsigned char lead = static_cast<unsigned char>(*t_position);
+
+    int length;
+    unsigned char min = 0x80;
+    unsigned char max = 0xBF;
+
+    if (lead >= 0xC2 && lead <= 0xDF)
+    {
+        length = 2;
+    }
+    else if (lead >= 0xE0 && lead <= 0xEF)
+    {
+        length = 3;
+        min = lead == 0xE0 ? 0xA0 : 0x80;
+        max = lead == 0xED ? 0x9F : 0xBF;
+    }
+    else if (lead >= 0xF0 && lead <= 0xF4)
+    {
+        length = 4;
+        min = lead == 0xF0 ? 0x90 : 0x80;
+        max = lead == 0xF4 ? 0x8F : 0xBF;
+    }
+    else
+    {
+        return false;
+    }
+
+    if (!isContinuationByte(t_position + 1, t_end, min, max))
+    {
+        return false;
+    }
+
+    for (int i = 2; i < length; i++)
+    {
+        if (!isContinuationByte(t_position + i, t_end))
+        {
+            return false;
+        }
+    }
+
+    t_position += length;
+    return true;
+}
+
+ContentSummaryParser::ContentSummaryParser(const QByteArray& t_json)
+    : m_position(t_json.constData())
+    , m_end(t_json.constData() + t_json.size())
+    , m_encryptionMethodToken(ContentSummary::encryptionMethodToken.toLatin1())
+    , m_compressionMethodToken(ContentSummary::compressionMethodToken.toLatin1())
+    , m_hashingMethodToken(ContentSummary::hashingMethodToken.toLatin1())
+    , m_hashCodeToken(ContentSummary::hashCodeToken.toLatin1())
+    , m_filesToken(ContentSummary::filesToken.toLatin1())
+    , m_hashesToken(ContentSummary::hashesToken.toLatin1())
+    , m_hashToken(ContentSummary::hashToken.toLatin1())
+    , m_pathToken(ContentSummary::pathToken.toLatin1())
+    , m_chunksToken(ContentSummary::chunksToken.toLatin1())
+    , m_sizeToken(ContentSummary::sizeToken.toLatin1())
+{
+}
+
+ContentSummary ContentSummaryParser::parse()
+{
+    QString encryptionMethod;
+    QString compressionMethod;
+    QString hashingMethod;
+    THash hashCode = 0;
+    int chunkSize = -1;
+    QVector<THash> chunkHashes;
+    QVector<FileData> files;
+
+    bool hasEncryptionMethod = false;
+    bool hasCompressionMethod = false;
+    bool hasHashingMethod = false;
+    bool hasHashCode = false;
+    bool hasFiles = false;
+    bool hasChunks = false;
+
+    bool isHashCodeValid = false;
+    bool areFilesValid = false;
+    bool areChunksValid = false;
+
+    if (!consume('{'))
+    {
+        return ContentSummary();
+    }
+
+    if (!consume('}'))
+    {
+        do
+        {
+            QByteArray key;
+
+            if (!readKey(key) || !consume(':'))
+            {
+                return ContentSummary();
+            }
+
+            bool ok;
+
+            // Method names which aren't strings are read as empty strings, just like QJsonValue::toString does.
+            if (key == m_encryptionMethodToken)
+            {
+                ok = isNext('"') ? readString(encryptionMethod) : skipValue();
+                hasEncryptionMethod = true;
+            }
+            else if (key == m_compressionMethodToken)
+            {
+                ok = isNext('"') ? readString(compressionMethod) : skipValue();
+                hasCompressionMethod = true;
+            }
+            else if (key == m_hashingMethodToken)
+            {
+                ok = isNext('"') ? readString(hashingMethod) : skipValue();
+                hasHashingMethod = true;
+            }
+            else if (key == m_hashCodeToken)
+            {
+                ok = readHash(hashCode, isHashCodeValid);
+                hasHashCode = true;
+            }
+            else if (key == m_filesToken)
+            {
+                ok = parseFiles(files, areFilesValid);
+                hasFiles = true;
+            }
+            else if (key == m_chunksToken)
+            {
+                ok = parseChunks(chunkSize, chunkHashes, areChunksValid);
+                hasChunks = true;
+            }
+            else
+            {
+                ok = skipValue();
+            }
+
+            if (!ok)
+            {
+                return ContentSummary();
+            }
+        }
+        while (consume(','));
+
+        if (!consume('}'))
+        {
+            return ContentSummary();
+        }
+    }
+
+    skipWhitespace();
+
+    if (m_position != m_end)
+    {
+        return ContentSummary();
+    }
+
+    if (!hasEncryptionMethod || !hasCompressionMethod || !hasHashingMethod
+        || !hasHashCode || !hasFiles || !hasChunks
+        || !isHashCodeValid || !areFilesValid || !areChunksValid)
+    {
+        return ContentSummary();
+    }
+
+    return ContentSummary(chunkSize, hashCode, encryptionMethod, compressionMethod, hashingMethod, chunkHashes, files);
+}
+
+bool ContentSummaryParser::parseFiles(QVector<FileData>& t_files, bool& t_isValid)
+{
+    t_files.clear();
+    t_isValid = true;
+
+    // Files which aren't an array are read as no files, just like QJsonValue::toArray does.
+    if (!isNext('['))
+    {
+        return skipValue();
+    }
+
+    consume('[');
+
+    if (consume(']'))
+    {
+        return true;
+    }
+
+    do
+    {
+        bool ok;
+
+        if (isNext('{'))
+        {
+            ok = parseFile(t_files, t_isValid);
+        }
+        else
+        {
+            ok = skipValue();
+            t_isValid = false;
+        }
+
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    while (consume(','));
+
+    return consume(']');
+}
+
+bool ContentSummaryParser::parseFile(QVector<FileData>& t_files, bool& t_isValid)
+{
+    if (!consume('{'))
+    {
+        return false;
+    }
+
+    QString path;
+    THash hash = 0;
+
+    bool hasPath = false;
+    bool hasHash = false;
+    bool isHashValid = false;
+
+    if (!consume('}'))
+    {
+        do
+        {
+            QByteArray key;
+
+            if (!readKey(key) || !consume(':'))
+            {
+                return false;
+            }
+
+            bool ok;
+
+            if (key == m_pathToken)
+            {
+                ok = isNext('"') ? readString(path) : skipValue();
+                hasPath = true;
+            }
+            else if (key == m_hashToken)
+            {
+                ok = readHash(hash, isHashValid);
+                hasHash = true;
+            }
+            else
+            {
+                ok = skipValue();
+            }
+
+            if (!ok)
+            {
+                return false;
+            }
+        }
+        while (consume(','));
+
+        if (!consume('}'))
+        {
+            return false;
+        }
+    }
+
+    if (!hasPath || !hasHash || !isHashValid)
+    {
+        t_isValid = false;
+        return true;
+    }
+
+    t_files.append(FileData(path, hash));
+
+    return true;
+}
+
+bool ContentSummaryParser::parseChunks(int& t_chunkSize, QVector<THash>& t_chunkHashes, bool& t_isValid)
+{
+    t_chunkSize = -1;
+    t_chunkHashes.clear();
+    t_isValid = false;
+
+    // Chunks which aren't an object are read as an empty object, just like QJsonValue::toObject does.
+    if (!isNext('{'))
+    {
+        return skipValue();
+    }
+
+    consume('{');
+
+    bool hasHashes = false;
+    bool areHashesValid = false;
+
+    if (!consume('}'))
+    {
+        do
+        {
+            QByteArray key;
+
+            if (!readKey(key) || !consume(':'))
+            {
+                return false;
+            }
+
+            bool ok;
+
+            if (key == m_sizeToken)
+            {
+                ok = readInt(t_chunkSize);
+            }
+            else if (key == m_hashesToken)
+            {
+                ok = parseHashes(t_chunkHashes, areHashesValid);
+                hasHashes = true;
+            }
+            else
+            {
+                ok = skipValue();
+            }
+
+            if (!ok)
+            {
+                return false;
+            }
+        }
+        while (consume(','));
+
+        if (!consume('}'))
+        {
+            return false;
+        }
+    }
+
+    t_isValid = t_chunkSize != -1 && hasHashes && areHashesValid && !t_chunkHashes.isEmpty();
+
+    return true;
+}
+
+bool ContentSummaryParser::parseHashes(QVector<THash>& t_chunkHashes, bool& t_isValid)
+{
+    t_chunkHashes.clear();
+    t_isValid = true;
+
+    // Hashes which aren't an array are read as no hashes, just like QJsonValue::toArray does.
+    if (!isNext('['))
+    {
+        return skipValue();
+    }
+
+    consume('[');
+
+    t_chunkHashes.reserve(countArrayElements());
+
+    if (consume(']'))
+    {
+        return true;
+    }
+
+    do
+    {
+        THash hash = 0;
+        bool isHashValid = false;
+        bool ok;
+
+        if (isNext('"'))
+        {
+            ok = readHash(hash, isHashValid);
+        }
+        else
+        {
+            ok = skipValue();
+        }
+
+        if (!ok)
+        {
+            return false;
+        }
+
+        t_isValid = t_isValid && isHashValid;
+        t_chunkHashes.append(hash);
+    }
+    while (consume(','));
+
+    return consume(']');
+}
+
+bool ContentSummaryParser::readKey(QByteArray& t_key)
+{
+    const char* begin;
+    const char* end;
+    bool hasEscapes;
+
+    if (!readRawString(begin, end, hasEscapes))
+    {
+        return false;
+    }
+
+    if (!hasEscapes)
+    {
+        t_key = QByteArray::fromRawData(begin, int(end - begin));
+        return true;
+    }
+
+    QString key;
+
+    if (!unescape(begin, end, key))
+    {
+        return false;
+    }
+
+    t_key = key.toUtf8();
+    return true;
+}
+
+bool ContentSummaryParser::readString(QString& t_value)
+{
+    const char* begin;
+    const char* end;
+    bool hasEscapes;
+
+    if (!readRawString(begin, end, hasEscapes))
+    {
+        return false;
+    }
+
+    if (!hasEscapes)
+    {
+        t_value = QString::fromUtf8(begin, int(end - begin));
+        return true;
+    }
+
+    return unescape(begin, end, t_value);
+}
+
+bool ContentSummaryParser::readRawString(const char*& t_begin, const char*& t_end, bool& t_hasEscapes)
+{
+    if (!consume('"'))
+    {
+        return false;
+    }
+
+    t_begin = m_position;
+    t_hasEscapes = false;
+
+    while (m_position < m_end)
+    {
+        char character = *m_position;
+
+        if (character == '"')
+        {
+            t_end = m_position;
+            m_position++;
+            return true;
+        }
+
+        if (character == '\\')
+        {
+            if (m_end - m_position < 2)
+            {
+                return false;
+            }
+
+            t_hasEscapes = true;
+            m_position += 2;
+            continue;
+        }
+
+        if (static_cast<unsigned char>(character) < 0x20)
+        {
+            return false;
+        }
+
+        if (static_cast<unsigned char>(character) >= 0x80)
+        {
+            if (!skipUtf8Character(m_position, m_end))
+            {
+                return false;
+            }
+
+            continue;
+        }
+
+        m_position++;
+    }
+
+    return false;
+}
+
+bool ContentSummaryParser::readHash(THash& t_hash, bool& t_isValid)
+{
+    // Hashes which aren't strings are read as empty strings, which aren't valid hex numbers.
+    if (!isNext('"'))
+    {
+        t_isValid = false;
+        return skipValue();
+    }
+
+    const char* begin = m_position;
+
+    m_position++;
+
+    quint64 value = 0;
+    int digitsCount = 0;
+
+    while (m_position < m_end && *m_position != '"')
+    {
+        char character = *m_position;
+        int digit;
+
+        if (character >= '0' && character <= '9')
+        {
+            digit = character - '0';
+        }
+        else if (character >= 'a' && character <= 'f')
+        {
+            digit = character - 'a' + 10;
+        }
+        else if (character >= 'A' && character <= 'F')
+        {
+            digit = character - 'A' + 10;
+        }
+        else
+        {
+            break;
+        }
+
+        value = value * 16 + digit;
+
+        if (value > 0xFFFFFFFFull)
+        {
+            break;
+        }
+
+        digitsCount++;
+        m_position++;
+    }
+
+    if (m_position < m_end && *m_position == '"' && digitsCount > 0)
+    {
+        m_position++;
+
+        t_hash = THash(value);
+        t_isValid = true;
+        return true;
+    }
+
+    // Anything but plain hex digits - whitespace, a "0x" prefix, a sign, escapes or an overflow - is left
+    // to QString::toUInt, which is what ContentSummary(const QJsonDocument&) uses.
+    m_position = begin;
+
+    QString string;
+
+    if (!readString(string))
+    {
+        return false;
+    }
+
+    t_hash = string.toUInt(&t_isValid, 16);
+    return true;
+}
+
+bool ContentSummaryParser::readInt(int& t_value)
+{
+    // Values which aren't integral numbers in the int range are read as -1, just like QJsonValue::toInt(-1) does.
+    t_value = -1;
+
+    skipWhitespace();
+
+    if (m_position == m_end || (*m_position != '-' && !isDigit(*m_position)))
+    {
+        return skipValue();
+    }
+
+    double value;
+
+    if (!readNumber(value))
+    {
+        return false;
+    }
+
+    if (value >= double(std::numeric_limits<int>::min())
+        && value <= double(std::numeric_limits<int>::max())
+        && double(int(value)) == value)
+    {
+        t_value = int(value);
+    }
+
+    return true;
+}
+
+bool ContentSummaryParser::readNumber(double& t_value)
+{
+    skipWhitespace();
+
+    const char* begin = m_position;
+
+    // Numbers are scanned the way QJsonDocument scans them, so a leading zero ends the number
+    // and the digits after it are rejected by the caller.
+    if (m_position < m_end && *m_position == '-')
+    {
+        m_position++;
+    }
+
+    if (m_position == m_end || !isDigit(*m_position))
+    {
+        return false;
+    }
+
+    if (*m_position == '0')
+    {
+        m_position++;
+    }
+    else
+    {
+        skipDigits(m_position, m_end);
+    }
+
+    if (m_position < m_end && *m_position == '.')
+    {
+        m_position++;
+        skipDigits(m_position, m_end);
+    }
+
+    if (m_position < m_end && (*m_position == 'e' || *m_position == 'E'))
+    {
+        m_position++;
+
+        if (m_position < m_end && (*m_position == '-' || *m_position == '+'))
+        {
+            m_position++;
+        }
+
+        skipDigits(m_position, m_end);
+    }
+
+    bool ok;
+    t_value = QByteArray(begin, int(m_position - begin)).toDouble(&ok);
+
+    return ok;
+}
+
+bool ContentSummaryParser::skipValue(int t_depth)
+{
+    if (t_depth > maxDepth)
+    {
+        return false;
+    }
+
+    skipWhitespace();
+
+    if (m_position == m_end)
+    {
+        return false;
+    }
+
+    switch (*m_position)
+    {
+    case '"':
+    {
+        const char* begin;
+        const char* end;
+        bool hasEscapes;
+
+        return readRawString(begin, end, hasEscapes);
+    }
+    case '{':
+    {
+        m_position++;
+
+        if (consume('}'))
+        {
+            return true;
+        }
+
+        do
+        {
+            QByteArray key;
+
+            if (!readKey(key) || !consume(':') || !skipValue(t_depth + 1))
+            {
+                return false;
+            }
+        }
+        while (consume(','));
+
+        return consume('}');
+    }
+    case '[':
+    {
+        m_position++;
+
+        if (consume(']'))
+        {
+            return true;
+        }
+
+        do
+        {
+            if (!skipValue(t_depth + 1))
+            {
+                return false;
+            }
+        }
+        while (consume(','));
+
+        return consume(']');
+    }
+    case 't':
+    case 'f':
+    case 'n':
+    {
+        for (const char* literal : {"true", "false", "null"})
+        {
+            int length = int(std::strlen(literal));
+
+            if (m_end - m_position >= length && std::strncmp(m_position, literal, length) == 0)
+            {
+                m_position += length;
+                return true;
+            }
+        }
+
+        return false;
+    }
+    default:
+    {
+        double value;
+        return readNumber(value);
+    }
+    }
+}
+
+void ContentSummaryParser::skipWhitespace()
+{
+    while (m_position < m_end && (*m_position == ' ' || *m_position == '\n' || *m_position == '\r' || *m_position == '\t'))
+    {
+        m_position++;
+    }
+}
+
+bool ContentSummaryParser::consume(char t_character)
+{
+    if (!isNext(t_character))
+    {
+        return false;
+    }
+
+    m_position++;
+    return true;
+}
+
+bool ContentSummaryParser::isNext(char t_character)
+{
+    skipWhitespace();
+
+    return m_position < m_end && *m_position == t_character;
+}
+
+int ContentSummaryParser::countArrayElements() const
+{
+    // Hashes are plain hex strings, so the closing bracket can be found without parsing them.
+    const char* arrayEnd = static_cast<const char*>(std::memchr(m_position, ']', size_t(m_end - m_position)));
+
+    if (arrayEnd == nullptr)
+    {
+        return 0;
+    }
+
+    return int(std::count(m_position, arrayEnd, ',')) + 1;
+}
+
+bool ContentSummaryParser::unescape(const char* t_begin, const char* t_end, QString& t_value)
+{
+    t_value.clear();
+    t_value.reserve(int(t_end - t_begin));
+
+    const char* run = t_begin;
+    const char* position = t_begin;
+
+    while (position < t_end)
+    {
+        if (*position != '\\')
+        {
+            position++;
+            continue;
+        }
+
+        t_value += QString::fromUtf8(run, int(position - run));
+
+        position++;
+
+        switch (*position)
+        {
+        case '"':
+            t_value += QChar('"');
+            break;
+        case '\\':
+            t_value += QChar('\\');
+            break;
+        case '/':
+            t_value += QChar('/');
+            break;
+        case 'b':
+            t_value += QChar('\b');
+            break;
+        case 'f':
+            t_value += QChar('\f');
+            break;
+        case 'n':
+            t_value += QChar('\n');
+            break;
+        case 'r':
+            t_value += QChar('\r');
+            break;
+        case 't':
+            t_value += QChar('\t');
+            break;
+        case 'u':
+        {
+            if (t_end - position < 5)
+            {
+                return false;
+            }
+
+            bool ok;
+            ushort code = QByteArray(position + 1, 4).toUShort(&ok, 16);
+
+            if (!ok)
+            {
+                return false;
+            }
+
+            // Surrogate pairs are two escapes, appending both code units forms the pair.
+            t_value += QChar(code);
+            position += 4;
+            break;
+        }
+        default:
+            return false;
+        }
+
+        position++;
+        run = position;
+    }
+
+    t_value += QString::fromUtf8(run, int(t_end - run));
+
+    return true;
+}
@@ -0,0 +1,79 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#ifndef CONTENTSUMMARYPARSER_H
+#define CONTENTSUMMARYPARSER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include "contentsummary.h"
+
+/**
+ * @brief
+ * Parses Content Summary JSON straight from the downloaded bytes.
+ *
+ * @details
+ * The parser walks the document once without building a QJsonDocument. Chunk hashes
+ * are decoded from hex digits directly into a QVector reserved up front, which is what matters
+ * for summaries of archives with hundreds of thousands of chunks. Unknown keys are skipped.
+ *
+ * It accepts the same documents as ContentSummary(const QJsonDocument&), use ContentSummary::fromJson.
+ * That's why a value which doesn't make the summary valid doesn't fail the parse on its own - as in QJsonObject,
+ * the last of duplicated keys wins, so it's only checked once the whole document is read.
+ */
+class ContentSummaryParser
+{
+public:
+    ContentSummaryParser(const QByteArray& t_json);
+
+    /**
+     * @brief parse
+     *
+     * @return
+     * Parsed content summary, invalid if the JSON is malformed or misses a required value.
+     */
+    ContentSummary parse();
+
+private:
+    const static int maxDepth;
+
+    const char* m_position;
+    const char* m_end;
+
+    QByteArray m_encryptionMethodToken;
+    QByteArray m_compressionMethodToken;
+    QByteArray m_hashingMethodToken;
+    QByteArray m_hashCodeToken;
+    QByteArray m_filesToken;
+    QByteArray m_hashesToken;
+    QByteArray m_hashToken;
+    QByteArray m_pathToken;
+    QByteArray m_chunksToken;
+    QByteArray m_sizeToken;
+
+    bool parseFiles(QVector<FileData>& t_files, bool& t_isValid);
+    bool parseFile(QVector<FileData>& t_files, bool& t_isValid);
+    bool parseChunks(int& t_chunkSize, QVector<THash>& t_chunkHashes, bool& t_isValid);
+    bool parseHashes(QVector<THash>& t_chunkHashes, bool& t_isValid);
+
+    bool readKey(QByteArray& t_key);
+    bool readString(QString& t_value);
+    bool readRawString(const char*& t_begin, const char*& t_end, bool& t_hasEscapes);
+    bool readHash(THash& t_hash, bool& t_isValid);
+    bool readInt(int& t_value);
+    bool readNumber(double& t_value);
+    bool skipValue(int t_depth = 0);
+
+    void skipWhitespace();
+    bool consume(char t_character);
+    bool isNext(char t_character);
+    int  countArrayElements() const;
+
+    static bool unescape(const char* t_begin, const char* t_end, QString& t_value);
+};
+
+#endif // CONTENTSUMMARYPARSER_H
@@ -8,10 +8,20 @@
 #include "logger.h"
 #include "timeoutexception.h"
 #include "config.h"
+#include "timeoutestimator.h"
+#include "telemetry.h"
+#include "mirrorcapabilities.h"
+#include "options.h"
+#include "contentdecoder.h"
+
+// Time is kept on the reply, so that it's measured for every reply separately.
+static const char* const issuedAtProperty = "telemetryIssuedAtMsec";
+static const char* const timeToFirstByteProperty = "telemetryTimeToFirstByteMsec";
 
 Downloader::Downloader(QNetworkAccessManager* t_dataSource, CancellationToken& t_cancellationToken)
     : m_remoteDataSource(t_dataSource)
     , m_cancellationToken(t_cancellationToken)
+    , m_priority(RateLimiter::Foreground)
 {
 }
 
@@ -22,12 +32,47 @@ QByteArray Downloader::downloadFile(const QString& t_urlPath, int t_requestTimeo
     return downloadFile(request, t_requestTimeoutMsec, t_replyStatusCode);
 }
 
+void Downloader::downloadFile(const QString& t_urlPath, QIODevice& t_target, int t_requestTimeoutMsec, int* t_replyStatusCode)
+{
+    QNetworkRequest request(t_urlPath);
+
+    const auto sink = [&t_target](const QByteArray& t_data) -> bool
+    {
+        if (t_target.write(t_data) != t_data.size())
+        {
+            throw std::runtime_error("Couldn't write downloaded data.");
+        }
+
+        return true;
+    };
+
+    downloadFile(request, sink, t_requestTimeoutMsec, t_replyStatusCode);
+}
+
 QByteArray Downloader::downloadFile(const QNetworkRequest& t_request, int t_requestTimeoutMsec, int* t_replyStatusCode)
+{
+    QByteArray data;
+
+    const auto sink = [&data](const QByteArray& t_data) -> bool
+    {
+        data += t_data;
+        return true;
+    };
+
+    downloadFile(t_request, sink, t_requestTimeoutMsec, t_replyStatusCode);
+
+    return data;
+}
+
+void Downloader::downloadFile(const QNetworkRequest& t_request, const TDataSink& t_sink, int t_requestTimeoutMsec, int* t_replyStatusCode)
 {
     TRemoteDataReply reply;
 
     fetchReply(t_request, reply);
 
+    // Bounded read buffer makes Qt stop reading from the socket when the rate limiter holds the data back.
+    reply->setReadBufferSize(Config::downloadReadBufferSize);
+
     connect(reply.data(), &QNetworkReply::downloadProgress, this, &Downloader::onDownloadProgressChanged);
 
     waitForReply(reply, t_requestTimeoutMsec);
@@ -35,6 +80,8 @@ QByteArray Downloader::downloadFile(const QNetworkRequest& t_request, int t_requ
 
     int replyStatusCode = getReplyStatusCode(reply);
 
+    MirrorCapabilities::getInstance().recordResponse(t_request.url().toString(), MirrorCapabilities::Response::fromReply(*reply));
+
     if (t_replyStatusCode != nullptr)
     {
         *t_replyStatusCode = replyStatusCode;
@@ -42,29 +89,77 @@ QByteArray Downloader::downloadFile(const QNetworkRequest& t_request, int t_requ
 
     if (replyStatusCode < 200 || replyStatusCode >= 300)
     {
-        return QByteArray();
+        return;
     }
 
-    waitForFileDownload(reply);
+    readReplyData(reply, t_sink);
 
     disconnect(reply.data(), &QNetworkReply::downloadProgress, this, &Downloader::onDownloadProgressChanged);
-
-    return reply->readAll();
 }
 
-QString Downloader::downloadString(const QString& t_urlPath, int t_requestTimeoutMsec, int& t_replyStatusCode) const
+QByteArray Downloader::downloadBytes(const QString& t_urlPath, int t_requestTimeoutMsec, int& t_replyStatusCode) const
 {
     TRemoteDataReply reply;
 
-    fetchReply(t_urlPath, reply);
+    QNetworkRequest request((QUrl(t_urlPath)));
+
+    // Setting the header explicitly stops Qt from decoding the reply on its own.
+    request.setRawHeader("Accept-Encoding", ContentDecoder::acceptedEncodings);
+
+    fetchReply(request, reply);
     waitForReply(reply, t_requestTimeoutMsec);
     validateReply(reply);
 
-    waitForFileDownload(reply);
-
     t_replyStatusCode = getReplyStatusCode(reply);
 
-    return reply->readAll();
+    ContentDecoder decoder(reply->rawHeader("Content-Encoding"));
+
+    QByteArray result;
+    qint64 encodedBytesCount = 0;
+
+    // Body is decoded as it arrives, so that the encoded and the decoded data aren't both held as a whole.
+    while (true)
+    {
+        QByteArray data = reply->readAll();
+
+        encodedBytesCount += data.size();
+        result += decoder.decode(data);
+
+        if (reply->isFinished() && reply->bytesAvailable() == 0)
+        {
+            break;
+        }
+
+        waitForReplyData(reply);
+    }
+
+    decoder.finish();
+
+    if (decoder.isEncoded())
+    {
+        logDebug("Decoded %1 bytes of %2 content to %3 bytes.",
+                 .arg(QString::number(encodedBytesCount), QString(reply->rawHeader("Content-Encoding")), QString::number(result.size())));
+
+        Telemetry::getInstance().addCounter("encoded_api_bytes", encodedBytesCount);
+        Telemetry::getInstance().addCounter("decoded_api_bytes", result.size());
+    }
+
+    return result;
+}
+
+bool Downloader::usesRangeRequests() const
+{
+    return false;
+}
+
+void Downloader::setPriority(RateLimiter::Priority t_priority)
+{
+    m_priority = t_priority;
+}
+
+RateLimiter::Priority Downloader::getPriority() const
+{
+    return m_priority;
 }
 
 bool Downloader::doesStatusCodeIndicateSuccess(int t_statusCode)
@@ -131,13 +226,37 @@ void Downloader::fetchReply(const QNetworkRequest& t_urlRequest, TRemoteDataRepl
         throw std::runtime_error("No remote data source provided.");
     }
 
-    QNetworkReply* reply = m_remoteDataSource->get(t_urlRequest);
+    m_cancellationToken.throwIfCancelled();
+
+    QNetworkRequest request = t_urlRequest;
+
+    // Content is stored and verified byte for byte - sizes and Range offsets have to refer to the data as it is.
+    if (!request.hasRawHeader("Accept-Encoding"))
+    {
+        request.setRawHeader("Accept-Encoding", "identity");
+    }
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+    // Requests to one host are multiplexed over a single connection, servers without HTTP/2 are talked to with HTTP/1.1.
+    if (Options::getInstance().isHttp2Enabled() && MirrorCapabilities::getInstance().isHttp2Allowed(request.url().toString()))
+    {
+        request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+    }
+#endif
+
+    QNetworkReply* reply = m_remoteDataSource->get(request);
 
     if (!reply)
     {
         throw std::runtime_error("Reply was null.");
     }
 
+    reply->setProperty(issuedAtProperty, Telemetry::getInstance().elapsed());
+
+    // Aborting closes the connection right away instead of after the pending wait finishes.
+    connect(&m_cancellationToken, &CancellationToken::cancelled, reply, &QNetworkReply::abort);
+    connect(this, &Downloader::terminate, reply, &QNetworkReply::abort);
+
     t_reply = TRemoteDataReply(reply);
 }
 
@@ -145,6 +264,9 @@ void Downloader::waitForReply(TRemoteDataReply& t_reply, int t_requestTimeoutMse
 {
     logInfo("Waiting for network reply to be ready.");
 
+    QElapsedTimer roundTripTimer;
+    roundTripTimer.start();
+
     if (t_reply->isFinished())
     {
         return;
@@ -170,9 +292,30 @@ void Downloader::waitForReply(TRemoteDataReply& t_reply, int t_requestTimeoutMse
 
         if (!timeoutTimer.isActive())
         {
+            reportTimeout(t_reply);
+
             throw TimeoutException();
         }
     }
+
+    QVariant issuedAt = t_reply->property(issuedAtProperty);
+
+    if (issuedAt.isValid())
+    {
+        t_reply->setProperty(timeToFirstByteProperty, Telemetry::getInstance().elapsed() - issuedAt.toLongLong());
+    }
+
+    if (!t_reply->url().host().isEmpty())
+    {
+        TimeoutEstimator::getInstance().addSample(t_reply->url().toString(), int(roundTripTimer.elapsed()));
+    }
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+    if (t_reply->attribute(QNetworkRequest::Http2WasUsedAttribute).toBool())
+    {
+        Telemetry::getInstance().addCounter("http2_replies");
+    }
+#endif
 }
 
 void Downloader::validateReply(TRemoteDataReply& t_reply) const
@@ -181,6 +324,17 @@ void Downloader::validateReply(TRemoteDataReply& t_reply) const
 
     if (t_reply->error() != QNetworkReply::NoError)
     {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+        bool isProtocolError = t_reply->error() == QNetworkReply::ProtocolFailure
+                            || t_reply->error() == QNetworkReply::ProtocolUnknownError;
+
+        // Retries of the request go with HTTP/1.1.
+        if (isProtocolError && t_reply->request().attribute(QNetworkRequest::Http2AllowedAttribute).toBool())
+        {
+            MirrorCapabilities::getInstance().reportHttp2Failure(t_reply->url().toString());
+        }
+#endif
+
         throw std::runtime_error(t_reply->errorString().toStdString());
     }
 }
@@ -220,6 +374,112 @@ void Downloader::waitForFileDownload(TRemoteDataReply& t_reply) const
     m_cancellationToken.throwIfCancelled();
 }
 
+void Downloader::waitForReplyData(TRemoteDataReply& t_reply) const
+{
+    if (t_reply->isFinished() || t_reply->bytesAvailable() > 0)
+    {
+        return;
+    }
+
+    QEventLoop waitLoop;
+
+    connect(t_reply.data(), &QNetworkReply::readyRead, &waitLoop, &QEventLoop::quit);
+    connect(t_reply.data(), &QNetworkReply::finished, &waitLoop, &QEventLoop::quit);
+    connect(&m_cancellationToken, &CancellationToken::cancelled, &waitLoop, &QEventLoop::quit);
+
+    waitLoop.exec();
+
+    m_cancellationToken.throwIfCancelled();
+}
+
+void Downloader::readReplyData(TRemoteDataReply& t_reply, const TDataSink& t_sink, const TPollHandler& t_pollHandler,
+                               int t_stallTimeoutMsec) const
+{
+    logInfo("Reading file data.");
+
+    QEventLoop waitLoop;
+    QTimer pacingTimer;
+    QTimer stallTimer;
+
+    pacingTimer.setSingleShot(true);
+    stallTimer.setSingleShot(true);
+
+    connect(t_reply.data(), &QNetworkReply::readyRead, &waitLoop, &QEventLoop::quit);
+    connect(t_reply.data(), &QNetworkReply::finished, &waitLoop, &QEventLoop::quit);
+    connect(&m_cancellationToken, &CancellationToken::cancelled, &waitLoop, &QEventLoop::quit);
+    connect(&pacingTimer, &QTimer::timeout, &waitLoop, &QEventLoop::quit);
+    connect(&stallTimer, &QTimer::timeout, &waitLoop, &QEventLoop::quit);
+    connect(this, &Downloader::replyActivity, &waitLoop, &QEventLoop::quit);
+
+    RateLimiter& rateLimiter = RateLimiter::getInstance(m_priority);
+
+    if (t_stallTimeoutMsec > 0)
+    {
+        stallTimer.start(t_stallTimeoutMsec);
+    }
+
+    while (true)
+    {
+        m_cancellationToken.throwIfCancelled();
+
+        if (t_pollHandler && !t_pollHandler())
+        {
+            t_reply->abort();
+            break;
+        }
+
+        qint64 bytesAvailable = t_reply->bytesAvailable();
+
+        if (bytesAvailable > 0)
+        {
+            if (t_stallTimeoutMsec > 0)
+            {
+                stallTimer.start(t_stallTimeoutMsec);
+            }
+
+            qint64 bytesGranted = rateLimiter.acquire(bytesAvailable);
+
+            if (bytesGranted > 0)
+            {
+                QByteArray data = t_reply->read(bytesGranted);
+
+                QVariant timeToFirstByte = t_reply->property(timeToFirstByteProperty);
+
+                if (timeToFirstByte.isValid())
+                {
+                    Telemetry::getInstance().setTimingOnce("time_to_first_byte_msec", timeToFirstByte.toLongLong());
+                }
+
+                Telemetry::getInstance().addCounter("downloaded_bytes", data.size());
+
+                if (!t_sink(data))
+                {
+                    t_reply->abort();
+                    break;
+                }
+
+                continue;
+            }
+
+            pacingTimer.start(rateLimiter.msecsUntilAvailable());
+        }
+        else if (t_reply->isFinished())
+        {
+            break;
+        }
+        else if (t_stallTimeoutMsec > 0 && !stallTimer.isActive())
+        {
+            logWarning("No data has arrived for %1 msec.", .arg(QString::number(t_stallTimeoutMsec)));
+
+            reportTimeout(t_reply);
+
+            throw TimeoutException();
+        }
+
+        waitLoop.exec();
+    }
+}
+
 void Downloader::restartDownload(TRemoteDataReply& t_reply, const QUrl& t_url) const
 {
     QNetworkRequest request(t_url);
@@ -229,12 +489,19 @@ void Downloader::restartDownload(TRemoteDataReply& t_reply, const QUrl& t_url) c
 void Downloader::restartDownload(TRemoteDataReply& t_reply, const QNetworkRequest& t_request) const
 {
     disconnect(t_reply.data(), &QNetworkReply::downloadProgress, this, &Downloader::onDownloadProgressChanged);
-    disconnect(this, &Downloader::terminate, t_reply.data(), &QNetworkReply::abort);
 
     // Fetch a new reply
     fetchReply(t_request, t_reply);
 
     connect(t_reply.data(), &QNetworkReply::downloadProgress, this, &Downloader::onDownloadProgressChanged);
-    connect(this, &Downloader::terminate, t_reply.data(), &QNetworkReply::abort);
 }
 
+void Downloader::reportTimeout(TRemoteDataReply& t_reply) const
+{
+    if (!t_reply->url().host().isEmpty())
+    {
+        TimeoutEstimator::getInstance().reportTimeout(t_reply->url().toString());
+    }
+
+    Telemetry::getInstance().addCounter("timeouts");
+}
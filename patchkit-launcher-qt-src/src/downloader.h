@@ -7,8 +7,10 @@
 
 #include <QtNetwork>
 #include <memory>
+#include <functional>
 
 #include "cancellationtoken.h"
+#include "ratelimiter.h"
 
 class Downloader : public QObject
 {
@@ -21,8 +23,28 @@ public:
 
     typedef long long TByteCount;
 
+    // Receives downloaded data as it arrives, returning false stops the download.
+    typedef std::function<bool(const QByteArray&)> TDataSink;
+
+    // Called whenever reading of a reply wakes up, returning false stops the download.
+    typedef std::function<bool()> TPollHandler;
+
     virtual QByteArray  downloadFile(const QString& t_urlPath, int t_requestTimeoutMsec, int* t_replyStatusCode = nullptr);
-    QString downloadString(const QString& t_urlPath, int t_requestTimeoutMsec, int& t_replyStatusCode) const;
+
+    /**
+     * @brief downloadFile
+     *
+     * Streams the downloaded data into t_target, which has to be open for writing.
+     * Data is never held in memory as a whole, so there is no limit on the file size.
+     */
+    virtual void        downloadFile(const QString& t_urlPath, QIODevice& t_target, int t_requestTimeoutMsec, int* t_replyStatusCode = nullptr);
+    QByteArray downloadBytes(const QString& t_urlPath, int t_requestTimeoutMsec, int& t_replyStatusCode) const;
+
+    // Downloaders relying on Range requests are given mirrors which honor them first.
+    virtual bool usesRangeRequests() const;
+
+    void setPriority(RateLimiter::Priority t_priority);
+    RateLimiter::Priority getPriority() const;
 
     static bool doesStatusCodeIndicateSuccess(int t_statusCode);
     static bool checkInternetConnection();
@@ -31,6 +53,9 @@ signals:
     void downloadProgressChanged(const TByteCount& t_bytesDownloaded, const TByteCount& t_totalBytes);
     void terminate();
 
+    // Wakes up reading of a reply, so that the poll handler can look at other replies.
+    void replyActivity();
+
 public slots:
     virtual void abort();
 
@@ -39,6 +64,7 @@ protected slots:
 
 protected:
     QByteArray downloadFile(const QNetworkRequest& t_request, int t_requestTimeoutMsec, int* t_replyStatusCode = nullptr);
+    void downloadFile(const QNetworkRequest& t_request, const TDataSink& t_sink, int t_requestTimeoutMsec, int* t_replyStatusCode = nullptr);
 
     void fetchReply(const QString& t_urlPath, TRemoteDataReply& t_reply) const;
     void fetchReply(const QNetworkRequest& t_urlRequest, TRemoteDataReply& t_reply) const;
@@ -50,6 +76,16 @@ protected:
     int  getReplyStatusCode(TRemoteDataReply& t_reply) const;
 
     void waitForFileDownload(TRemoteDataReply& t_reply) const;
+    void waitForReplyData(TRemoteDataReply& t_reply) const;
+
+    /**
+     * @brief readReplyData
+     *
+     * Passes the reply data to t_sink as it arrives. With t_stallTimeoutMsec greater than 0 a TimeoutException is thrown
+     * once no data has arrived for so long - time spent waiting for the rate limiter doesn't count.
+     */
+    void readReplyData(TRemoteDataReply& t_reply, const TDataSink& t_sink, const TPollHandler& t_pollHandler = TPollHandler(),
+                       int t_stallTimeoutMsec = -1) const;
 
     void restartDownload(TRemoteDataReply& t_reply, const QUrl& t_url) const;
     void restartDownload(TRemoteDataReply& t_reply, const QNetworkRequest& t_request) const;
@@ -57,5 +93,8 @@ protected:
     CancellationToken m_cancellationToken;
 
 private:
+    void reportTimeout(TRemoteDataReply& t_reply) const;
+
     QNetworkAccessManager* m_remoteDataSource;
+    RateLimiter::Priority m_priority;
 };
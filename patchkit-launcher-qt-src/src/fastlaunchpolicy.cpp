@@ -0,0 +1,25 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "fastlaunchpolicy.h"
+
+#include "config.h"
+
+bool FastLaunchPolicy::isValidationRecent(qint64 t_validatedAtMsec, qint64 t_nowMsec)
+{
+    if (t_validatedAtMsec < 0)
+    {
+        return false;
+    }
+
+    qint64 stalenessMsec = t_nowMsec - t_validatedAtMsec;
+
+    return stalenessMsec >= 0 && stalenessMsec <= Config::fastLaunchMaxStalenessMsec;
+}
+
+bool FastLaunchPolicy::shouldInstallStaged(int t_stagedVersion, int t_installedVersion)
+{
+    return t_stagedVersion >= 0 && t_stagedVersion > t_installedVersion;
+}
@@ -0,0 +1,29 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#ifndef FASTLAUNCHPOLICY_H
+#define FASTLAUNCHPOLICY_H
+
+#include <QtGlobal>
+
+/**
+ * @brief
+ * Decides when the installed patcher may be started before checking for a newer version.
+ *
+ * @details
+ * Fast launch is allowed only for a patcher which was validated against the API
+ * not longer than Config::fastLaunchMaxStalenessMsec ago. A validation time from the future
+ * (clock moved back) or a missing one (-1) is never trusted.
+ */
+class FastLaunchPolicy
+{
+public:
+    static bool isValidationRecent(qint64 t_validatedAtMsec, qint64 t_nowMsec);
+
+    // Staged archive may be older than a patcher installed by a regular launch in the meantime.
+    static bool shouldInstallStaged(int t_stagedVersion, int t_installedVersion);
+};
+
+#endif // FASTLAUNCHPOLICY_H
@@ -9,3 +9,28 @@ THash HashingStrategy::xxHash(const QByteArray& t_data)
 {
     return XXH32(t_data.data(), t_data.size(), xxHashSeed);
 }
+
+std::unique_ptr<HashStream> HashingStrategy::xxHashStream()
+{
+    return std::unique_ptr<HashStream>(new XXHashStream());
+}
+
+HashingStrategy::XXHashStream::XXHashStream()
+{
+    reset();
+}
+
+void HashingStrategy::XXHashStream::reset()
+{
+    XXH32_reset(&m_state, xxHashSeed);
+}
+
+void HashingStrategy::XXHashStream::update(const char* t_data, int t_size)
+{
+    XXH32_update(&m_state, t_data, size_t(t_size));
+}
+
+THash HashingStrategy::XXHashStream::digest() const
+{
+    return XXH32_digest(&m_state);
+}
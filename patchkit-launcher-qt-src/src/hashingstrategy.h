@@ -8,6 +8,8 @@
 
 #include <QByteArray>
 
+#include <memory>
+
 #define XXH_PRIVATE_API
 #include "xxhash.h"
 
@@ -15,11 +17,54 @@ typedef unsigned int THash;
 
 typedef THash (*HashFunc)(const QByteArray&);
 
+/**
+ * @brief
+ * Hash of data passed in pieces.
+ *
+ * @details
+ * Digest of all the pieces equals the hash of them as a whole. Hashing can be paused in the middle
+ * of a chunk and resumed when the rest of it arrives.
+ */
+class HashStream
+{
+public:
+    virtual ~HashStream() {}
+
+    virtual void    reset() = 0;
+    virtual void    update(const char* t_data, int t_size) = 0;
+    virtual THash   digest() const = 0;
+};
+
+// Creates a new, reset hash stream - hashing strategy of downloads which hash the data as it arrives.
+typedef std::unique_ptr<HashStream> (*HashStreamFunc)();
+
 namespace HashingStrategy
 {
     const int xxHashSeed = 42;
 
     THash xxHash(const QByteArray& t_data);
+
+    std::unique_ptr<HashStream> xxHashStream();
+
+    /**
+     * @brief
+     * Incremental xxHash, digest equals xxHash() of all the pieces.
+     *
+     * @details
+     * The state is a plain value, so the stream can be copied in the middle of the data.
+     */
+    class XXHashStream : public HashStream
+    {
+    public:
+        XXHashStream();
+
+        void    reset() override;
+        void    update(const char* t_data, int t_size) override;
+        THash   digest() const override;
+
+    private:
+        XXH32_state_t m_state;
+    };
 }
 
 #endif // HASHINGSTRATEGY_H
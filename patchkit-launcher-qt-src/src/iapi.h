@@ -1,13 +1,20 @@
 #ifndef IAPI_H
 #define IAPI_H
 
+#include <QString>
+#include <QByteArray>
+
+#include "cancellationtoken.h"
+#include "contentsummary.h"
+
 class IApi
 {
 public:
-    virtual QString downloadString(const QString& t_apiUrl, const QString& t_resourceUrl, CancellationToken t_cancellationToken) const = 0;
+    // Throws std::runtime_error if none of the api urls responded, or the main one responded with an error status code.
+    virtual QByteArray downloadBytes(const QString& t_resourceUrl, CancellationToken t_cancellationToken) const = 0;
 
-    // Returns all the api urls (the main and cache), main url should always be at the 0 th index.
-    virtual const QStringList& getApiUrls() const = 0;
+    // Returns a valid content summary, throws std::runtime_error like downloadBytes if none of the api urls served one.
+    virtual ContentSummary downloadContentSummary(const QString& t_resourceUrl, CancellationToken t_cancellationToken) const = 0;
 };
 
 #endif // IAPI_H
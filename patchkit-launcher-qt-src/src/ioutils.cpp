@@ -68,7 +68,7 @@ bool IOUtils::checkIfFileExists(const QString& t_filePath)
     return info.isFile();
 }
 
-void IOUtils::extractZip(const QString& t_zipPath, const QString& t_extractPath, QStringList& t_extractedEntries)
+void IOUtils::extractZip(const QString& t_zipPath, const QString& t_extractPath, QStringList& t_extractedEntries, CancellationToken t_cancellationToken)
 {
     QuaZip zipFile(t_zipPath);
 
@@ -81,6 +81,8 @@ void IOUtils::extractZip(const QString& t_zipPath, const QString& t_extractPath,
 
     do
     {
+        t_cancellationToken.throwIfCancelled();
+
         QString zipEntryName = zipFile.getCurrentFileName();
 
         QString zipEntryPath = QDir::cleanPath(t_extractPath + "/" + zipEntryName);
@@ -92,7 +94,7 @@ void IOUtils::extractZip(const QString& t_zipPath, const QString& t_extractPath,
         else
         {
             QuaZipFile zipEntry(&zipFile);
-            extractZipFileEntry(zipEntry, zipEntryPath);
+            extractZipFileEntry(zipEntry, zipEntryPath, t_cancellationToken);
         }
 
         t_extractedEntries.append(zipEntryName);
@@ -102,22 +104,30 @@ void IOUtils::extractZip(const QString& t_zipPath, const QString& t_extractPath,
     zipFile.close();
 }
 
-void IOUtils::copyIODeviceData(QIODevice& t_readDevice, QIODevice& t_writeDevice)
+void IOUtils::copyIODeviceData(QIODevice& t_readDevice, QIODevice& t_writeDevice, CancellationToken t_cancellationToken)
 {
-    qint64 bufferSize = 4096;
-    std::unique_ptr<char> buffer(new char[bufferSize]);
+    qint64 bufferSize = 64 * 1024;
+    std::unique_ptr<char[]> buffer(new char[bufferSize]);
 
     while (!t_readDevice.atEnd())
     {
+        t_cancellationToken.throwIfCancelled();
+
         qint64 readSize = t_readDevice.read(buffer.get(), bufferSize);
-        if (readSize > 0)
+
+        if (readSize < 0)
+        {
+            throw std::runtime_error("Couldn't read data.");
+        }
+
+        if (t_writeDevice.write(buffer.get(), readSize) != readSize)
         {
-            t_writeDevice.write(buffer.get(), readSize);
+            throw std::runtime_error("Couldn't write data.");
         }
     }
 }
 
-void IOUtils::extractZipFileEntry(QuaZipFile& t_zipEntry, const QString& t_zipEntryPath)
+void IOUtils::extractZipFileEntry(QuaZipFile& t_zipEntry, const QString& t_zipEntryPath, CancellationToken& t_cancellationToken)
 {
     if (!t_zipEntry.open(QIODevice::ReadOnly) || t_zipEntry.getZipError() != UNZ_OK)
     {
@@ -135,7 +145,17 @@ void IOUtils::extractZipFileEntry(QuaZipFile& t_zipEntry, const QString& t_zipEn
         throw std::runtime_error("Couldn't open file for extracting.");
     }
 
-    copyIODeviceData(reinterpret_cast<QIODevice&>(t_zipEntry), zipEntryFile);
+    copyIODeviceData(reinterpret_cast<QIODevice&>(t_zipEntry), zipEntryFile, t_cancellationToken);
+
+    // Sizes are 64-bit, so entries above 4 GB of ZIP64 archives are checked as well.
+    qint64 expectedSize = t_zipEntry.usize();
+
+    t_zipEntry.close();
+
+    if (t_zipEntry.getZipError() != UNZ_OK || zipEntryFile.size() != expectedSize)
+    {
+        throw std::runtime_error("Zip entry is corrupted.");
+    }
 
     zipEntryFile.close();
 }
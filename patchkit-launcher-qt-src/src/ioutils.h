@@ -7,6 +7,8 @@
 
 #include <quazipfile.h>
 
+#include "cancellationtoken.h"
+
 class IOUtils
 {
 public:
@@ -22,10 +24,10 @@ public:
 
     static bool checkIfFileExists(const QString& t_filePath);
 
-    static void extractZip(const QString& t_zipPath, const QString& t_extractPath, QStringList& t_extractedEntries);
+    static void extractZip(const QString& t_zipPath, const QString& t_extractPath, QStringList& t_extractedEntries, CancellationToken t_cancellationToken);
 
-    static void copyIODeviceData(QIODevice& t_readDevice, QIODevice& t_writeDevice);
+    static void copyIODeviceData(QIODevice& t_readDevice, QIODevice& t_writeDevice, CancellationToken t_cancellationToken);
 
 private:
-    static void extractZipFileEntry(QuaZipFile& t_zipEntry, const QString& t_zipEntryPath);
+    static void extractZipFileEntry(QuaZipFile& t_zipEntry, const QString& t_zipEntryPath, CancellationToken& t_cancellationToken);
 };
@@ -5,13 +5,19 @@
 
 #include "launcherworker.h"
 
-#include <QtMath>
 #include <QMessageBox>
+#include <QLockFile>
+#include <QDateTime>
 
 #include "logger.h"
 #include "locations.h"
 #include "fatalexception.h"
 #include "downloader.h"
+#include "options.h"
+#include "ioutils.h"
+#include "telemetry.h"
+#include "connectionwarmer.h"
+#include "fastlaunchpolicy.h"
 
 #if defined(Q_OS_WIN)
 #include <Windows.h>
@@ -66,11 +72,20 @@ LauncherWorker::LauncherWorker()
     : m_cancellationTokenSource(new CancellationTokenSource())
     , m_result(NONE)
     , m_remotePatcher(m_api, &m_networkAccessManager)
+    , m_downloadProgress(Config::progressReportIntervalMsec)
 {
+    m_api.setNetworkAccessManager(&m_networkAccessManager);
+
     m_api.moveToThread(this);
     m_networkAccessManager.moveToThread(this);
     m_remotePatcher.moveToThread(this);
     m_localPatcher.moveToThread(this);
+
+    // Launcher quits as soon as the patcher is started, so only the long-lived prefetch helper serves peers.
+    if (Options::getInstance().isPeerSharingEnabled() && Options::getInstance().isPrefetchHelper())
+    {
+        startPeerSharing();
+    }
 }
 
 void LauncherWorker::cancel()
@@ -87,11 +102,12 @@ LauncherWorker::Result LauncherWorker::result() const
 
 void LauncherWorker::setDownloadProgress(const long long& t_bytesDownloaded, const long long& t_totalBytes)
 {
-    long long kilobytesDownloaded = t_bytesDownloaded / 1024;
-    long long totalKilobytes = t_totalBytes / 1024;
-
-    emit statusChanged(QString("Downloading %1 / %2 KB").arg(QString::number(kilobytesDownloaded), QString::number(totalKilobytes)));
-    emit progressChanged(qCeil((qreal(t_bytesDownloaded) / t_totalBytes) * 100.0));
+    // Called in the worker thread for every notification, only changes of the displayed values go to the UI thread.
+    if (m_downloadProgress.update(t_bytesDownloaded, t_totalBytes))
+    {
+        emit statusChanged(m_downloadProgress.status());
+        emit progressChanged(m_downloadProgress.percent());
+    }
 }
 
 #ifdef Q_OS_WIN
@@ -120,6 +136,22 @@ void LauncherWorker::runWithDataFromFile()
 
 void LauncherWorker::runWithData(Data& t_data)
 {
+    if (Options::getInstance().isPrefetchHelper())
+    {
+        runPrefetchHelper(t_data);
+        return;
+    }
+
+    if (Options::getInstance().isFastLaunchEnabled() && tryFastLaunch(t_data))
+    {
+        // Version check and download of the newest patcher continue in the background, for the next launch.
+        startPrefetchHelper();
+        return;
+    }
+
+    // Handshakes with the API servers and the last known content hosts overlap with the metadata phase.
+    ConnectionWarmer::getInstance().warmUp(m_networkAccessManager);
+
     try
     {
         logInfo("Starting launcher.");
@@ -164,11 +196,18 @@ void LauncherWorker::runWithData(Data& t_data)
     }
 
     startPatcher(t_data);
+
+    if (Options::getInstance().isPrefetchEnabled() || Options::getInstance().isPeerSharingEnabled())
+    {
+        startPrefetchHelper();
+    }
 }
 
 void LauncherWorker::setupPatcherSecret(Data& t_data)
 {
-    QSettings settings("UpSoft", t_data.applicationSecret().append("launcher-"));
+    Telemetry::Stage stage("secret_fetch");
+
+    QSettings settings("UpSoft", getSettingsName(t_data));
 
     if (tryToFetchPatcherSecret(t_data))
     {
@@ -211,7 +250,13 @@ void LauncherWorker::updatePatcher(const Data& t_data)
 {
     logInfo("Updating patcher.");
 
-    int version = m_remotePatcher.getVersion(t_data, m_cancellationTokenSource);
+    int version;
+
+    {
+        Telemetry::Stage stage("version_check");
+        version = m_remotePatcher.getVersion(t_data, m_cancellationTokenSource);
+    }
+
     logDebug("Current remote patcher version - %1", .arg(QString::number(version)));
 
     emit progressChanged(0);
@@ -225,29 +270,153 @@ void LauncherWorker::updatePatcher(const Data& t_data)
 
         logInfo("The newest patcher is not installed. Downloading the newest version of patcher.");
 
-        emit statusChanged("Downloading...");
+        QString downloadPath = QDir::cleanPath(Locations::getInstance().applicationDirPath() + "/patcher.zip");
+        QString contentId;
 
-        logDebug("Connecting downloadProgressChanged signal from remote patcher to slot from launcher thread.");
-        connect(&m_remotePatcher, &RemotePatcherData::downloadProgressChanged, this, &LauncherWorker::setDownloadProgress);
+        if (m_stagedPatcher.takeArchive(version, t_data, downloadPath))
+        {
+            logInfo("The newest patcher has been downloaded in the background, skipping download.");
+        }
+        else
+        {
+            emit statusChanged("Downloading...");
 
-        QString downloadPath = QDir::cleanPath(Locations::getInstance().applicationDirPath() + "/patcher.zip");
+            logDebug("Connecting downloadProgressChanged signal from remote patcher to slot from launcher thread.");
+            m_downloadProgress.reset();
+            connect(&m_remotePatcher, &RemotePatcherData::downloadProgressChanged, this, &LauncherWorker::setDownloadProgress, Qt::DirectConnection);
+
+            QFile file(downloadPath);
 
-        QFile file(downloadPath);
+            {
+                Telemetry::Stage stage("download");
+                m_remotePatcher.download(file, t_data, version, m_cancellationTokenSource);
+            }
 
-        m_remotePatcher.download(file, t_data, version, m_cancellationTokenSource);
-        logInfo("Patcher has been downloaded to %1", .arg(downloadPath));
+            contentId = m_remotePatcher.getDownloadedContentId();
 
-        logDebug("Disconnecting downloadProgressChanged signal from remote patcher to slot from launcher thread.");
-        disconnect(&m_remotePatcher, &RemotePatcherData::downloadProgressChanged, this, &LauncherWorker::setDownloadProgress);
+            logInfo("Patcher has been downloaded to %1", .arg(downloadPath));
+
+            logDebug("Disconnecting downloadProgressChanged signal from remote patcher to slot from launcher thread.");
+            disconnect(&m_remotePatcher, &RemotePatcherData::downloadProgressChanged, this, &LauncherWorker::setDownloadProgress);
+        }
 
         emit progressChanged(100);
         emit statusChanged("Installing...");
 
-        m_localPatcher.install(downloadPath, t_data, version);
+        {
+            Telemetry::Stage stage("install");
+            m_localPatcher.install(downloadPath, t_data, version, m_cancellationTokenSource);
+        }
+
+        // Archive taken from staging has no known content id, so it isn't shared.
+        if (Options::getInstance().isPeerSharingEnabled() && !contentId.isEmpty())
+        {
+            sharePatcherArchive(downloadPath, contentId);
+        }
+        else
+        {
+            QFile::remove(downloadPath);
+        }
 
-        QFile::remove(downloadPath);
         logInfo("Patcher has been installed.");
     }
+
+    markPatcherValidated(t_data);
+}
+
+bool LauncherWorker::tryFastLaunch(Data& t_data)
+{
+    logInfo("Fast launch is enabled. Checking whether the installed patcher can be started right away.");
+
+    QSettings settings("UpSoft", getSettingsName(t_data));
+
+    // Only a patcher which was up to date not long ago is started without checking for a newer version.
+    qint64 validatedAtMsec = settings.value("patcher_validated_at", -1).toLongLong();
+
+    if (!FastLaunchPolicy::isValidationRecent(validatedAtMsec, QDateTime::currentMSecsSinceEpoch()))
+    {
+        logInfo("Installed patcher hasn't been validated recently, checking for a newer version first.");
+        return false;
+    }
+
+    if (settings.contains("patcher_secret"))
+    {
+        t_data.overwritePatcherSecret = settings.value("patcher_secret").toString();
+    }
+
+    try
+    {
+        installStagedPatcher(t_data);
+
+        if (m_localPatcher.getInstalledVersion(t_data) < 0)
+        {
+            logInfo("Patcher is not installed, it can't be started right away.");
+            return false;
+        }
+
+        startPatcher(t_data);
+    }
+    catch (CancelledException&)
+    {
+        throw;
+    }
+    catch (std::exception& exception)
+    {
+        logWarning(exception.what());
+        logWarning("Fast launch has failed, falling back to the regular launch.");
+        return false;
+    }
+
+    Telemetry::getInstance().setValue("fast_launch", "true");
+
+    return true;
+}
+
+void LauncherWorker::installStagedPatcher(const Data& t_data)
+{
+    int stagedVersion = m_stagedPatcher.getStagedVersion(t_data);
+
+    if (!FastLaunchPolicy::shouldInstallStaged(stagedVersion, m_localPatcher.getInstalledVersion(t_data)))
+    {
+        return;
+    }
+
+    if (!Locations::getInstance().isCurrentDirWritable())
+    {
+        logInfo("Current directory isn't writable, staged patcher will be installed by a regular launch.");
+        return;
+    }
+
+    logInfo("Installing staged patcher version %1.", .arg(QString::number(stagedVersion)));
+
+    QString downloadPath = QDir::cleanPath(Locations::getInstance().applicationDirPath() + "/patcher.zip");
+
+    if (!m_stagedPatcher.takeArchive(stagedVersion, t_data, downloadPath))
+    {
+        return;
+    }
+
+    emit statusChanged("Installing...");
+
+    {
+        Telemetry::Stage stage("install");
+        m_localPatcher.install(downloadPath, t_data, stagedVersion, m_cancellationTokenSource);
+    }
+
+    QFile::remove(downloadPath);
+    logInfo("Staged patcher has been installed.");
+}
+
+void LauncherWorker::markPatcherValidated(const Data& t_data)
+{
+    QSettings settings("UpSoft", getSettingsName(t_data));
+
+    settings.setValue("patcher_validated_at", QDateTime::currentMSecsSinceEpoch());
+}
+
+QString LauncherWorker::getSettingsName(const Data& t_data)
+{
+    return t_data.applicationSecret().append("launcher-");
 }
 
 void LauncherWorker::startPatcher(const Data& t_data)
@@ -256,9 +425,119 @@ void LauncherWorker::startPatcher(const Data& t_data)
 
     emit statusChanged("Starting...");
 
+    Telemetry::Stage stage("start");
+
     m_localPatcher.start(t_data);
 }
 
+void LauncherWorker::startPrefetchHelper()
+{
+    logInfo("Starting prefetch helper.");
+
+    QStringList arguments = Options::getInstance().getPassedArguments();
+    arguments.removeAll(Config::prefetchArg);
+    arguments.append(Config::prefetchHelperArg);
+
+    if (!QProcess::startDetached(Locations::getInstance().applicationFilePath(), arguments))
+    {
+        logWarning("Couldn't start prefetch helper.");
+    }
+}
+
+void LauncherWorker::runPrefetchHelper(Data& t_data)
+{
+    logInfo("Starting prefetch helper.");
+
+    // Only one helper is polling for a launcher location.
+    QLockFile lock(Locations::getInstance().prefetchLockFilePath());
+
+    if (!lock.tryLock(0))
+    {
+        logInfo("Another prefetch helper is already running.");
+        return;
+    }
+
+    setupPatcherSecret(t_data);
+
+    m_remotePatcher.setDownloadPriority(RateLimiter::Background);
+
+    QElapsedTimer lifetime;
+    lifetime.start();
+
+    // First poll goes right away, the user may log off or shut down long before the next one.
+    while (true)
+    {
+        try
+        {
+            prefetchPatcher(t_data);
+        }
+        catch (CancelledException&)
+        {
+            throw;
+        }
+        catch (std::exception& exception)
+        {
+            logWarning(exception.what());
+            logWarning("Prefetching patcher failed, will retry with next poll.");
+        }
+
+        if (lifetime.elapsed() >= Config::prefetchLifetimeMsec)
+        {
+            break;
+        }
+
+        waitForPrefetchPoll();
+    }
+
+    logInfo("Prefetch helper lifetime has passed.");
+}
+
+void LauncherWorker::prefetchPatcher(const Data& t_data)
+{
+    logInfo("Polling for new patcher version.");
+
+    int version = m_remotePatcher.getVersion(t_data, m_cancellationTokenSource);
+
+    if (m_localPatcher.isInstalledSpecific(version, t_data) || m_stagedPatcher.isStaged(version, t_data))
+    {
+        logInfo("Patcher version %1 is already available.", .arg(QString::number(version)));
+        markPatcherValidated(t_data);
+        return;
+    }
+
+    logInfo("Prefetching patcher version %1.", .arg(QString::number(version)));
+
+    IOUtils::createDir(Locations::getInstance().patcherStagingDirPath());
+
+    QString downloadPath = StagedPatcherData::partialArchivePath();
+
+    QFile file(downloadPath);
+
+    m_remotePatcher.download(file, t_data, version, m_cancellationTokenSource);
+
+    if (!m_stagedPatcher.stage(downloadPath, t_data, version))
+    {
+        QFile::remove(downloadPath);
+        return;
+    }
+
+    markPatcherValidated(t_data);
+}
+
+void LauncherWorker::waitForPrefetchPoll()
+{
+    CancellationToken cancellationToken(m_cancellationTokenSource);
+
+    cancellationToken.throwIfCancelled();
+
+    QEventLoop waitLoop;
+    connect(&cancellationToken, &CancellationToken::cancelled, &waitLoop, &QEventLoop::quit);
+    QTimer::singleShot(Config::prefetchPollIntervalMsec, &waitLoop, &QEventLoop::quit);
+    waitLoop.exec();
+
+    cancellationToken.throwIfCancelled();
+}
+
 void LauncherWorker::checkIfCurrentDirectoryIsWritable()
 {
     if (!Locations::getInstance().isCurrentDirWritable())
@@ -272,3 +551,59 @@ void LauncherWorker::checkIfCurrentDirectoryIsWritable()
 #endif
     }
 }
+
+void LauncherWorker::startPeerSharing()
+{
+    logInfo("Peer sharing is enabled.");
+
+    // Server and discovery responder stay in the thread owning the worker, which keeps running its event loop
+    // for the whole lifetime of the prefetch helper.
+    QHostAddress interfaceAddress(QHostAddress::AnyIPv4);
+    QString peerSharingInterface = Options::getInstance().getPeerSharingInterface();
+
+    if (!peerSharingInterface.isEmpty() && !interfaceAddress.setAddress(peerSharingInterface))
+    {
+        logWarning("Invalid peer sharing interface address - %1. Peer sharing is disabled.", .arg(peerSharingInterface));
+        return;
+    }
+
+    m_peerChunkServer = std::make_unique<PeerChunkServer>(Locations::getInstance().peerCacheDirPath());
+
+    if (!m_peerChunkServer->start(interfaceAddress))
+    {
+        return;
+    }
+
+    m_peerDiscovery = std::make_unique<PeerDiscovery>(Config::peerDiscoveryPort);
+    m_peerDiscovery->startResponding(Locations::getInstance().peerCacheDirPath(), m_peerChunkServer->serverPort(), interfaceAddress);
+}
+
+void LauncherWorker::sharePatcherArchive(const QString& t_archivePath, const QString& t_contentId)
+{
+    logInfo("Moving downloaded patcher to the peer cache as %1.", .arg(t_contentId));
+
+    QString cacheFilePath = Locations::getInstance().peerCacheFilePath(t_contentId);
+
+    IOUtils::createDir(Locations::getInstance().peerCacheDirPath());
+    QFile::remove(cacheFilePath);
+
+    // Archive is moved rather than copied, peers are served straight from it.
+    if (!QFile::rename(t_archivePath, cacheFilePath))
+    {
+        logWarning("Couldn't move downloaded patcher to the peer cache.");
+        QFile::remove(t_archivePath);
+        return;
+    }
+
+    // Only the newest patcher is shared. Older archives are removed one by one, an archive which is still
+    // being read by a running helper can't be removed on Windows and is left until the next update.
+    QDir peerCacheDir(Locations::getInstance().peerCacheDirPath());
+
+    for (const QString& fileName : peerCacheDir.entryList(QDir::Files))
+    {
+        if (fileName != t_contentId && !peerCacheDir.remove(fileName))
+        {
+            logInfo("Couldn't remove %1 from the peer cache, it's still being shared.", .arg(fileName));
+        }
+    }
+}
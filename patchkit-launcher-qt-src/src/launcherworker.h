@@ -8,8 +8,12 @@
 #include "data.h"
 #include "remotepatcherdata.h"
 #include "localpatcherdata.h"
+#include "stagedpatcherdata.h"
 #include "cancellationtokensource.h"
 #include "api.h"
+#include "peerchunkserver.h"
+#include "peerdiscovery.h"
+#include "progressaggregator.h"
 
 class LauncherWorker : public QThread
 {
@@ -54,15 +58,35 @@ private:
     void updatePatcher(const Data& t_data);
     void startPatcher(const Data& t_data);
 
+    bool tryFastLaunch(Data& t_data);
+    void installStagedPatcher(const Data& t_data);
+    void markPatcherValidated(const Data& t_data);
+
+    static QString getSettingsName(const Data& t_data);
+
     void checkIfCurrentDirectoryIsWritable();
 
+    void startPrefetchHelper();
+    void runPrefetchHelper(Data& t_data);
+    void prefetchPatcher(const Data& t_data);
+    void waitForPrefetchPoll();
+
+    void startPeerSharing();
+    void sharePatcherArchive(const QString& t_archivePath, const QString& t_contentId);
+
     Api m_api;
     RemotePatcherData m_remotePatcher;
     LocalPatcherData m_localPatcher;
+    StagedPatcherData m_stagedPatcher;
 
     std::shared_ptr<CancellationTokenSource> m_cancellationTokenSource;
 
     Result m_result;
 
     QNetworkAccessManager m_networkAccessManager;
+
+    ProgressAggregator m_downloadProgress;
+
+    std::unique_ptr<PeerChunkServer> m_peerChunkServer;
+    std::unique_ptr<PeerDiscovery> m_peerDiscovery;
 };
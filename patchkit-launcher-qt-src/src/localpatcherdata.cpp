@@ -84,7 +84,28 @@ bool LocalPatcherData::isInstalledSpecific(int t_version, const Data& t_data)
     return false;
 }
 
-void LocalPatcherData::install(const QString& t_downloadedPath, const Data& t_data, int t_version)
+int LocalPatcherData::getInstalledVersion(const Data& t_data)
+{
+    if (!isInstalled())
+    {
+        return -1;
+    }
+
+    QString patcherId = IOUtils::readTextFromFile(Locations::getInstance().patcherIdInfoFilePath());
+
+    if (patcherId != getPatcherId(t_data))
+    {
+        return -1;
+    }
+
+    // Corrupted version info is treated like no installation, the patcher is installed again.
+    bool ok;
+    int version = IOUtils::readTextFromFile(Locations::getInstance().patcherVersionInfoFilePath()).toInt(&ok);
+
+    return ok ? version : -1;
+}
+
+void LocalPatcherData::install(const QString& t_downloadedPath, const Data& t_data, int t_version, CancellationToken t_cancellationToken)
 {
     uninstall();
 
@@ -94,7 +115,17 @@ void LocalPatcherData::install(const QString& t_downloadedPath, const Data& t_da
 
     QStringList installationPatcherEntries;
 
-    IOUtils::extractZip(t_downloadedPath, Locations::getInstance().patcherDirectoryPath(), installationPatcherEntries);
+    try
+    {
+        IOUtils::extractZip(t_downloadedPath, Locations::getInstance().patcherDirectoryPath(), installationPatcherEntries, t_cancellationToken);
+    }
+    catch (CancelledException&)
+    {
+        // Partially extracted patcher has no installation info, so it's removed as a whole.
+        logInfo("Installation has been cancelled, removing partially extracted patcher.");
+        QDir(Locations::getInstance().patcherDirectoryPath()).removeRecursively();
+        throw;
+    }
 
     IOUtils::writeTextToFile(Locations::getInstance().patcherVersionInfoFilePath(), QString::number(t_version));
 
@@ -9,6 +9,7 @@
 #include <QString>
 
 #include "data.h"
+#include "cancellationtoken.h"
 #include <quazipfile.h>
 
 class LocalPatcherData : public QObject
@@ -20,17 +21,20 @@ public:
 
     bool isInstalledSpecific(int t_version, const Data& t_data);
 
-    void install(const QString& t_downloadedPath, const Data& t_data, int t_version);
+    // Version of the installed patcher, -1 if it isn't installed, belongs to another application or its version info is corrupted.
+    int getInstalledVersion(const Data& t_data);
+
+    void install(const QString& t_downloadedPath, const Data& t_data, int t_version, CancellationToken t_cancellationToken);
 
     void start(const Data& t_data);
 
+    static QString getPatcherId(const Data& t_data);
+
 private:
     void uninstall();
 
     int readVersion();
 
-    static QString getPatcherId(const Data& t_data);
-
     static int parseVersionInfoToNumber(const QString& t_versionInfoFileContents);
 
     void readPatcherManifset(QString& t_exeFileName,
@@ -8,6 +8,8 @@
 #include <QApplication>
 #include <QStandardPaths>
 
+#include "options.h"
+
 Locations::Locations()
 {
     m_applicationFilePath = QApplication::applicationFilePath();
@@ -56,9 +58,15 @@ void Locations::initializeCurrentDirPath()
 
     QDir::setCurrent(currentDir.path());
 
+    // Prefetch helper runs next to the launcher, so it can't truncate the launcher log.
+    QString logFileName = Options::getInstance().isPrefetchHelper() ? Config::prefetchLogFileName : Config::logFileName;
+    QString telemetryReportFileName = Options::getInstance().isPrefetchHelper() ? Config::prefetchTelemetryReportFileName
+                                                                                : Config::telemetryReportFileName;
+
     if (isCurrentDirWritable())
     {
-        m_logFilePath = QDir::cleanPath(currentDir.path() + "/" + Config::logFileName);
+        m_logFilePath = QDir::cleanPath(currentDir.path() + "/" + logFileName);
+        m_telemetryReportFilePath = QDir::cleanPath(currentDir.path() + "/" + telemetryReportFileName);
     }
     else
     {
@@ -75,6 +83,12 @@ void Locations::initializeCurrentDirPath()
             writableDir.mkpath(".");
         }
 
-        m_logFilePath = QDir::cleanPath(writableDir.path() + "/" + Config::logFileName);
+        m_logFilePath = QDir::cleanPath(writableDir.path() + "/" + logFileName);
+        m_telemetryReportFilePath = QDir::cleanPath(writableDir.path() + "/" + telemetryReportFileName);
+    }
+
+    if (!Options::getInstance().getTelemetryReportPath().isEmpty())
+    {
+        m_telemetryReportFilePath = Options::getInstance().getTelemetryReportPath();
     }
 }
@@ -45,6 +45,11 @@ public:
         return m_logFilePath;
     }
 
+    QString telemetryReportFilePath()
+    {
+        return m_telemetryReportFilePath;
+    }
+
     QString dataFilePath()
     {
         return QDir::cleanPath(applicationDirPath() + "/" + Config::dataFileName);
@@ -80,10 +85,56 @@ public:
         return QDir::cleanPath(currentDirPath() + "/" + Config::applicationDirectoryName);
     }
 
+    QString patcherStagingDirPath()
+    {
+        return QDir::cleanPath(currentDirPath() + "/" + Config::patcherStagingDirectoryName);
+    }
+
+    QString patcherStagingArchiveFilePath()
+    {
+        return QDir::cleanPath(patcherStagingDirPath() + "/" + Config::patcherStagingArchiveFileName);
+    }
+
+    QString patcherStagingVersionInfoFilePath()
+    {
+        return QDir::cleanPath(patcherStagingDirPath() + "/" + Config::patcherVersionInfoFileName);
+    }
+
+    QString patcherStagingIdInfoFilePath()
+    {
+        return QDir::cleanPath(patcherStagingDirPath() + "/" + Config::patcherIdInfoFileName);
+    }
+
+    QString patcherStagingLockFilePath()
+    {
+        return QDir::cleanPath(patcherStagingDirPath() + "/" + Config::patcherStagingLockFileName);
+    }
+
+    QString prefetchLockFilePath()
+    {
+        return QDir::cleanPath(currentDirPath() + "/" + Config::prefetchLockFileName);
+    }
+
+    QString contentSummaryCacheDirPath()
+    {
+        return QDir::cleanPath(currentDirPath() + "/" + Config::contentSummaryCacheDirectoryName);
+    }
+
+    QString peerCacheDirPath()
+    {
+        return QDir::cleanPath(currentDirPath() + "/" + Config::peerCacheDirectoryName);
+    }
+
+    QString peerCacheFilePath(const QString& t_contentId)
+    {
+        return QDir::cleanPath(peerCacheDirPath() + "/" + t_contentId);
+    }
+
 private:
     QString m_applicationFilePath;
     QString m_applicationDirPath;
     QString m_logFilePath;
+    QString m_telemetryReportFilePath;
 
     void initializeCurrentDirPath();
 };
@@ -9,15 +9,77 @@
 #include <QDateTime>
 #include <QTextStream>
 #include "locations.h"
+#include "config.h"
+#include "options.h"
+
+std::atomic<int> Logger::m_minimumSeverity(0);
 
 Logger::Logger() :
-    m_logFile(Locations::getInstance().logFilePath()),
+    Logger(Locations::getInstance().logFilePath(), true)
+{
+    setMinimumLevel(Options::getInstance().getLogLevel());
+
+    qInstallMessageHandler(logHandler);
+}
+
+Logger::Logger(const QString& t_logFilePath) :
+    Logger(t_logFilePath, false)
+{
+}
+
+Logger::Logger(const QString& t_logFilePath, bool t_isApplicationLogger) :
+    m_logFile(t_logFilePath),
     m_logFileStream(&m_logFile),
-    m_stdoutStream(stdout)
+    m_stdoutStream(stdout),
+    m_pendingEntries(nullptr),
+    m_stopped(false),
+    m_isApplicationLogger(t_isApplicationLogger),
+    m_flushRequestCount(0),
+    m_flushCompletedCount(0),
+    m_stopRequested(false),
+    m_writer(*this)
 {
     m_logFile.open(QIODevice::WriteOnly | QIODevice::Truncate);
 
-    qInstallMessageHandler(logHandler);
+    m_writer.start();
+}
+
+Logger::~Logger()
+{
+    stopWriter();
+
+    if (m_isApplicationLogger)
+    {
+        qInstallMessageHandler(nullptr);
+    }
+}
+
+bool Logger::parseLevel(const QString& t_name, QtMsgType& t_type)
+{
+    QString name = t_name.toLower();
+
+    if (name == "debug")
+    {
+        t_type = QtDebugMsg;
+    }
+    else if (name == "info")
+    {
+        t_type = QtInfoMsg;
+    }
+    else if (name == "warning")
+    {
+        t_type = QtWarningMsg;
+    }
+    else if (name == "critical")
+    {
+        t_type = QtCriticalMsg;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
 }
 
 QString Logger::adjustSecretForLog(const QString& t_secret)
@@ -35,6 +97,153 @@ QString Logger::adjustSecretForLog(const char* t_secret)
     return adjustSecretForLog(QString(t_secret));
 }
 
+Logger::Writer::Writer(Logger& t_logger)
+    : m_logger(t_logger)
+{
+}
+
+void Logger::Writer::run()
+{
+    QMutexLocker locker(&m_logger.m_writerMutex);
+
+    while (true)
+    {
+        quint64 flushRequestCount = m_logger.m_flushRequestCount;
+        bool stopRequested = m_logger.m_stopRequested;
+
+        locker.unlock();
+        m_logger.writePendingEntries();
+        locker.relock();
+
+        m_logger.m_flushCompletedCount = flushRequestCount;
+        m_logger.m_flushCompleted.wakeAll();
+
+        if (stopRequested)
+        {
+            return;
+        }
+
+        if (m_logger.m_flushRequestCount == flushRequestCount && !m_logger.m_stopRequested)
+        {
+            m_logger.m_flushRequested.wait(&m_logger.m_writerMutex, Config::logFlushIntervalMsec);
+        }
+    }
+}
+
+void Logger::push(Entry* t_entry)
+{
+    Entry* head = m_pendingEntries.load();
+
+    do
+    {
+        t_entry->next = head;
+    }
+    while (!m_pendingEntries.compare_exchange_weak(head, t_entry));
+}
+
+void Logger::requestFlush()
+{
+    // Writer flushes after every batch, it can't wait for itself.
+    if (QThread::currentThread() == &m_writer)
+    {
+        return;
+    }
+
+    QMutexLocker locker(&m_writerMutex);
+
+    quint64 flushRequest = ++m_flushRequestCount;
+
+    m_flushRequested.wakeOne();
+
+    while (m_flushCompletedCount < flushRequest && !m_stopped)
+    {
+        m_flushCompleted.wait(&m_writerMutex);
+    }
+}
+
+void Logger::stopWriter()
+{
+    {
+        QMutexLocker locker(&m_writerMutex);
+
+        if (m_stopRequested)
+        {
+            return;
+        }
+
+        m_stopRequested = true;
+        m_flushRequested.wakeOne();
+    }
+
+    m_writer.wait();
+
+    QMutexLocker locker(&m_writerMutex);
+
+    // Messages pushed after the last batch of the writer are written here, later ones by the logging threads.
+    m_stopped = true;
+    writePendingEntries();
+
+    m_flushCompleted.wakeAll();
+}
+
+void Logger::writePendingEntries()
+{
+    Entry* entries = m_pendingEntries.exchange(nullptr);
+
+    if (entries == nullptr)
+    {
+        return;
+    }
+
+    // Pending entries are kept from the newest one, reverse them to write in order.
+    Entry* orderedEntries = nullptr;
+
+    while (entries != nullptr)
+    {
+        Entry* next = entries->next;
+        entries->next = orderedEntries;
+        orderedEntries = entries;
+        entries = next;
+    }
+
+    while (orderedEntries != nullptr)
+    {
+        Entry* next = orderedEntries->next;
+
+        writeEntry(*orderedEntries);
+        delete orderedEntries;
+
+        orderedEntries = next;
+    }
+
+    if (m_isApplicationLogger)
+    {
+        m_stdoutStream.flush();
+    }
+
+    m_logFileStream.flush();
+}
+
+void Logger::writeEntry(const Entry& t_entry)
+{
+    QString txt = QString("%1%2 - %3%4").arg(resolveMessageType(t_entry.type),
+                                            t_entry.time.toString(),
+                                            t_entry.message,
+                                            t_entry.location);
+
+    if (m_isApplicationLogger)
+    {
+        m_stdoutStream << txt << '\n';
+    }
+
+    m_logFileStream << txt << '\n';
+}
+
+bool Logger::requiresFlush(QtMsgType t_type)
+{
+    return t_type == QtWarningMsg || t_type == QtCriticalMsg || t_type == QtFatalMsg;
+}
+
 const char* Logger::resolveMessageType(QtMsgType t_type)
 {
     if (t_type == QtDebugMsg)
@@ -65,24 +274,36 @@ const char* Logger::resolveMessageType(QtMsgType t_type)
     return "[UNKNOWN]  ";
 }
 
-void Logger::logHandler(QtMsgType t_type, const QMessageLogContext& t_context, const QString& t_msg)
+void Logger::write(QtMsgType t_type, const QString& t_message, const QString& t_location)
 {
-    QString txt = t_msg;
-    txt.prepend(" - ");
+    Entry* entry = new Entry();
+    entry->type = t_type;
+    entry->time = QDateTime::currentDateTime();
+    entry->message = t_message;
+    entry->location = t_location;
 
-    QDateTime date;
-    txt.prepend(date.currentDateTime().toString());
+    push(entry);
 
-    txt.prepend(resolveMessageType(t_type));
+    if (m_stopped)
+    {
+        QMutexLocker locker(&m_writerMutex);
+        writePendingEntries();
+    }
+    else if (requiresFlush(t_type))
+    {
+        requestFlush();
+    }
+}
+
+void Logger::logHandler(QtMsgType t_type, const QMessageLogContext& t_context, const QString& t_msg)
+{
+    QString location;
 
 #ifdef QT_DEBUG
-    txt.append(" (");
-    txt.append(QFileInfo(t_context.file).fileName());
-    txt.append(":");
-    txt.append(QString::number(t_context.line));
-    txt.append(")");
+    location = QString(" (%1:%2)").arg(QFileInfo(t_context.file).fileName(), QString::number(t_context.line));
+#else
+    Q_UNUSED(t_context);
 #endif
 
-    getInstance().m_stdoutStream << txt << endl << flush;
-    getInstance().m_logFileStream << txt << endl << flush;
+    getInstance().write(t_type, t_msg, location);
 }
@@ -5,23 +5,52 @@
 
 #pragma once
 
+#include <atomic>
+
 #include <QFile>
 #include <QTextStream>
+#include <QDateTime>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
 
 #define logStringFormat(message, ...) QString(message)__VA_ARGS__.toStdString().c_str()
 
-#define logDebug(message, ...) qDebug(logStringFormat(message, ##__VA_ARGS__))
-#define logInfo(message, ...) qInfo(logStringFormat(message, ##__VA_ARGS__))
-#define logWarning(message, ...) qWarning(logStringFormat(message, ##__VA_ARGS__))
-#define logCritical(message, ...) qCritical(logStringFormat(message, ##__VA_ARGS__))
+// Message and its arguments are evaluated only when the level is enabled.
+#define logLevelGated(type, function, message, ...) \
+    do { if (Logger::isEnabled(type)) { function(logStringFormat(message, ##__VA_ARGS__)); } } while (0)
+
+#define logDebug(message, ...) logLevelGated(QtDebugMsg, qDebug, message, ##__VA_ARGS__)
+#define logInfo(message, ...) logLevelGated(QtInfoMsg, qInfo, message, ##__VA_ARGS__)
+#define logWarning(message, ...) logLevelGated(QtWarningMsg, qWarning, message, ##__VA_ARGS__)
+#define logCritical(message, ...) logLevelGated(QtCriticalMsg, qCritical, message, ##__VA_ARGS__)
 
+/**
+ * @brief
+ * Writes log messages to the log file and stdout.
+ *
+ * @details
+ * Messages are put on a lock-free queue by the logging threads and written in batches
+ * by a background writer thread, which flushes the streams every Config::logFlushIntervalMsec.
+ * Warnings, critical and fatal messages are flushed before the logging call returns.
+ */
 class Logger
 {
     Logger();
+    Logger(const QString& t_logFilePath, bool t_isApplicationLogger);
 public:
+    /**
+     * @brief Logger
+     *
+     * Logger writing only to t_logFilePath, it doesn't receive Qt messages - messages are passed to write.
+     */
+    explicit Logger(const QString& t_logFilePath);
+
     Logger(Logger const&) = delete;
     void operator=(Logger const&) = delete;
 
+    ~Logger();
+
     static Logger& getInstance()
     {
         static Logger instance;
@@ -34,13 +63,120 @@ public:
         getInstance();
     }
 
+    /**
+     * @brief shutdown
+     *
+     * Writes all pending messages and stops the writer thread. Messages logged afterwards are written synchronously.
+     */
+    static void shutdown()
+    {
+        getInstance().stopWriter();
+    }
+
+    /**
+     * @brief write
+     *
+     * Queues the message for the writer thread, messages which require a flush are on disk when it returns.
+     */
+    void write(QtMsgType t_type, const QString& t_message, const QString& t_location = QString());
+
+    // Same as shutdown, for this logger.
+    void stopWriter();
+
+    /**
+     * @brief isEnabled
+     *
+     * @return
+     * Whether messages of t_type are at or above the minimum level. Cheap enough to be checked on every logging call.
+     */
+    static bool isEnabled(QtMsgType t_type)
+    {
+        return severity(t_type) >= m_minimumSeverity.load(std::memory_order_relaxed);
+    }
+
+    static void setMinimumLevel(QtMsgType t_type)
+    {
+        m_minimumSeverity.store(severity(t_type), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief parseLevel
+     *
+     * Reads level name - debug, info, warning or critical.
+     *
+     * @return
+     * True if t_name is a valid level name.
+     */
+    static bool parseLevel(const QString& t_name, QtMsgType& t_type);
+
     static QString adjustSecretForLog(const QString& t_secret);
     static QString adjustSecretForLog(const char* t_secret);
 private:
+    static std::atomic<int> m_minimumSeverity;
+
+    // QtMsgType values aren't ordered by severity - QtInfoMsg was added after the others.
+    static int severity(QtMsgType t_type)
+    {
+        switch (t_type)
+        {
+        case QtDebugMsg:
+            return 0;
+        case QtInfoMsg:
+            return 1;
+        case QtWarningMsg:
+            return 2;
+        case QtCriticalMsg:
+            return 3;
+        default:
+            return 4;
+        }
+    }
+
+    struct Entry
+    {
+        QtMsgType type;
+        QDateTime time;
+        QString message;
+        QString location;
+        Entry* next;
+    };
+
+    class Writer : public QThread
+    {
+    public:
+        Writer(Logger& t_logger);
+
+    protected:
+        void run() override;
+
+    private:
+        Logger& m_logger;
+    };
+
     QFile m_logFile;
     QTextStream m_logFileStream;
     QTextStream m_stdoutStream;
 
+    std::atomic<Entry*> m_pendingEntries;
+    std::atomic<bool> m_stopped;
+    bool m_isApplicationLogger;
+
+    QMutex m_writerMutex;
+    QWaitCondition m_flushRequested;
+    QWaitCondition m_flushCompleted;
+    quint64 m_flushRequestCount;
+    quint64 m_flushCompletedCount;
+    bool m_stopRequested;
+
+    Writer m_writer;
+
+    void push(Entry* t_entry);
+    void requestFlush();
+
+    void writePendingEntries();
+    void writeEntry(const Entry& t_entry);
+
+    static bool requiresFlush(QtMsgType t_type);
     static const char* resolveMessageType(QtMsgType t_type);
     static void logHandler(QtMsgType t_type, const QMessageLogContext& t_context, const QString& t_msg);
 };
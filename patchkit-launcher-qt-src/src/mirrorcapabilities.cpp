@@ -0,0 +1,189 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "mirrorcapabilities.h"
+
+#include <QNetworkReply>
+#include <QUrl>
+
+#include "byteranges.h"
+#include "logger.h"
+
+MirrorCapabilities::Response MirrorCapabilities::Response::fromReply(QNetworkReply& t_reply)
+{
+    Response response;
+
+    response.rangeRequested = t_reply.request().hasRawHeader("Range");
+    response.statusCode = t_reply.attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    response.acceptRanges = t_reply.rawHeader("Accept-Ranges");
+    response.contentType = t_reply.rawHeader("Content-Type");
+    response.contentRange = t_reply.rawHeader("Content-Range");
+    response.contentEncoding = t_reply.rawHeader("Content-Encoding");
+
+    QVariant contentLength = t_reply.header(QNetworkRequest::ContentLengthHeader);
+
+    if (contentLength.isValid())
+    {
+        response.contentLength = contentLength.toLongLong();
+    }
+
+    return response;
+}
+
+void MirrorCapabilities::recordResponse(const QString& t_url, const Response& t_response)
+{
+    QString host = getHost(t_url);
+
+    if (host.isEmpty())
+    {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    Capabilities& capabilities = m_capabilities[host];
+    RangeSupport previousRangeSupport = capabilities.rangeSupport;
+
+    if (t_response.rangeRequested && t_response.statusCode == 206)
+    {
+        qint64 first;
+        qint64 last;
+        qint64 totalSize;
+
+        capabilities.isRangeSupportConfirmed = true;
+
+        if (ByteRanges::isMultipart(t_response.contentType))
+        {
+            capabilities.rangeSupport = Supported;
+        }
+        else if (ByteRanges::parseContentRange(t_response.contentRange, first, last, totalSize))
+        {
+            capabilities.rangeSupport = Supported;
+
+            if (totalSize >= 0)
+            {
+                m_contentSizes[t_url] = totalSize;
+            }
+        }
+        else
+        {
+            capabilities.rangeSupport = Unsupported;
+        }
+    }
+    else if (t_response.statusCode == 200)
+    {
+        QByteArray contentEncoding = t_response.contentEncoding.trimmed().toLower();
+
+        if (t_response.contentLength >= 0 && (contentEncoding.isEmpty() || contentEncoding == "identity"))
+        {
+            m_contentSizes[t_url] = t_response.contentLength;
+        }
+
+        if (t_response.rangeRequested)
+        {
+            capabilities.rangeSupport = Unsupported;
+            capabilities.isRangeSupportConfirmed = true;
+        }
+        else if (!capabilities.isRangeSupportConfirmed)
+        {
+            QByteArray acceptRanges = t_response.acceptRanges.trimmed().toLower();
+
+            if (acceptRanges == "bytes")
+            {
+                capabilities.rangeSupport = Supported;
+            }
+            else if (acceptRanges == "none")
+            {
+                capabilities.rangeSupport = Unsupported;
+            }
+        }
+    }
+
+    if (capabilities.rangeSupport != previousRangeSupport)
+    {
+        logInfo("Mirror %1 %2 Range requests.",
+                .arg(host, QString(capabilities.rangeSupport == Supported ? "supports" : "doesn't support")));
+    }
+}
+
+MirrorCapabilities::RangeSupport MirrorCapabilities::getRangeSupport(const QString& t_url) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_capabilities.value(getHost(t_url)).rangeSupport;
+}
+
+qint64 MirrorCapabilities::getContentSize(const QString& t_url) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_contentSizes.value(t_url, -1);
+}
+
+QStringList MirrorCapabilities::planRangeDownloads(const QStringList& t_urls) const
+{
+    QStringList supported;
+    QStringList unknown;
+    QStringList unsupported;
+
+    for (const QString& url : t_urls)
+    {
+        switch (getRangeSupport(url))
+        {
+        case Supported:
+            supported.append(url);
+            break;
+        case Unsupported:
+            unsupported.append(url);
+            break;
+        default:
+            unknown.append(url);
+            break;
+        }
+    }
+
+    return supported + unknown + unsupported;
+}
+
+void MirrorCapabilities::reportHttp2Failure(const QString& t_url)
+{
+    QString host = getHost(t_url);
+
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_http2FailedHosts.contains(host))
+    {
+        logWarning("HTTP/2 has failed with %1, falling back to HTTP/1.1.", .arg(host));
+        m_http2FailedHosts.insert(host);
+    }
+}
+
+bool MirrorCapabilities::isHttp2Allowed(const QString& t_url) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return !m_http2FailedHosts.contains(getHost(t_url));
+}
+
+void MirrorCapabilities::clear()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_capabilities.clear();
+    m_contentSizes.clear();
+    m_http2FailedHosts.clear();
+}
+
+QString MirrorCapabilities::getHost(const QString& t_url)
+{
+    QUrl url(t_url);
+
+    if (url.port() == -1)
+    {
+        return url.host();
+    }
+
+    return url.host() + ":" + QString::number(url.port());
+}
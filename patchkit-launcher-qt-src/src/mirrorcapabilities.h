@@ -0,0 +1,118 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#ifndef MIRRORCAPABILITIES_H
+#define MIRRORCAPABILITIES_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+
+class QNetworkReply;
+
+/**
+ * @brief
+ * Remembers which mirrors honor Range requests, for the duration of the launcher run.
+ *
+ * @details
+ * Mirrors aren't probed with extra requests, every reply of a content download is a probe:
+ * - 206 with a valid Content-Range (or a multipart body) to a Range request - ranges are supported,
+ * - 200 to a Range request or 206 with a broken Content-Range - ranges are not supported,
+ * - 200 to a plain request - the Accept-Ranges header is taken as a hint until a Range request proves otherwise.
+ *
+ * Range support is tracked per host, as it's a property of the server software. The size of the content
+ * (from Content-Range or Content-Length) is remembered per url. Content-Length of an encoded reply is the size
+ * of the encoded body, so it isn't taken as the size of the content.
+ *
+ * Hosts which have failed with HTTP/2 are remembered as well, so that further requests fall back to HTTP/1.1.
+ *
+ * Replies of urls without a host (e.g. from tests) aren't recorded.
+ */
+class MirrorCapabilities
+{
+public:
+    enum RangeSupport
+    {
+        Unknown,
+        Supported,
+        Unsupported
+    };
+
+    struct Response
+    {
+        Response()
+            : rangeRequested(false)
+            , statusCode(-1)
+            , contentLength(-1)
+        {
+        }
+
+        static Response fromReply(QNetworkReply& t_reply);
+
+        bool        rangeRequested;
+        int         statusCode;
+        QByteArray  acceptRanges;
+        QByteArray  contentType;
+        QByteArray  contentRange;
+        QByteArray  contentEncoding;
+        qint64      contentLength;
+    };
+
+    static MirrorCapabilities& getInstance()
+    {
+        static MirrorCapabilities instance;
+
+        return instance;
+    }
+
+    void            recordResponse(const QString& t_url, const Response& t_response);
+
+    RangeSupport    getRangeSupport(const QString& t_url) const;
+
+    /**
+     * @brief getContentSize
+     *
+     * @return
+     * Size of the whole content served under the url, -1 if it's not known.
+     */
+    qint64          getContentSize(const QString& t_url) const;
+
+    /**
+     * @brief planRangeDownloads
+     *
+     * Orders the urls for a download which relies on Range requests - mirrors known to honor them go first,
+     * mirrors known to ignore them go last. Order is kept otherwise.
+     */
+    QStringList     planRangeDownloads(const QStringList& t_urls) const;
+
+    void            reportHttp2Failure(const QString& t_url);
+    bool            isHttp2Allowed(const QString& t_url) const;
+
+    void            clear();
+
+private:
+    struct Capabilities
+    {
+        Capabilities()
+            : rangeSupport(Unknown)
+            , isRangeSupportConfirmed(false)
+        {
+        }
+
+        RangeSupport    rangeSupport;
+        bool            isRangeSupportConfirmed;
+    };
+
+    mutable QMutex                  m_mutex;
+    QHash<QString, Capabilities>    m_capabilities;
+    QHash<QString, qint64>          m_contentSizes;
+    QSet<QString>                   m_http2FailedHosts;
+
+    static QString getHost(const QString& t_url);
+};
+
+#endif // MIRRORCAPABILITIES_H
@@ -0,0 +1,139 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "multipartreader.h"
+
+#include <QList>
+
+#include <stdexcept>
+
+#include "byteranges.h"
+
+const int MultipartReader::maxHeadersSize = 16 * 1024;
+
+MultipartReader::MultipartReader(const QByteArray& t_boundary, const TPartHandler& t_partHandler, const TDataHandler& t_dataHandler)
+    : m_delimiter("--" + t_boundary)
+    , m_partHandler(t_partHandler)
+    , m_dataHandler(t_dataHandler)
+    , m_partBytesLeft(0)
+    , m_isFinished(false)
+{
+}
+
+bool MultipartReader::read(const QByteArray& t_data)
+{
+    QByteArray input = t_data;
+    int position = 0;
+
+    while (position < input.size() && !m_isFinished)
+    {
+        if (m_partBytesLeft > 0)
+        {
+            int length = int(qMin<qint64>(m_partBytesLeft, input.size() - position));
+
+            m_partBytesLeft -= length;
+
+            bool proceed = m_dataHandler(QByteArray::fromRawData(input.constData() + position, length));
+
+            position += length;
+
+            if (!proceed)
+            {
+                return false;
+            }
+
+            continue;
+        }
+
+        m_buffer.append(input.constData() + position, input.size() - position);
+        position = input.size();
+
+        if (!readHeaders())
+        {
+            break;
+        }
+
+        // Whatever follows the headers is data of the new part.
+        input = m_buffer;
+        position = 0;
+        m_buffer.clear();
+    }
+
+    return true;
+}
+
+bool MultipartReader::isFinished() const
+{
+    return m_isFinished;
+}
+
+bool MultipartReader::readHeaders()
+{
+    int delimiterIndex = m_buffer.indexOf(m_delimiter);
+
+    // Only the gap before the delimiter and the headers are buffered, data of the part may follow in the same read.
+    if (delimiterIndex < 0)
+    {
+        if (m_buffer.size() > maxHeadersSize)
+        {
+            throw std::runtime_error("Malformed multipart response.");
+        }
+
+        return false;
+    }
+
+    int headersStart = delimiterIndex + m_delimiter.size();
+
+    if (m_buffer.size() < headersStart + 2)
+    {
+        return false;
+    }
+
+    if (m_buffer.mid(headersStart, 2) == "--")
+    {
+        m_isFinished = true;
+        m_buffer.clear();
+        return true;
+    }
+
+    int headersEnd = m_buffer.indexOf("\r\n\r\n", headersStart);
+
+    if (headersEnd < 0)
+    {
+        if (m_buffer.size() - delimiterIndex > maxHeadersSize)
+        {
+            throw std::runtime_error("Malformed multipart response.");
+        }
+
+        return false;
+    }
+
+    bool hasContentRange = false;
+    qint64 first = 0;
+    qint64 last = 0;
+    qint64 totalSize = 0;
+
+    for (const QByteArray& line : m_buffer.mid(headersStart, headersEnd - headersStart).split('\n'))
+    {
+        int separator = line.indexOf(':');
+
+        if (separator > 0 && line.left(separator).trimmed().toLower() == "content-range")
+        {
+            hasContentRange = ByteRanges::parseContentRange(line.mid(separator + 1), first, last, totalSize);
+        }
+    }
+
+    if (!hasContentRange)
+    {
+        throw std::runtime_error("Malformed multipart response.");
+    }
+
+    m_buffer.remove(0, headersEnd + 4);
+    m_partBytesLeft = last - first + 1;
+
+    m_partHandler(first);
+
+    return true;
+}
@@ -0,0 +1,58 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#ifndef MULTIPARTREADER_H
+#define MULTIPARTREADER_H
+
+#include <QByteArray>
+
+#include <functional>
+
+/**
+ * @brief
+ * Incrementally reads a "multipart/byteranges" response body.
+ *
+ * @details
+ * The body can be passed in pieces of any size, as they are received. Whenever a part begins
+ * the part handler is called with the offset of the part in the file (from its Content-Range header),
+ * then the part data is passed to the data handler. Part data is never buffered.
+ */
+class MultipartReader
+{
+public:
+    typedef std::function<void(qint64)> TPartHandler;
+
+    // Returning false stops reading.
+    typedef std::function<bool(const QByteArray&)> TDataHandler;
+
+    MultipartReader(const QByteArray& t_boundary, const TPartHandler& t_partHandler, const TDataHandler& t_dataHandler);
+
+    /**
+     * @brief read
+     *
+     * Throws if the body is malformed.
+     *
+     * @return
+     * False if the data handler has stopped reading.
+     */
+    bool read(const QByteArray& t_data);
+
+    bool isFinished() const;
+
+private:
+    const static int maxHeadersSize;
+
+    QByteArray      m_delimiter;
+    TPartHandler    m_partHandler;
+    TDataHandler    m_dataHandler;
+
+    QByteArray      m_buffer;
+    qint64          m_partBytesLeft;
+    bool            m_isFinished;
+
+    bool readHeaders();
+};
+
+#endif // MULTIPARTREADER_H
@@ -0,0 +1,92 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "options.h"
+
+#include <QCoreApplication>
+
+#include "config.h"
+#include "logger.h"
+
+Options::Options()
+{
+    QStringList arguments;
+
+    if (QCoreApplication::instance())
+    {
+        arguments = QCoreApplication::arguments();
+    }
+
+    m_passedArguments = arguments.mid(1);
+
+    m_isPeerSharingEnabled = hasFlag(arguments, Config::peerSharingArg);
+    m_peerSharingInterface = readValue(arguments, Config::peerSharingInterfaceArg);
+    m_isPrefetchEnabled = hasFlag(arguments, Config::prefetchArg);
+    m_isPrefetchHelper = hasFlag(arguments, Config::prefetchHelperArg);
+    m_isHttp2Enabled = hasFlag(arguments, Config::http2Arg);
+    m_isFastLaunchEnabled = hasFlag(arguments, Config::fastLaunchArg);
+    m_telemetryReportPath = readValue(arguments, Config::telemetryReportArg);
+    m_logLevel = readLogLevel(arguments);
+    m_downloadRateLimit = readRateLimit(arguments, Config::downloadRateLimitArg, 0);
+    m_backgroundDownloadRateLimit = readRateLimit(arguments, Config::backgroundDownloadRateLimitArg,
+                                                  Config::defaultBackgroundDownloadRateLimit);
+}
+
+bool Options::hasFlag(const QStringList& t_arguments, const QString& t_flag)
+{
+    return t_arguments.contains(t_flag);
+}
+
+QString Options::readValue(const QStringList& t_arguments, const QString& t_option)
+{
+    // Options with values are passed as --option=value
+    QString prefix = t_option + "=";
+
+    for (const QString& argument : t_arguments)
+    {
+        if (argument.startsWith(prefix))
+        {
+            return argument.mid(prefix.size());
+        }
+    }
+
+    return QString();
+}
+
+QtMsgType Options::readLogLevel(const QStringList& t_arguments)
+{
+    QString value = readValue(t_arguments, Config::logLevelArg);
+
+    QtMsgType logLevel = QtDebugMsg;
+
+    if (!value.isEmpty() && !Logger::parseLevel(value, logLevel))
+    {
+        logWarning("Invalid value of %1 - %2", .arg(Config::logLevelArg, value));
+    }
+
+    return logLevel;
+}
+
+qint64 Options::readRateLimit(const QStringList& t_arguments, const QString& t_option, qint64 t_defaultBytesPerSecond)
+{
+    QString value = readValue(t_arguments, t_option);
+
+    if (value.isEmpty())
+    {
+        return t_defaultBytesPerSecond;
+    }
+
+    // Limits are given in kilobytes per second, 0 disables the limit.
+    bool ok;
+    qint64 kilobytesPerSecond = value.toLongLong(&ok);
+
+    if (!ok || kilobytesPerSecond < 0)
+    {
+        logWarning("Invalid value of %1 - %2", .arg(t_option, value));
+        return t_defaultBytesPerSecond;
+    }
+
+    return kilobytesPerSecond * 1024;
+}
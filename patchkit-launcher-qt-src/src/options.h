@@ -0,0 +1,119 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <QStringList>
+#include <QtGlobal>
+
+/**
+ * @brief
+ * Runtime options of the launcher, read once from the command line arguments.
+ *
+ * @note
+ * Compile-time constants live in Config, this class only holds what the user can opt-in to.
+ */
+class Options
+{
+    Options();
+public:
+    Options(Options const&) = delete;
+    void operator=(Options const&) = delete;
+
+    static Options& getInstance()
+    {
+        static Options instance;
+
+        return instance;
+    }
+
+    bool isPeerSharingEnabled() const
+    {
+        return m_isPeerSharingEnabled;
+    }
+
+    /**
+     * @brief getPeerSharingInterface
+     *
+     * @return
+     * Address of the interface peer sharing is restricted to, empty if all interfaces are used.
+     */
+    QString getPeerSharingInterface() const
+    {
+        return m_peerSharingInterface;
+    }
+
+    bool isPrefetchEnabled() const
+    {
+        return m_isPrefetchEnabled;
+    }
+
+    bool isPrefetchHelper() const
+    {
+        return m_isPrefetchHelper;
+    }
+
+    bool isHttp2Enabled() const
+    {
+        return m_isHttp2Enabled;
+    }
+
+    bool isFastLaunchEnabled() const
+    {
+        return m_isFastLaunchEnabled;
+    }
+
+    /**
+     * @brief getPassedArguments
+     *
+     * @return
+     * Command line arguments without the executable path, used to pass options to spawned launcher processes.
+     */
+    QStringList getPassedArguments() const
+    {
+        return m_passedArguments;
+    }
+
+    QString getTelemetryReportPath() const
+    {
+        return m_telemetryReportPath;
+    }
+
+    QtMsgType getLogLevel() const
+    {
+        return m_logLevel;
+    }
+
+    qint64 getDownloadRateLimit() const
+    {
+        return m_downloadRateLimit;
+    }
+
+    qint64 getBackgroundDownloadRateLimit() const
+    {
+        return m_backgroundDownloadRateLimit;
+    }
+
+private:
+    bool m_isPeerSharingEnabled;
+    QString m_peerSharingInterface;
+    bool m_isPrefetchEnabled;
+    bool m_isPrefetchHelper;
+    bool m_isHttp2Enabled;
+    bool m_isFastLaunchEnabled;
+    QStringList m_passedArguments;
+    QString m_telemetryReportPath;
+    QtMsgType m_logLevel;
+    qint64 m_downloadRateLimit;
+    qint64 m_backgroundDownloadRateLimit;
+
+    static bool hasFlag(const QStringList& t_arguments, const QString& t_flag);
+    static QString readValue(const QStringList& t_arguments, const QString& t_option);
+    static QtMsgType readLogLevel(const QStringList& t_arguments);
+    static qint64 readRateLimit(const QStringList& t_arguments, const QString& t_option, qint64 t_defaultBytesPerSecond);
+};
+
+#endif // OPTIONS_H
@@ -0,0 +1,297 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "peerchunkserver.h"
+
+#include <QTcpSocket>
+#include <QNetworkInterface>
+#include <QDir>
+
+#include "logger.h"
+#include "byteranges.h"
+
+const int    PeerChunkServer::maxRequestSize  = 8192;
+const qint64 PeerChunkServer::pieceSize       = 64 * 1024;
+const qint64 PeerChunkServer::maxBytesToWrite = 4 * 64 * 1024;
+
+PeerChunkServer::PeerChunkServer(const QString& t_cacheDirPath, QObject* t_parent)
+    : QTcpServer(t_parent)
+    , m_cacheDirPath(t_cacheDirPath)
+    , m_interfaceAddress(QHostAddress::AnyIPv4)
+{
+    connect(this, &QTcpServer::newConnection, this, &PeerChunkServer::onNewConnection);
+}
+
+bool PeerChunkServer::start(const QHostAddress& t_interfaceAddress, quint16 t_port)
+{
+    m_interfaceAddress = t_interfaceAddress;
+
+    if (!listen(t_interfaceAddress, t_port))
+    {
+        logWarning("Couldn't start peer chunk server - %1", .arg(errorString()));
+        return false;
+    }
+
+    logInfo("Peer chunk server is listening on %1, port %2.", .arg(t_interfaceAddress.toString(), QString::number(serverPort())));
+    return true;
+}
+
+bool PeerChunkServer::isValidContentId(const QString& t_contentId)
+{
+    if (t_contentId.isEmpty())
+    {
+        return false;
+    }
+
+    // Content ids are used as file names, so anything except hex digits is rejected.
+    for (QChar c : t_contentId)
+    {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f')))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool PeerChunkServer::isLocalPeer(const QHostAddress& t_peerAddress, const QHostAddress& t_interfaceAddress)
+{
+    if (t_peerAddress.isLoopback())
+    {
+        return true;
+    }
+
+    bool isAnyInterface = t_interfaceAddress == QHostAddress(QHostAddress::AnyIPv4) || t_interfaceAddress == QHostAddress(QHostAddress::Any);
+
+    for (const QNetworkInterface& networkInterface : QNetworkInterface::allInterfaces())
+    {
+        if (!networkInterface.flags().testFlag(QNetworkInterface::IsUp))
+        {
+            continue;
+        }
+
+        for (const QNetworkAddressEntry& entry : networkInterface.addressEntries())
+        {
+            if (!isAnyInterface && entry.ip() != t_interfaceAddress)
+            {
+                continue;
+            }
+
+            // Prefix length isn't known on some platforms, such an interface doesn't define a subnet.
+            if (entry.prefixLength() < 0)
+            {
+                continue;
+            }
+
+            if (t_peerAddress.isInSubnet(entry.ip(), entry.prefixLength()))
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void PeerChunkServer::onNewConnection()
+{
+    while (hasPendingConnections())
+    {
+        QTcpSocket* socket = nextPendingConnection();
+
+        if (!isLocalPeer(socket->peerAddress(), m_interfaceAddress))
+        {
+            logWarning("Rejecting peer connection from %1, it isn't in a local subnet.", .arg(socket->peerAddress().toString()));
+
+            socket->abort();
+            socket->deleteLater();
+            continue;
+        }
+
+        m_transfers.insert(socket, Transfer());
+
+        connect(socket, &QTcpSocket::readyRead, this, &PeerChunkServer::onReadyRead);
+        connect(socket, &QTcpSocket::bytesWritten, this, &PeerChunkServer::onBytesWritten);
+        connect(socket, &QTcpSocket::disconnected, this, &PeerChunkServer::onDisconnected);
+    }
+}
+
+void PeerChunkServer::onReadyRead()
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+
+    if (!socket || !m_transfers.contains(socket))
+    {
+        return;
+    }
+
+    Transfer& transfer = m_transfers[socket];
+
+    if (transfer.isResponding)
+    {
+        socket->readAll();
+        return;
+    }
+
+    transfer.request += socket->readAll();
+
+    if (transfer.request.contains("\r\n\r\n"))
+    {
+        transfer.isResponding = true;
+        handleRequest(socket, transfer);
+    }
+    else if (transfer.request.size() > maxRequestSize)
+    {
+        transfer.isResponding = true;
+        respondWithError(socket, 400, "Bad Request");
+    }
+}
+
+void PeerChunkServer::onBytesWritten()
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+
+    if (!socket || !m_transfers.contains(socket))
+    {
+        return;
+    }
+
+    writePieces(socket, m_transfers[socket]);
+}
+
+void PeerChunkServer::onDisconnected()
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+
+    if (!socket)
+    {
+        return;
+    }
+
+    m_transfers.remove(socket);
+    socket->deleteLater();
+}
+
+void PeerChunkServer::handleRequest(QTcpSocket* t_socket, Transfer& t_transfer)
+{
+    QList<QByteArray> lines = t_transfer.request.split('\n');
+    QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+
+    if (requestLine.size() < 2 || requestLine[0] != "GET")
+    {
+        respondWithError(t_socket, 400, "Bad Request");
+        return;
+    }
+
+    QString contentId = QString::fromLatin1(requestLine[1]).mid(1);
+
+    if (!isValidContentId(contentId))
+    {
+        respondWithError(t_socket, 404, "Not Found");
+        return;
+    }
+
+    t_transfer.file = std::make_shared<QFile>(QDir::cleanPath(m_cacheDirPath + "/" + contentId));
+
+    if (!t_transfer.file->open(QIODevice::ReadOnly))
+    {
+        respondWithError(t_socket, 404, "Not Found");
+        return;
+    }
+
+    qint64 fileSize = t_transfer.file->size();
+    qint64 start = 0;
+    qint64 end = fileSize - 1;
+    bool isRangeRequest = false;
+
+    for (const QByteArray& line : lines)
+    {
+        if (line.toLower().startsWith("range:"))
+        {
+            QVector<ByteRanges::TRange> ranges;
+
+            // Only the first of several ranges is served, the downloader requests the rest again.
+            if (!ByteRanges::parseRangeHeader(line.mid(6), fileSize, ranges))
+            {
+                respondWithError(t_socket, 416, "Range Not Satisfiable");
+                return;
+            }
+
+            start = ranges.first().first;
+            end = ranges.first().second;
+
+            isRangeRequest = true;
+        }
+    }
+
+    logInfo("Serving %1 to peer %2, bytes %3-%4.",
+            .arg(contentId, t_socket->peerAddress().toString(), QString::number(start), QString::number(end)));
+
+    QByteArray header;
+
+    if (isRangeRequest)
+    {
+        header += "HTTP/1.1 206 Partial Content\r\n";
+        header += "Content-Range: bytes " + QByteArray::number(start) + "-" + QByteArray::number(end)
+                + "/" + QByteArray::number(fileSize) + "\r\n";
+    }
+    else
+    {
+        header += "HTTP/1.1 200 OK\r\n";
+    }
+
+    header += "Content-Type: application/octet-stream\r\n";
+    header += "Content-Length: " + QByteArray::number(end - start + 1) + "\r\n";
+    header += "Accept-Ranges: bytes\r\n";
+    header += "Connection: close\r\n\r\n";
+
+    t_socket->write(header);
+
+    t_transfer.file->seek(start);
+    t_transfer.bytesRemaining = end - start + 1;
+
+    writePieces(t_socket, t_transfer);
+}
+
+void PeerChunkServer::respondWithError(QTcpSocket* t_socket, int t_statusCode, const QByteArray& t_reason)
+{
+    QByteArray response = "HTTP/1.1 " + QByteArray::number(t_statusCode) + " " + t_reason + "\r\n"
+                        + "Content-Length: 0\r\n"
+                        + "Connection: close\r\n\r\n";
+
+    t_socket->write(response);
+    t_socket->disconnectFromHost();
+}
+
+void PeerChunkServer::writePieces(QTcpSocket* t_socket, Transfer& t_transfer)
+{
+    if (!t_transfer.file)
+    {
+        return;
+    }
+
+    // Keep the socket buffer filled only up to a limit, so serving a large archive never loads it into memory.
+    while (t_transfer.bytesRemaining > 0 && t_socket->bytesToWrite() < maxBytesToWrite)
+    {
+        QByteArray piece = t_transfer.file->read(qMin(pieceSize, t_transfer.bytesRemaining));
+
+        if (piece.isEmpty())
+        {
+            logWarning("Couldn't read peer cache file - %1", .arg(t_transfer.file->fileName()));
+            t_socket->abort();
+            return;
+        }
+
+        t_transfer.bytesRemaining -= piece.size();
+        t_socket->write(piece);
+    }
+
+    if (t_transfer.bytesRemaining == 0)
+    {
+        t_transfer.file.reset();
+        t_socket->disconnectFromHost();
+    }
+}
@@ -0,0 +1,86 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#ifndef PEERCHUNKSERVER_H
+#define PEERCHUNKSERVER_H
+
+#include <QTcpServer>
+#include <QHostAddress>
+#include <QHash>
+#include <QFile>
+#include <memory>
+
+class QTcpSocket;
+
+/**
+ * @brief
+ * Serves patcher archives stored in the peer cache to other launchers in the local network.
+ *
+ * @details
+ * The server speaks a minimal subset of HTTP/1.1 - a single GET request per connection,
+ * with optional "Range: bytes=start-" or "Range: bytes=start-end" header. The request path
+ * is the content id of the archive (hex encoded hash code of its Content Summary).
+ *
+ * Served data is not trusted by the receiving side, it is validated chunk by chunk
+ * against the Content Summary by the ChunkedDownloader just like data from content urls.
+ *
+ * The server listens on t_interfaceAddress (all interfaces by default) and accepts connections only from
+ * loopback and the subnets of the local interfaces - or of the given interface only, see isLocalPeer.
+ */
+class PeerChunkServer : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    PeerChunkServer(const QString& t_cacheDirPath, QObject* t_parent = nullptr);
+
+    bool start(const QHostAddress& t_interfaceAddress = QHostAddress::AnyIPv4, quint16 t_port = 0);
+
+    static bool isValidContentId(const QString& t_contentId);
+
+    /**
+     * @brief isLocalPeer
+     *
+     * Whether t_peerAddress is a loopback address or belongs to the subnet of an interface of this machine
+     * which is up. With t_interfaceAddress other than QHostAddress::AnyIPv4 only the subnet of that interface counts.
+     */
+    static bool isLocalPeer(const QHostAddress& t_peerAddress, const QHostAddress& t_interfaceAddress = QHostAddress::AnyIPv4);
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+    void onBytesWritten();
+    void onDisconnected();
+
+private:
+    struct Transfer
+    {
+        Transfer()
+            : bytesRemaining(0)
+            , isResponding(false)
+        {
+        }
+
+        QByteArray                  request;
+        std::shared_ptr<QFile>      file;
+        qint64                      bytesRemaining;
+        bool                        isResponding;
+    };
+
+    const static int    maxRequestSize;
+    const static qint64 pieceSize;
+    const static qint64 maxBytesToWrite;
+
+    QString                         m_cacheDirPath;
+    QHostAddress                    m_interfaceAddress;
+    QHash<QTcpSocket*, Transfer>    m_transfers;
+
+    void handleRequest(QTcpSocket* t_socket, Transfer& t_transfer);
+    void respondWithError(QTcpSocket* t_socket, int t_statusCode, const QByteArray& t_reason);
+    void writePieces(QTcpSocket* t_socket, Transfer& t_transfer);
+
+};
+
+#endif // PEERCHUNKSERVER_H
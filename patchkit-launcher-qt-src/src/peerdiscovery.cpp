@@ -0,0 +1,160 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "peerdiscovery.h"
+
+#include <QEventLoop>
+#include <QTimer>
+#include <QFile>
+#include <QDir>
+#include <QUrl>
+
+#include "logger.h"
+#include "peerchunkserver.h"
+
+const QByteArray PeerDiscovery::queryToken = "PKLP1 QUERY";
+const QByteArray PeerDiscovery::replyToken = "PKLP1 HAVE";
+
+PeerDiscovery::PeerDiscovery(quint16 t_discoveryPort, const QHostAddress& t_targetAddress, QObject* t_parent)
+    : QObject(t_parent)
+    , m_discoveryPort(t_discoveryPort)
+    , m_targetAddress(t_targetAddress)
+    , m_serverPort(0)
+    , m_interfaceAddress(QHostAddress::AnyIPv4)
+    , m_responderSocket(this)
+{
+    connect(&m_responderSocket, &QUdpSocket::readyRead, this, &PeerDiscovery::onQueryReceived);
+}
+
+bool PeerDiscovery::startResponding(const QString& t_cacheDirPath, quint16 t_serverPort, const QHostAddress& t_interfaceAddress)
+{
+    m_cacheDirPath = t_cacheDirPath;
+    m_serverPort = t_serverPort;
+    m_interfaceAddress = t_interfaceAddress;
+
+    if (!m_responderSocket.bind(QHostAddress::AnyIPv4, m_discoveryPort, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint))
+    {
+        logWarning("Couldn't bind peer discovery port %1 - %2", .arg(QString::number(m_discoveryPort), m_responderSocket.errorString()));
+        return false;
+    }
+
+    logInfo("Responding to peer discovery queries on port %1.", .arg(QString::number(m_discoveryPort)));
+    return true;
+}
+
+QStringList PeerDiscovery::findPeers(const QString& t_contentId, int t_timeoutMsec, CancellationToken t_cancellationToken) const
+{
+    logInfo("Looking for peers sharing %1.", .arg(t_contentId));
+
+    QStringList peers;
+    QUdpSocket socket;
+
+    if (!socket.bind(QHostAddress::AnyIPv4, 0))
+    {
+        logWarning("Couldn't bind peer discovery socket - %1", .arg(socket.errorString()));
+        return peers;
+    }
+
+    QEventLoop waitLoop;
+
+    connect(&socket, &QUdpSocket::readyRead, [&socket, &peers, &t_contentId]()
+    {
+        while (socket.hasPendingDatagrams())
+        {
+            QByteArray datagram;
+            datagram.resize(int(socket.pendingDatagramSize()));
+
+            QHostAddress sender;
+            socket.readDatagram(datagram.data(), datagram.size(), &sender);
+
+            QString peer = parseReply(datagram, sender, t_contentId);
+
+            if (!peer.isEmpty() && !peers.contains(peer))
+            {
+                peers.append(peer);
+            }
+        }
+    });
+
+    connect(&t_cancellationToken, &CancellationToken::cancelled, &waitLoop, &QEventLoop::quit);
+    QTimer::singleShot(t_timeoutMsec, &waitLoop, &QEventLoop::quit);
+
+    socket.writeDatagram(queryToken + " " + t_contentId.toLatin1(), m_targetAddress, m_discoveryPort);
+
+    waitLoop.exec();
+
+    t_cancellationToken.throwIfCancelled();
+
+    logInfo("Found %1 peers.", .arg(QString::number(peers.size())));
+
+    return peers;
+}
+
+void PeerDiscovery::onQueryReceived()
+{
+    while (m_responderSocket.hasPendingDatagrams())
+    {
+        QByteArray datagram;
+        datagram.resize(int(m_responderSocket.pendingDatagramSize()));
+
+        QHostAddress sender;
+        quint16 senderPort;
+        m_responderSocket.readDatagram(datagram.data(), datagram.size(), &sender, &senderPort);
+
+        if (!datagram.startsWith(queryToken + " ") || !PeerChunkServer::isLocalPeer(sender, m_interfaceAddress))
+        {
+            continue;
+        }
+
+        QString contentId = QString::fromLatin1(datagram.mid(queryToken.size() + 1)).trimmed();
+
+        if (!PeerChunkServer::isValidContentId(contentId))
+        {
+            continue;
+        }
+
+        if (!QFile::exists(QDir::cleanPath(m_cacheDirPath + "/" + contentId)))
+        {
+            continue;
+        }
+
+        logDebug("Answering peer discovery query from %1 for %2.", .arg(sender.toString(), contentId));
+
+        QByteArray reply = replyToken + " " + contentId.toLatin1() + " " + QByteArray::number(m_serverPort);
+        m_responderSocket.writeDatagram(reply, sender, senderPort);
+    }
+}
+
+QString PeerDiscovery::parseReply(const QByteArray& t_datagram, const QHostAddress& t_sender, const QString& t_contentId)
+{
+    // Reply is formulated as so: "PKLP1 HAVE <content id> <port>"
+    if (!t_datagram.startsWith(replyToken + " ") || !PeerChunkServer::isLocalPeer(t_sender))
+    {
+        return QString();
+    }
+
+    QList<QByteArray> tokens = t_datagram.mid(replyToken.size() + 1).trimmed().split(' ');
+
+    if (tokens.size() != 2 || QString::fromLatin1(tokens[0]) != t_contentId)
+    {
+        return QString();
+    }
+
+    bool ok;
+    quint16 port = tokens[1].toUShort(&ok);
+
+    if (!ok || port == 0)
+    {
+        return QString();
+    }
+
+    QUrl url;
+    url.setScheme("http");
+    url.setHost(t_sender.toString());
+    url.setPort(port);
+    url.setPath("/" + t_contentId);
+
+    return url.toString();
+}
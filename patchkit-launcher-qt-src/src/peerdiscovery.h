@@ -0,0 +1,56 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#ifndef PEERDISCOVERY_H
+#define PEERDISCOVERY_H
+
+#include <QObject>
+#include <QUdpSocket>
+#include <QStringList>
+
+#include "cancellationtoken.h"
+
+/**
+ * @brief
+ * Finds other launchers in the local network which can serve a patcher archive.
+ *
+ * @details
+ * Discovery is done with UDP datagrams sent to t_targetAddress (broadcast by default) on the discovery port.
+ * A query carries the content id of the wanted archive, launchers which have it in their peer cache
+ * answer with the port of their PeerChunkServer. Every answer is turned into a content url.
+ *
+ * Several launchers on one machine can respond at the same time, the discovery port is bound with ShareAddress.
+ * Queries and answers from peers outside of the local subnets are ignored, see PeerChunkServer::isLocalPeer.
+ */
+class PeerDiscovery : public QObject
+{
+    Q_OBJECT
+
+public:
+    PeerDiscovery(quint16 t_discoveryPort, const QHostAddress& t_targetAddress = QHostAddress::Broadcast, QObject* t_parent = nullptr);
+
+    bool startResponding(const QString& t_cacheDirPath, quint16 t_serverPort, const QHostAddress& t_interfaceAddress = QHostAddress::AnyIPv4);
+
+    QStringList findPeers(const QString& t_contentId, int t_timeoutMsec, CancellationToken t_cancellationToken) const;
+
+    const static QByteArray queryToken;
+    const static QByteArray replyToken;
+
+private slots:
+    void onQueryReceived();
+
+private:
+    quint16         m_discoveryPort;
+    QHostAddress    m_targetAddress;
+
+    QString         m_cacheDirPath;
+    quint16         m_serverPort;
+    QHostAddress    m_interfaceAddress;
+    QUdpSocket      m_responderSocket;
+
+    static QString parseReply(const QByteArray& t_datagram, const QHostAddress& t_sender, const QString& t_contentId);
+};
+
+#endif // PEERDISCOVERY_H
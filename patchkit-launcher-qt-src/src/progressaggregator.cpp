@@ -0,0 +1,155 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "progressaggregator.h"
+
+#include <QtMath>
+
+#include "config.h"
+
+ProgressAggregator::ProgressAggregator(int t_intervalMsec)
+    : ProgressAggregator(t_intervalMsec, TClock())
+{
+}
+
+ProgressAggregator::ProgressAggregator(int t_intervalMsec, const TClock& t_clock)
+    : m_intervalMsec(t_intervalMsec)
+    , m_clock(t_clock)
+{
+    m_timer.start();
+
+    reset();
+}
+
+bool ProgressAggregator::update(qint64 t_bytesDownloaded, qint64 t_totalBytes)
+{
+    qint64 currentMsec = now();
+
+    bool isComplete = t_totalBytes > 0 && t_bytesDownloaded >= t_totalBytes;
+
+    if (m_hasSample && !isComplete && currentMsec - m_sampleMsec < m_intervalMsec)
+    {
+        return false;
+    }
+
+    // Download restarted from a lower offset (e.g. with another mirror) is measured from the new position.
+    if (m_hasSample && t_bytesDownloaded >= m_sampleBytes && currentMsec > m_sampleMsec)
+    {
+        double bytesPerSecond = (t_bytesDownloaded - m_sampleBytes) * 1000.0 / (currentMsec - m_sampleMsec);
+
+        if (m_bytesPerSecond < 0)
+        {
+            m_bytesPerSecond = bytesPerSecond;
+        }
+        else
+        {
+            m_bytesPerSecond = Config::progressSpeedSmoothingFactor * bytesPerSecond
+                             + (1.0 - Config::progressSpeedSmoothingFactor) * m_bytesPerSecond;
+        }
+    }
+
+    m_hasSample = true;
+    m_sampleMsec = currentMsec;
+    m_sampleBytes = t_bytesDownloaded;
+
+    m_bytesDownloaded = t_bytesDownloaded;
+    m_totalBytes = t_totalBytes;
+
+    int percent = t_totalBytes > 0 ? qBound(0, qCeil((qreal(t_bytesDownloaded) / t_totalBytes) * 100.0), 100) : 0;
+    QString status = formatStatus();
+
+    if (percent == m_percent && status == m_status)
+    {
+        return false;
+    }
+
+    m_percent = percent;
+    m_status = status;
+
+    return true;
+}
+
+void ProgressAggregator::reset()
+{
+    m_hasSample = false;
+    m_sampleMsec = 0;
+    m_sampleBytes = 0;
+    m_bytesPerSecond = -1;
+
+    m_bytesDownloaded = 0;
+    m_totalBytes = 0;
+    m_percent = -1;
+    m_status.clear();
+}
+
+int ProgressAggregator::percent() const
+{
+    return m_percent;
+}
+
+QString ProgressAggregator::status() const
+{
+    return m_status;
+}
+
+double ProgressAggregator::bytesPerSecond() const
+{
+    return m_bytesPerSecond;
+}
+
+qint64 ProgressAggregator::secondsLeft() const
+{
+    if (m_bytesPerSecond <= 0 || m_totalBytes <= 0)
+    {
+        return -1;
+    }
+
+    return qCeil(qMax(qint64(0), m_totalBytes - m_bytesDownloaded) / m_bytesPerSecond);
+}
+
+QString ProgressAggregator::formatSpeed(double t_bytesPerSecond)
+{
+    if (t_bytesPerSecond >= 1024.0 * 1024.0)
+    {
+        return QString("%1 MB/s").arg(t_bytesPerSecond / (1024.0 * 1024.0), 0, 'f', 1);
+    }
+
+    return QString("%1 KB/s").arg(qRound(t_bytesPerSecond / 1024.0));
+}
+
+QString ProgressAggregator::formatDuration(qint64 t_seconds)
+{
+    qint64 hours = t_seconds / 3600;
+    qint64 minutes = (t_seconds / 60) % 60;
+    qint64 seconds = t_seconds % 60;
+
+    if (hours > 0)
+    {
+        return QString("%1:%2:%3").arg(hours).arg(minutes, 2, 10, QChar('0')).arg(seconds, 2, 10, QChar('0'));
+    }
+
+    return QString("%1:%2").arg(minutes).arg(seconds, 2, 10, QChar('0'));
+}
+
+qint64 ProgressAggregator::now() const
+{
+    return m_clock ? m_clock() : m_timer.elapsed();
+}
+
+QString ProgressAggregator::formatStatus() const
+{
+    QString status = m_totalBytes > 0
+            ? QString("Downloading %1 / %2 KB").arg(QString::number(m_bytesDownloaded / 1024), QString::number(m_totalBytes / 1024))
+            : QString("Downloading %1 KB").arg(QString::number(m_bytesDownloaded / 1024));
+
+    qint64 seconds = secondsLeft();
+
+    if (seconds >= 0 && m_bytesDownloaded < m_totalBytes)
+    {
+        status += QString(" (%1, %2 left)").arg(formatSpeed(m_bytesPerSecond), formatDuration(seconds));
+    }
+
+    return status;
+}
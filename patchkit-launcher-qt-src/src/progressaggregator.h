@@ -0,0 +1,67 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#ifndef PROGRESSAGGREGATOR_H
+#define PROGRESSAGGREGATOR_H
+
+#include <QString>
+#include <QElapsedTimer>
+#include <functional>
+
+/**
+ * @brief
+ * Turns a flood of download progress notifications into a few updates per second for the UI.
+ *
+ * @details
+ * Notifications are sampled at most once per t_intervalMsec, except for the one completing the download.
+ * Each sample updates the download speed, smoothed with an exponentially weighted moving average
+ * (Config::progressSpeedSmoothingFactor is the weight of the newest sample), and the estimated time left.
+ *
+ * update() returns true only if the displayed percent or status has changed since the last update,
+ * so that nothing is sent to the UI thread otherwise.
+ *
+ * Time is read from t_clock (milliseconds, monotonic), or from an internal timer if none is given.
+ */
+class ProgressAggregator
+{
+public:
+    typedef std::function<qint64()> TClock;
+
+    ProgressAggregator(int t_intervalMsec);
+    ProgressAggregator(int t_intervalMsec, const TClock& t_clock);
+
+    bool    update(qint64 t_bytesDownloaded, qint64 t_totalBytes);
+    void    reset();
+
+    int     percent() const;
+    QString status() const;
+
+    // -1 if not known yet.
+    double  bytesPerSecond() const;
+    qint64  secondsLeft() const;
+
+    static QString formatSpeed(double t_bytesPerSecond);
+    static QString formatDuration(qint64 t_seconds);
+
+private:
+    int             m_intervalMsec;
+    TClock          m_clock;
+    QElapsedTimer   m_timer;
+
+    bool            m_hasSample;
+    qint64          m_sampleMsec;
+    qint64          m_sampleBytes;
+    double          m_bytesPerSecond;
+
+    qint64          m_bytesDownloaded;
+    qint64          m_totalBytes;
+    int             m_percent;
+    QString         m_status;
+
+    qint64  now() const;
+    QString formatStatus() const;
+};
+
+#endif // PROGRESSAGGREGATOR_H
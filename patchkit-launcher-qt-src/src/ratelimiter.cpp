@@ -0,0 +1,153 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "ratelimiter.h"
+
+#include <QtMath>
+
+#include "options.h"
+
+const qint64 RateLimiter::minBurstSize = 16 * 1024;
+const qint64 RateLimiter::minGrantSize = 4 * 1024;
+
+RateLimiter::RateLimiter(qint64 t_bytesPerSecond, RateLimiter* t_parent)
+    : RateLimiter(t_bytesPerSecond, t_parent, TClock())
+{
+}
+
+RateLimiter::RateLimiter(qint64 t_bytesPerSecond, RateLimiter* t_parent, const TClock& t_clock)
+    : m_bytesPerSecond(t_bytesPerSecond)
+    , m_tokens(0)
+    , m_clock(t_clock)
+    , m_lastRefillMsec(0)
+    , m_parent(t_parent)
+{
+    m_timer.start();
+
+    m_lastRefillMsec = now();
+}
+
+RateLimiter& RateLimiter::getInstance(Priority t_priority)
+{
+    static RateLimiter foreground(Options::getInstance().getDownloadRateLimit());
+    static RateLimiter background(Options::getInstance().getBackgroundDownloadRateLimit(), &foreground);
+
+    if (t_priority == Background)
+    {
+        return background;
+    }
+
+    return foreground;
+}
+
+void RateLimiter::setBytesPerSecond(qint64 t_bytesPerSecond)
+{
+    QMutexLocker locker(&m_mutex);
+
+    refill();
+
+    m_bytesPerSecond = t_bytesPerSecond;
+    m_tokens = qMin(m_tokens, double(getBurstSize()));
+}
+
+qint64 RateLimiter::getBytesPerSecond() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_bytesPerSecond;
+}
+
+qint64 RateLimiter::acquire(qint64 t_maxBytes)
+{
+    qint64 bytesGranted = t_maxBytes;
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        if (m_bytesPerSecond > 0)
+        {
+            refill();
+
+            bytesGranted = qMin(t_maxBytes, qint64(m_tokens));
+            m_tokens -= bytesGranted;
+        }
+    }
+
+    if (m_parent && bytesGranted > 0)
+    {
+        qint64 bytesGrantedByParent = m_parent->acquire(bytesGranted);
+
+        refund(bytesGranted - bytesGrantedByParent);
+
+        bytesGranted = bytesGrantedByParent;
+    }
+
+    return bytesGranted;
+}
+
+int RateLimiter::msecsUntilAvailable() const
+{
+    int msecs = 0;
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        if (m_bytesPerSecond > 0)
+        {
+            double missingTokens = qMin(minGrantSize, getBurstSize()) - m_tokens;
+
+            if (missingTokens > 0)
+            {
+                msecs = qCeil(missingTokens * 1000.0 / m_bytesPerSecond);
+            }
+        }
+    }
+
+    if (m_parent)
+    {
+        msecs = qMax(msecs, m_parent->msecsUntilAvailable());
+    }
+
+    return qMax(msecs, 1);
+}
+
+qint64 RateLimiter::now() const
+{
+    return m_clock ? m_clock() : m_timer.elapsed();
+}
+
+void RateLimiter::refill()
+{
+    qint64 nowMsec = now();
+
+    if (m_bytesPerSecond > 0)
+    {
+        m_tokens += (nowMsec - m_lastRefillMsec) * m_bytesPerSecond / 1000.0;
+        m_tokens = qMin(m_tokens, double(getBurstSize()));
+    }
+
+    m_lastRefillMsec = nowMsec;
+}
+
+void RateLimiter::refund(qint64 t_bytes)
+{
+    if (t_bytes <= 0)
+    {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    if (m_bytesPerSecond > 0)
+    {
+        m_tokens = qMin(m_tokens + t_bytes, double(getBurstSize()));
+    }
+}
+
+qint64 RateLimiter::getBurstSize() const
+{
+    // Bucket holds a quarter of a second worth of data, so the rate is smooth even with large read buffers.
+    return qMax(minBurstSize, m_bytesPerSecond / 4);
+}
@@ -0,0 +1,87 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#ifndef RATELIMITER_H
+#define RATELIMITER_H
+
+#include <QMutex>
+#include <QElapsedTimer>
+#include <functional>
+
+/**
+ * @brief
+ * Token bucket limiting the number of bytes read from network replies per second.
+ *
+ * @details
+ * Downloaders take tokens before reading data from a reply. When the bucket is empty they wait
+ * and the reply read buffer fills up, which makes Qt stop reading from the socket.
+ *
+ * There is one limiter per download priority. The background limiter is only a cap chained with the foreground one,
+ * so background downloads never use more than is allowed for both of them. Foreground downloads aren't given
+ * precedence. Background downloads run in the prefetch helper process, which doesn't share limiters with
+ * the launcher, so the cap is all that keeps them from crowding out other traffic.
+ *
+ * A limit of 0 bytes per second means the limiter is disabled. The launcher takes the limits from the command line
+ * options; setBytesPerSecond is thread safe.
+ *
+ * Time is read from t_clock (milliseconds, monotonic), or from an internal timer if none is given.
+ */
+class RateLimiter
+{
+public:
+    enum Priority
+    {
+        Foreground,
+        Background
+    };
+
+    typedef std::function<qint64()> TClock;
+
+    RateLimiter(qint64 t_bytesPerSecond, RateLimiter* t_parent = nullptr);
+    RateLimiter(qint64 t_bytesPerSecond, RateLimiter* t_parent, const TClock& t_clock);
+
+    static RateLimiter& getInstance(Priority t_priority);
+
+    void    setBytesPerSecond(qint64 t_bytesPerSecond);
+    qint64  getBytesPerSecond() const;
+
+    /**
+     * @brief acquire
+     * @param t_maxBytes
+     *
+     * Takes at most t_maxBytes tokens from the bucket (and from the parent bucket).
+     *
+     * @return
+     * Number of bytes which can be read now, 0 if the caller has to wait.
+     */
+    qint64  acquire(qint64 t_maxBytes);
+
+    /**
+     * @brief msecsUntilAvailable
+     *
+     * @return
+     * Time after which a reasonable amount of tokens will be available again.
+     */
+    int     msecsUntilAvailable() const;
+
+private:
+    const static qint64 minBurstSize;
+    const static qint64 minGrantSize;
+
+    mutable QMutex  m_mutex;
+    qint64          m_bytesPerSecond;
+    double          m_tokens;
+    TClock          m_clock;
+    QElapsedTimer   m_timer;
+    qint64          m_lastRefillMsec;
+    RateLimiter*    m_parent;
+
+    qint64  now() const;
+    void    refill();
+    void    refund(qint64 t_bytes);
+    qint64  getBurstSize() const;
+};
+
+#endif // RATELIMITER_H
@@ -11,9 +11,20 @@
 #include "staledownloadexception.h"
 #include "chunkeddownloader.h"
 #include "contentsummary.h"
+#include "options.h"
+#include "locations.h"
+#include "peerdiscovery.h"
+#include "timeoutestimator.h"
+#include "retrybackoff.h"
+#include "circuitbreaker.h"
+#include "telemetry.h"
+#include "contentsummarycache.h"
+#include "mirrorcapabilities.h"
+#include "connectionwarmer.h"
 
 RemotePatcherData::RemotePatcherData(IApi& t_api, QNetworkAccessManager* t_networkAccessManager)
     : m_api(t_api)
+    , m_downloadPriority(RateLimiter::Foreground)
     , m_networkAccessManager(t_networkAccessManager)
 {
 }
@@ -22,7 +33,7 @@ int RemotePatcherData::getVersion(const Data& t_data, CancellationToken t_cancel
 {
     logInfo("Fetching newest patcher version from 1/apps/%1/versions/latest/id", .arg(Logger::adjustSecretForLog(t_data.patcherSecret())));
 
-    QString result = m_api.downloadString(QString("1/apps/%1/versions/latest/id").arg(t_data.patcherSecret()), t_cancellationToken);
+    QByteArray result = m_api.downloadBytes(QString("1/apps/%1/versions/latest/id").arg(t_data.patcherSecret()), t_cancellationToken);
 
     return parseVersionJson(result);
 }
@@ -31,7 +42,7 @@ QString RemotePatcherData::getPatcherSecret(const Data& t_data, CancellationToke
 {
     logInfo("Fetching newest patcher secret from 1/apps/%1", .arg(Logger::adjustSecretForLog(t_data.applicationSecret())));
 
-    QString result = m_api.downloadString(QString("1/apps/%1").arg(t_data.applicationSecret()), t_cancellationToken);
+    QByteArray result = m_api.downloadBytes(QString("1/apps/%1").arg(t_data.applicationSecret()), t_cancellationToken);
 
     return parsePatcherSecret(result);
 }
@@ -40,6 +51,8 @@ void RemotePatcherData::download(QIODevice& t_dataTarget, const Data& t_data, in
 {
     logInfo("Downloading patcher %1 version", .arg(QString::number(t_version)));
 
+    m_downloadedContentId.clear();
+
     QStringList contentUrls = getContentUrls(t_data.patcherSecret(), t_version, t_cancellationToken);
 
     QString patcherSecret = t_data.patcherSecret();
@@ -50,23 +63,48 @@ void RemotePatcherData::download(QIODevice& t_dataTarget, const Data& t_data, in
     logInfo("Downloading content summary from 1/apps/%1/versions/%2/content_summary.",
             .arg(Logger::adjustSecretForLog(patcherSecret), version));
 
-    ContentSummary summary;
+    ContentSummaryCache summaryCache(Locations::getInstance().contentSummaryCacheDirPath(), Config::contentSummaryCacheSize);
 
-    try
+    ContentSummary summary = summaryCache.load(patcherSecret, t_version);
+
+    if (summary.isValid())
     {
-        summary = m_api.downloadContentSummary(contentSummaryPath, t_cancellationToken);
-        logInfo("Successfully downloaded the content summary.");
+        logInfo("Using cached content summary.");
+        Telemetry::getInstance().addCounter("summary_cache_hits");
     }
-    catch(std::runtime_error& err)
+    else
     {
-        logWarning(QString("Exception while downloading content summary: %1").arg(err.what()));
+        try
+        {
+            Telemetry::Stage stage("summary_fetch");
+            summary = m_api.downloadContentSummary(contentSummaryPath, t_cancellationToken);
+            logInfo("Successfully downloaded the content summary.");
+        }
+        catch(std::runtime_error& err)
+        {
+            logWarning(QString("Exception while downloading content summary: %1").arg(err.what()));
+        }
+
+        if (summary.isValid())
+        {
+            summaryCache.store(patcherSecret, t_version, summary);
+        }
     }
 
     if (summary.isValid())
     {
+        QString contentId = QString::number(summary.getHashCode(), 16);
+        QStringList chunkedContentUrls = contentUrls;
+
+        if (Options::getInstance().isPeerSharingEnabled())
+        {
+            chunkedContentUrls = findPeerContentUrls(contentId, t_cancellationToken) + contentUrls;
+        }
+
         logInfo("Beginning chunked download.");
-        if (downloadChunked(t_dataTarget, contentUrls, summary, t_cancellationToken))
+        if (downloadChunked(t_dataTarget, chunkedContentUrls, summary, t_cancellationToken))
         {
+            m_downloadedContentId = contentId;
             return;
         }
         else
@@ -91,42 +129,115 @@ void RemotePatcherData::download(QIODevice& t_dataTarget, const Data& t_data, in
     throw std::runtime_error("Unable to download patcher version - " + std::to_string(t_version));
 }
 
+void RemotePatcherData::setDownloadPriority(RateLimiter::Priority t_priority)
+{
+    m_downloadPriority = t_priority;
+}
+
+QString RemotePatcherData::getDownloadedContentId() const
+{
+    return m_downloadedContentId;
+}
+
 QStringList RemotePatcherData::getContentUrls(const QString& t_patcherSecret, int t_version, CancellationToken t_cancellationToken)
 {
     logInfo("Fetching patcher content urls from 1/apps/%1/versions/%2/content_urls",
             .arg(Logger::adjustSecretForLog(t_patcherSecret),QString::number(t_version)));
 
-    QString result = m_api.downloadString(QString("1/apps/%1/versions/%2/content_urls").arg(t_patcherSecret, QString::number(t_version)), t_cancellationToken);
+    Telemetry::Stage stage("content_urls_fetch");
+
+    QByteArray result = m_api.downloadBytes(QString("1/apps/%1/versions/%2/content_urls").arg(t_patcherSecret, QString::number(t_version)), t_cancellationToken);
+
+    QStringList contentUrls = parseContentUrlsJson(result);
 
-    return parseContentUrlsJson(result);
+    ConnectionWarmer::getInstance().rememberContentUrls(contentUrls);
+
+    return contentUrls;
+}
+
+QStringList RemotePatcherData::findPeerContentUrls(const QString& t_contentId, CancellationToken t_cancellationToken)
+{
+    PeerDiscovery discovery(Config::peerDiscoveryPort);
+
+    return discovery.findPeers(t_contentId, Config::peerDiscoveryTimeoutMsec, t_cancellationToken);
 }
 
 bool RemotePatcherData::downloadWith(Downloader& downloader, QIODevice& t_dataTarget, const QStringList& t_contentUrls, CancellationToken t_cancellationToken)
+{
+    // Data is streamed straight into the target, so patchers of any size never have to fit in memory.
+    // Target is emptied only here - retries continue with what the earlier attempts have written.
+    if (!t_dataTarget.open(QIODevice::ReadWrite | QIODevice::Truncate))
+    {
+        throw std::runtime_error("Couldn't open data target for writing.");
+    }
+
+    bool result;
+
+    try
+    {
+        result = downloadFromMirrors(downloader, t_dataTarget, t_contentUrls, t_cancellationToken);
+    }
+    catch (...)
+    {
+        t_dataTarget.close();
+        throw;
+    }
+
+    t_dataTarget.close();
+
+    return result;
+}
+
+bool RemotePatcherData::downloadFromMirrors(Downloader& downloader, QIODevice& t_dataTarget, const QStringList& t_contentUrls, CancellationToken t_cancellationToken)
 {
     connect(&downloader, &Downloader::downloadProgressChanged, this, &RemotePatcherData::downloadProgressChanged);
 
     QTime iterationStart = QTime::currentTime();
     logInfo("Download process start.");
 
-    connect(&downloader, &Downloader::downloadProgressChanged, [&iterationStart]()
+    int progressNotifications = 0;
+
+    connect(&downloader, &Downloader::downloadProgressChanged, [&iterationStart, &progressNotifications]()
     {
         iterationStart = QTime::currentTime();
+        progressNotifications++;
     });
 
+    RetryBackoff backoff(Config::contentUrlsBackoffBaseMsec, Config::contentUrlsBackoffCapMsec);
+    CircuitBreaker circuitBreaker(Config::contentUrlFailureThreshold, Config::contentUrlCircuitOpenMsec);
+
     while(iterationStart.msecsTo(QTime::currentTime()) < Config::chunkedDownloadStaleTimeoutMsec)
     {
         logInfo("Starting new iteration.");
-        for (int i = 0; i < t_contentUrls.size(); i++)
+
+        int iterationProgressNotifications = progressNotifications;
+
+        // Capabilities learned in the previous iteration reorder the mirrors for the next one.
+        QStringList contentUrls = downloader.usesRangeRequests()
+                ? MirrorCapabilities::getInstance().planRangeDownloads(t_contentUrls)
+                : t_contentUrls;
+
+        for (int i = 0; i < contentUrls.size(); i++)
         {
             t_cancellationToken.throwIfCancelled();
 
+            if (!circuitBreaker.isAllowed(contentUrls[i]))
+            {
+                logInfo("Skipping url %1/%2: %3, it has failed too many times in a row.",
+                        .arg(QString::number(i+1), QString::number(contentUrls.size()), contentUrls[i]));
+                continue;
+            }
+
             logInfo("Attempting to download patcher from url %1/%2: %3.",
-                    .arg(QString::number(i+1), QString::number(t_contentUrls.size()), t_contentUrls[i]));
+                    .arg(QString::number(i+1), QString::number(contentUrls.size()), contentUrls[i]));
+
+            int attemptProgressNotifications = progressNotifications;
 
             try
             {
-                if (downloadWithInternal(downloader, t_dataTarget, t_contentUrls[i], t_cancellationToken))
+                if (downloadWithInternal(downloader, t_dataTarget, contentUrls[i], t_cancellationToken))
                 {
+                    Telemetry::getInstance().setValue("mirror_used", contentUrls[i]);
                     return true;
                 }
             }
@@ -146,12 +257,34 @@ bool RemotePatcherData::downloadWith(Downloader& downloader, QIODevice& t_dataTa
             {
                 logWarning("Unknown exception while downloading patcher.");
             }
+
+            Telemetry::getInstance().addCounter("download_retries");
+
+            // Mirror which has delivered some data before failing is not counted as failing.
+            if (progressNotifications == attemptProgressNotifications)
+            {
+                circuitBreaker.recordFailure(contentUrls[i]);
+            }
+            else
+            {
+                circuitBreaker.recordSuccess(contentUrls[i]);
+            }
+        }
+
+        // Backoff grows only while retries don't move the download forward.
+        if (progressNotifications != iterationProgressNotifications)
+        {
+            backoff.reset();
         }
 
+        int delay = backoff.nextDelay();
+
+        logInfo("Waiting %1 msec before next iteration.", .arg(QString::number(delay)));
+
         t_cancellationToken.throwIfCancelled();
         QEventLoop waitLoop;
         connect(&t_cancellationToken, &CancellationToken::cancelled, &waitLoop, &QEventLoop::quit);
-        QTimer::singleShot(Config::timeBetweenContentUrlsIterations, &waitLoop, &QEventLoop::quit);
+        QTimer::singleShot(delay, &waitLoop, &QEventLoop::quit);
         waitLoop.exec();
     }
 
@@ -162,82 +295,55 @@ bool RemotePatcherData::downloadWith(Downloader& downloader, QIODevice& t_dataTa
 
 bool RemotePatcherData::downloadWithInternal(Downloader& t_downloader, QIODevice& t_dataTarget, const QString& t_url, CancellationToken t_cancellationToken)
 {
-    QByteArray downloadedData;
+    int statusCode = -1;
+
     try
     {
-        int statusCode = -1;
-        try
-        {
-            downloadedData = t_downloader.downloadFile(t_url, Config::minConnectionTimeoutMsec, &statusCode);
+        downloadToTarget(t_downloader, t_dataTarget, t_url, TimeoutEstimator::getInstance().getTimeout(t_url, false), statusCode);
+    }
+    catch(TimeoutException&)
+    {
+        int extendedTimeout = TimeoutEstimator::getInstance().getTimeout(t_url, true);
 
-            if (!Downloader::doesStatusCodeIndicateSuccess(statusCode))
-            {
-                return false;
-            }
+        logWarning("Timeout, retrying with an allowed timeout of %1 msec.", .arg(QString::number(extendedTimeout)));
 
-            if (saveData(downloadedData, t_dataTarget))
-            {
-                return true;
-            }
-            else
-            {
-                return false;
-            }
+        t_cancellationToken.throwIfCancelled();
+
+        try
+        {
+            downloadToTarget(t_downloader, t_dataTarget, t_url, extendedTimeout, statusCode);
         }
         catch(TimeoutException&)
         {
-            logWarning("Timeout after %1 msecs, retrying with an allowed timeout of %2 msec.",
-                       .arg(QString::number(Config::minConnectionTimeoutMsec), QString::number(Config::maxConnectionTimeoutMsec)));
-
-            downloadedData.clear();
-
-            downloadedData = t_downloader.downloadFile(t_url, Config::maxConnectionTimeoutMsec, &statusCode);
-
-            if (!Downloader::doesStatusCodeIndicateSuccess(statusCode))
-            {
-                return false;
-            }
-
-            if (saveData(downloadedData, t_dataTarget))
-            {
-                return true;
-            }
-            else
-            {
-                return false;
-            }
+            return false;
         }
     }
-    catch(TimeoutException&)
-    {
-        return false;
-    }
-    catch(...)
-    {
-        throw;
-    }
+
+    return Downloader::doesStatusCodeIndicateSuccess(statusCode);
 }
 
-bool RemotePatcherData::saveData(QByteArray& t_data, QIODevice& t_dataTarget)
+void RemotePatcherData::downloadToTarget(Downloader& t_downloader, QIODevice& t_dataTarget, const QString& t_url, int t_requestTimeoutMsec, int& t_statusCode)
 {
-    if (!t_dataTarget.open(QIODevice::WriteOnly))
+    // Downloader without Range requests sends the whole file again, what the previous attempt has written is dropped.
+    // Chunked downloader keeps its chunks between attempts and requests only the missing ranges.
+    if (!t_downloader.usesRangeRequests())
     {
-        logWarning("Couldn't open data target for writing.");
-        return false;
-    }
+        QFileDevice* file = qobject_cast<QFileDevice*>(&t_dataTarget);
 
-    logInfo("Saving downloaded data.");
-
-    t_dataTarget.write(t_data);
-
-    t_dataTarget.close();
+        if ((file && !file->resize(0)) || !t_dataTarget.seek(0))
+        {
+            throw std::runtime_error("Couldn't rewind data target.");
+        }
+    }
 
-    return true;
+    t_downloader.downloadFile(t_url, t_dataTarget, t_requestTimeoutMsec, &t_statusCode);
 }
 
 bool RemotePatcherData::downloadChunked(QIODevice& t_dataTarget, const QStringList& t_contentUrls, ContentSummary& t_contentSummary, CancellationToken t_cancellationToken)
 {
-    ChunkedDownloader downloader(m_networkAccessManager, t_contentSummary, HashingStrategy::xxHash, t_cancellationToken);
+    ChunkedDownloader downloader(m_networkAccessManager, t_contentSummary, HashingStrategy::xxHashStream, t_cancellationToken);
+    downloader.setPriority(m_downloadPriority);
+    downloader.setMirrorUrls(t_contentUrls);
 
     return downloadWith((Downloader&) downloader, t_dataTarget, t_contentUrls, t_cancellationToken);
 }
@@ -245,16 +351,17 @@ bool RemotePatcherData::downloadChunked(QIODevice& t_dataTarget, const QStringLi
 bool RemotePatcherData::downloadDirect(QIODevice& t_dataTarget, const QStringList& t_contentUrls, CancellationToken t_cancellationToken)
 {
     Downloader downloader(m_networkAccessManager, t_cancellationToken);
+    downloader.setPriority(m_downloadPriority);
 
     return downloadWith(downloader, t_dataTarget, t_contentUrls, t_cancellationToken);
 }
 
-int RemotePatcherData::parseVersionJson(const QString& t_json)
+int RemotePatcherData::parseVersionJson(const QByteArray& t_json)
 {
     logInfo("Parsing version from json.");
     logDebug(t_json);
 
-    QJsonDocument jsonDocument = QJsonDocument::fromJson(t_json.toUtf8());
+    QJsonDocument jsonDocument = QJsonDocument::fromJson(t_json);
 
     if (!jsonDocument.isObject())
     {
@@ -278,11 +385,11 @@ int RemotePatcherData::parseVersionJson(const QString& t_json)
     return idValue;
 }
 
-QString RemotePatcherData::parsePatcherSecret(const QString& t_json)
+QString RemotePatcherData::parsePatcherSecret(const QByteArray& t_json)
 {
     logInfo("Parsing patcher secret from json.");
 
-    QJsonDocument jsonDocument = QJsonDocument::fromJson(t_json.toUtf8());
+    QJsonDocument jsonDocument = QJsonDocument::fromJson(t_json);
 
     if (!jsonDocument.isObject())
     {
@@ -299,12 +406,12 @@ QString RemotePatcherData::parsePatcherSecret(const QString& t_json)
     return jsonObject.value("patcher_secret").toString();
 }
 
-QStringList RemotePatcherData::parseContentUrlsJson(const QString& t_json)
+QStringList RemotePatcherData::parseContentUrlsJson(const QByteArray& t_json)
 {
     logInfo("Parsing content urls from json.");
     logDebug(t_json);
 
-    QJsonDocument jsonDocument = QJsonDocument::fromJson(t_json.toUtf8());
+    QJsonDocument jsonDocument = QJsonDocument::fromJson(t_json);
 
     if (!jsonDocument.isArray())
     {
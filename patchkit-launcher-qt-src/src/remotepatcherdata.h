@@ -26,27 +26,42 @@ public:
 
     void download(QIODevice& t_dataTarget, const Data& t_data, int t_version, CancellationToken t_cancellationToken);
 
+    void setDownloadPriority(RateLimiter::Priority t_priority);
+
+    /**
+     * @brief getDownloadedContentId
+     *
+     * @return
+     * Content id of the archive fetched by the last download, empty if it wasn't downloaded in chunks.
+     */
+    QString getDownloadedContentId() const;
+
 signals:
     void downloadProgressChanged(const long long& t_bytesDownloaded, const long long& t_totalBytes);
 
 private:
     IApi& m_api;
+    RateLimiter::Priority m_downloadPriority;
+    QString m_downloadedContentId;
 
     QStringList getContentUrls(const QString& t_patcherSecret, int t_version, CancellationToken t_cancellationToken);
 
     bool downloadChunked(QIODevice& t_dataTarget, const QStringList& t_contentUrls, ContentSummary& t_contentSummary, CancellationToken t_cancellationToken);
     bool downloadDirect(QIODevice& t_dataTarget, const QStringList& t_contentUrls, CancellationToken t_cancellationToken);
 
+    QStringList findPeerContentUrls(const QString& t_contentId, CancellationToken t_cancellationToken);
+
     bool downloadWith(Downloader& downloader, QIODevice& t_dataTarget, const QStringList& t_contentUrls, CancellationToken t_cancellationToken);
+    bool downloadFromMirrors(Downloader& downloader, QIODevice& t_dataTarget, const QStringList& t_contentUrls, CancellationToken t_cancellationToken);
 
     bool downloadWithInternal(Downloader& t_downloader, QIODevice& t_dataTarget, const QString& t_url, CancellationToken t_cancellationToken);
-    bool saveData(QByteArray& t_data, QIODevice& t_dataTarget);
+    void downloadToTarget(Downloader& t_downloader, QIODevice& t_dataTarget, const QString& t_url, int t_requestTimeoutMsec, int& t_statusCode);
 
-    static int parseVersionJson(const QString& t_json);
+    static int parseVersionJson(const QByteArray& t_json);
 
-    static QString parsePatcherSecret(const QString& t_json);
+    static QString parsePatcherSecret(const QByteArray& t_json);
 
-    static QStringList parseContentUrlsJson(const QString& t_json);
+    static QStringList parseContentUrlsJson(const QByteArray& t_json);
 
     QNetworkAccessManager* m_networkAccessManager;
 };
@@ -0,0 +1,37 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "retrybackoff.h"
+
+#include <algorithm>
+
+RetryBackoff::RetryBackoff(int t_baseMsec, int t_capMsec)
+    : RetryBackoff(t_baseMsec, t_capMsec, std::random_device()())
+{
+}
+
+RetryBackoff::RetryBackoff(int t_baseMsec, int t_capMsec, unsigned int t_seed)
+    : m_baseMsec(t_baseMsec)
+    , m_capMsec(t_capMsec)
+    , m_previousMsec(t_baseMsec)
+    , m_generator(t_seed)
+{
+}
+
+int RetryBackoff::nextDelay()
+{
+    int upperBound = std::max(m_baseMsec, std::min(m_capMsec, m_previousMsec * 3));
+
+    std::uniform_int_distribution<int> distribution(m_baseMsec, upperBound);
+
+    m_previousMsec = std::min(m_capMsec, distribution(m_generator));
+
+    return m_previousMsec;
+}
+
+void RetryBackoff::reset()
+{
+    m_previousMsec = m_baseMsec;
+}
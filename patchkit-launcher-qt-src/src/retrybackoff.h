@@ -0,0 +1,36 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#ifndef RETRYBACKOFF_H
+#define RETRYBACKOFF_H
+
+#include <random>
+
+/**
+ * @brief
+ * Capped exponential backoff with decorrelated jitter.
+ *
+ * @details
+ * Every delay is drawn uniformly from [base, 3 * previous delay] and capped, so clients
+ * which failed at the same moment don't retry in lockstep.
+ * Reset the backoff once a retry has made progress.
+ */
+class RetryBackoff
+{
+public:
+    RetryBackoff(int t_baseMsec, int t_capMsec);
+    RetryBackoff(int t_baseMsec, int t_capMsec, unsigned int t_seed);
+
+    int     nextDelay();
+    void    reset();
+
+private:
+    int             m_baseMsec;
+    int             m_capMsec;
+    int             m_previousMsec;
+    std::mt19937    m_generator;
+};
+
+#endif // RETRYBACKOFF_H
@@ -0,0 +1,153 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "stagedpatcherdata.h"
+
+#include <QLockFile>
+#include <QFile>
+
+#include "logger.h"
+#include "locations.h"
+#include "ioutils.h"
+#include "localpatcherdata.h"
+
+bool StagedPatcherData::isStaged(int t_version, const Data& t_data)
+{
+    IOUtils::createDir(Locations::getInstance().patcherStagingDirPath());
+
+    QLockFile lock(Locations::getInstance().patcherStagingLockFilePath());
+
+    if (!lock.tryLock(Config::patcherStagingLockTimeoutMsec))
+    {
+        logWarning("Couldn't lock patcher staging directory.");
+        return false;
+    }
+
+    return isStagedUnlocked(t_version, t_data);
+}
+
+bool StagedPatcherData::stage(const QString& t_downloadedPath, const Data& t_data, int t_version)
+{
+    logInfo("Staging patcher (version %1) from %2", .arg(QString::number(t_version), t_downloadedPath));
+
+    IOUtils::createDir(Locations::getInstance().patcherStagingDirPath());
+
+    QLockFile lock(Locations::getInstance().patcherStagingLockFilePath());
+
+    if (!lock.tryLock(Config::patcherStagingLockTimeoutMsec))
+    {
+        logWarning("Couldn't lock patcher staging directory.");
+        return false;
+    }
+
+    // Version info is removed first, so a half staged archive is never taken.
+    QFile::remove(Locations::getInstance().patcherStagingVersionInfoFilePath());
+    QFile::remove(Locations::getInstance().patcherStagingArchiveFilePath());
+
+    if (!QFile::rename(t_downloadedPath, Locations::getInstance().patcherStagingArchiveFilePath()))
+    {
+        logWarning("Couldn't move downloaded patcher to staging directory.");
+        return false;
+    }
+
+    IOUtils::writeTextToFile(Locations::getInstance().patcherStagingIdInfoFilePath(), LocalPatcherData::getPatcherId(t_data));
+    IOUtils::writeTextToFile(Locations::getInstance().patcherStagingVersionInfoFilePath(), QString::number(t_version));
+
+    return true;
+}
+
+bool StagedPatcherData::takeArchive(int t_version, const Data& t_data, const QString& t_targetPath)
+{
+    logInfo("Checking whether patcher version %1 is staged.", .arg(QString::number(t_version)));
+
+    if (!IOUtils::checkIfDirExists(Locations::getInstance().patcherStagingDirPath()))
+    {
+        return false;
+    }
+
+    QLockFile lock(Locations::getInstance().patcherStagingLockFilePath());
+
+    if (!lock.tryLock(Config::patcherStagingLockTimeoutMsec))
+    {
+        logWarning("Couldn't lock patcher staging directory.");
+        return false;
+    }
+
+    if (!isStagedUnlocked(t_version, t_data))
+    {
+        return false;
+    }
+
+    QFile::remove(t_targetPath);
+
+    if (!QFile::rename(Locations::getInstance().patcherStagingArchiveFilePath(), t_targetPath))
+    {
+        logWarning("Couldn't move staged patcher to %1", .arg(t_targetPath));
+        return false;
+    }
+
+    QFile::remove(Locations::getInstance().patcherStagingVersionInfoFilePath());
+    QFile::remove(Locations::getInstance().patcherStagingIdInfoFilePath());
+
+    return true;
+}
+
+int StagedPatcherData::getStagedVersion(const Data& t_data)
+{
+    if (!IOUtils::checkIfDirExists(Locations::getInstance().patcherStagingDirPath()))
+    {
+        return -1;
+    }
+
+    QLockFile lock(Locations::getInstance().patcherStagingLockFilePath());
+
+    if (!lock.tryLock(Config::patcherStagingLockTimeoutMsec))
+    {
+        logWarning("Couldn't lock patcher staging directory.");
+        return -1;
+    }
+
+    if (!IOUtils::checkIfFileExists(Locations::getInstance().patcherStagingVersionInfoFilePath()) ||
+        !IOUtils::checkIfFileExists(Locations::getInstance().patcherStagingIdInfoFilePath()) ||
+        !IOUtils::checkIfFileExists(Locations::getInstance().patcherStagingArchiveFilePath()))
+    {
+        return -1;
+    }
+
+    QString patcherId = IOUtils::readTextFromFile(Locations::getInstance().patcherStagingIdInfoFilePath());
+
+    if (patcherId != LocalPatcherData::getPatcherId(t_data))
+    {
+        return -1;
+    }
+
+    bool ok;
+    int version = IOUtils::readTextFromFile(Locations::getInstance().patcherStagingVersionInfoFilePath()).toInt(&ok);
+
+    return ok ? version : -1;
+}
+
+QString StagedPatcherData::partialArchivePath()
+{
+    return Locations::getInstance().patcherStagingArchiveFilePath() + ".part";
+}
+
+bool StagedPatcherData::isStagedUnlocked(int t_version, const Data& t_data)
+{
+    if (!IOUtils::checkIfFileExists(Locations::getInstance().patcherStagingVersionInfoFilePath()) ||
+        !IOUtils::checkIfFileExists(Locations::getInstance().patcherStagingIdInfoFilePath()) ||
+        !IOUtils::checkIfFileExists(Locations::getInstance().patcherStagingArchiveFilePath()))
+    {
+        return false;
+    }
+
+    QString patcherId = IOUtils::readTextFromFile(Locations::getInstance().patcherStagingIdInfoFilePath());
+    QString version = IOUtils::readTextFromFile(Locations::getInstance().patcherStagingVersionInfoFilePath());
+
+    logInfo("Staged patcher version - %1", .arg(version));
+
+    return patcherId == LocalPatcherData::getPatcherId(t_data) &&
+           version == QString::number(t_version);
+}
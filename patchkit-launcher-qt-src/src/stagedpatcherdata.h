@@ -0,0 +1,58 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#ifndef STAGEDPATCHERDATA_H
+#define STAGEDPATCHERDATA_H
+
+#include <QString>
+
+#include "data.h"
+
+/**
+ * @brief
+ * Patcher archive downloaded in the background, waiting to be installed on the next launch.
+ *
+ * @details
+ * The staging directory holds the archive together with its version and patcher id.
+ * It is shared between the launcher and the prefetch helper process, so every access
+ * is guarded with a lock file.
+ */
+class StagedPatcherData
+{
+public:
+    bool isStaged(int t_version, const Data& t_data);
+
+    /**
+     * @brief stage
+     *
+     * Moves a downloaded and verified archive to the staging directory.
+     */
+    bool stage(const QString& t_downloadedPath, const Data& t_data, int t_version);
+
+    /**
+     * @brief takeArchive
+     *
+     * Moves the staged archive to t_targetPath if it matches t_version, staging directory is cleared afterwards.
+     *
+     * @return
+     * Whether the staged archive could be used.
+     */
+    bool takeArchive(int t_version, const Data& t_data, const QString& t_targetPath);
+
+    /**
+     * @brief getStagedVersion
+     *
+     * @return
+     * Version of the archive staged for t_data, -1 if there is none or its version info is corrupted.
+     */
+    int getStagedVersion(const Data& t_data);
+
+    static QString partialArchivePath();
+
+private:
+    bool isStagedUnlocked(int t_version, const Data& t_data);
+};
+
+#endif // STAGEDPATCHERDATA_H
@@ -0,0 +1,140 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "telemetry.h"
+
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QFile>
+
+#include "logger.h"
+
+Telemetry::Telemetry()
+{
+    m_clock.start();
+}
+
+Telemetry::Stage::Stage(const QString& t_name)
+    : m_name(t_name)
+    , m_startMsec(Telemetry::getInstance().elapsed())
+{
+}
+
+Telemetry::Stage::~Stage()
+{
+    Telemetry& telemetry = Telemetry::getInstance();
+
+    telemetry.addStage(m_name, m_startMsec, telemetry.elapsed() - m_startMsec);
+}
+
+qint64 Telemetry::elapsed() const
+{
+    return m_clock.elapsed();
+}
+
+void Telemetry::addStage(const QString& t_name, qint64 t_startMsec, qint64 t_durationMsec)
+{
+    QMutexLocker locker(&m_mutex);
+
+    StageRecord record;
+    record.name = t_name;
+    record.startMsec = t_startMsec;
+    record.durationMsec = t_durationMsec;
+
+    m_stages.push_back(record);
+}
+
+void Telemetry::addCounter(const QString& t_name, qint64 t_value)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_counters[t_name] += t_value;
+}
+
+void Telemetry::setValue(const QString& t_name, const QString& t_value)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_values[t_name] = t_value;
+}
+
+void Telemetry::setTimingOnce(const QString& t_name, qint64 t_durationMsec)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_timings.contains(t_name))
+    {
+        m_timings[t_name] = t_durationMsec;
+    }
+}
+
+QJsonDocument Telemetry::toJson() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    QJsonObject root;
+
+    root["total_msec"] = double(m_clock.elapsed());
+
+    QJsonArray stages;
+
+    for (const StageRecord& record : m_stages)
+    {
+        QJsonObject stage;
+        stage["name"] = record.name;
+        stage["start_msec"] = double(record.startMsec);
+        stage["duration_msec"] = double(record.durationMsec);
+
+        stages.append(stage);
+    }
+
+    root["stages"] = stages;
+
+    QJsonObject counters;
+
+    for (auto it = m_counters.begin(); it != m_counters.end(); ++it)
+    {
+        counters[it.key()] = double(it.value());
+    }
+
+    root["counters"] = counters;
+
+    QJsonObject timings;
+
+    for (auto it = m_timings.begin(); it != m_timings.end(); ++it)
+    {
+        timings[it.key()] = double(it.value());
+    }
+
+    root["timings"] = timings;
+
+    QJsonObject values;
+
+    for (auto it = m_values.begin(); it != m_values.end(); ++it)
+    {
+        values[it.key()] = it.value();
+    }
+
+    root["values"] = values;
+
+    return QJsonDocument(root);
+}
+
+bool Telemetry::writeReport(const QString& t_filePath) const
+{
+    logInfo("Writing telemetry report to %1", .arg(t_filePath));
+
+    QFile file(t_filePath);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        logWarning("Couldn't open telemetry report file for writing.");
+        return false;
+    }
+
+    file.write(toJson().toJson(QJsonDocument::Compact));
+
+    return true;
+}
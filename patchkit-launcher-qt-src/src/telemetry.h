@@ -0,0 +1,95 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <QString>
+#include <QMap>
+#include <QVector>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+
+/**
+ * @brief
+ * Collects timings and counters of a launcher run and writes them as a JSON report.
+ *
+ * @details
+ * All times are measured with a monotonic clock started when the telemetry is first used
+ * and reported in milliseconds. Telemetry can be used from any thread.
+ *
+ * Report format:
+ * {
+ *   "total_msec": 1234,
+ *   "stages": [{ "name": "download", "start_msec": 100, "duration_msec": 1000 }, ...],
+ *   "counters": { "downloaded_bytes": 123456, ... },
+ *   "timings": { "time_to_first_byte_msec": 120, ... },
+ *   "values": { "mirror_used": "http://...", ... }
+ * }
+ */
+class Telemetry
+{
+    Telemetry();
+public:
+    Telemetry(Telemetry const&) = delete;
+    void operator=(Telemetry const&) = delete;
+
+    static Telemetry& getInstance()
+    {
+        static Telemetry instance;
+
+        return instance;
+    }
+
+    /**
+     * @brief
+     * Measures a stage from construction to destruction.
+     */
+    class Stage
+    {
+    public:
+        Stage(const QString& t_name);
+        ~Stage();
+
+    private:
+        QString m_name;
+        qint64  m_startMsec;
+    };
+
+    qint64  elapsed() const;
+
+    void    addStage(const QString& t_name, qint64 t_startMsec, qint64 t_durationMsec);
+    void    addCounter(const QString& t_name, qint64 t_value = 1);
+    void    setValue(const QString& t_name, const QString& t_value);
+
+    /**
+     * @brief setTimingOnce
+     *
+     * Stores a measured duration under t_name, unless one has been stored already.
+     */
+    void    setTimingOnce(const QString& t_name, qint64 t_durationMsec);
+
+    QJsonDocument toJson() const;
+
+    bool    writeReport(const QString& t_filePath) const;
+
+private:
+    struct StageRecord
+    {
+        QString name;
+        qint64  startMsec;
+        qint64  durationMsec;
+    };
+
+    mutable QMutex          m_mutex;
+    QElapsedTimer           m_clock;
+    QVector<StageRecord>    m_stages;
+    QMap<QString, qint64>   m_counters;
+    QMap<QString, qint64>   m_timings;
+    QMap<QString, QString>  m_values;
+};
+
+#endif // TELEMETRY_H
@@ -0,0 +1,151 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "timeoutestimator.h"
+
+#include <QSettings>
+#include <QUrl>
+#include <QtMath>
+
+#include "config.h"
+#include "logger.h"
+
+const QString TimeoutEstimator::defaultSettingsName = "launcher-timeouts";
+
+TimeoutEstimator::TimeoutEstimator(const QString& t_settingsName)
+    : m_settingsName(t_settingsName)
+{
+    load();
+}
+
+int TimeoutEstimator::getTimeout(const QString& t_url, bool t_extended) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_estimates.find(getHost(t_url));
+
+    if (it == m_estimates.end())
+    {
+        return t_extended ? Config::maxConnectionTimeoutMsec : Config::minConnectionTimeoutMsec;
+    }
+
+    const Estimate& estimate = it.value();
+
+    double timeout = estimate.smoothedRoundTripTime + 4.0 * estimate.roundTripTimeVariation;
+
+    timeout *= estimate.backoff;
+
+    if (t_extended)
+    {
+        timeout *= 2.0;
+    }
+
+    return qBound(Config::adaptiveMinConnectionTimeoutMsec, qCeil(timeout), Config::maxConnectionTimeoutMsec);
+}
+
+void TimeoutEstimator::addSample(const QString& t_url, int t_roundTripTimeMsec)
+{
+    QMutexLocker locker(&m_mutex);
+
+    QString host = getHost(t_url);
+
+    auto it = m_estimates.find(host);
+
+    if (it == m_estimates.end())
+    {
+        Estimate estimate;
+        estimate.smoothedRoundTripTime = t_roundTripTimeMsec;
+        estimate.roundTripTimeVariation = t_roundTripTimeMsec / 2.0;
+
+        it = m_estimates.insert(host, estimate);
+    }
+    else
+    {
+        Estimate& estimate = it.value();
+
+        // RFC 6298 - alpha = 1/8, beta = 1/4
+        estimate.roundTripTimeVariation = 0.75 * estimate.roundTripTimeVariation
+                                        + 0.25 * qAbs(estimate.smoothedRoundTripTime - t_roundTripTimeMsec);
+        estimate.smoothedRoundTripTime = 0.875 * estimate.smoothedRoundTripTime
+                                       + 0.125 * t_roundTripTimeMsec;
+        estimate.backoff = 1;
+    }
+
+    logDebug("Round trip time to %1 - %2 msec, smoothed %3 msec.",
+             .arg(host, QString::number(t_roundTripTimeMsec), QString::number(qRound(it.value().smoothedRoundTripTime))));
+
+    save(host, it.value());
+}
+
+void TimeoutEstimator::reportTimeout(const QString& t_url)
+{
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_estimates.find(getHost(t_url));
+
+    if (it == m_estimates.end())
+    {
+        return;
+    }
+
+    // Backoff stops growing once the timeout can't grow anymore.
+    if (it.value().smoothedRoundTripTime * it.value().backoff < Config::maxConnectionTimeoutMsec)
+    {
+        it.value().backoff *= 2;
+    }
+}
+
+void TimeoutEstimator::load()
+{
+    if (m_settingsName.isEmpty())
+    {
+        return;
+    }
+
+    QSettings settings("UpSoft", m_settingsName);
+
+    for (const QString& host : settings.childGroups())
+    {
+        settings.beginGroup(host);
+
+        Estimate estimate;
+        estimate.smoothedRoundTripTime = settings.value("srtt").toDouble();
+        estimate.roundTripTimeVariation = settings.value("rttvar").toDouble();
+
+        if (estimate.smoothedRoundTripTime > 0)
+        {
+            m_estimates.insert(host, estimate);
+        }
+
+        settings.endGroup();
+    }
+}
+
+void TimeoutEstimator::save(const QString& t_host, const Estimate& t_estimate) const
+{
+    if (m_settingsName.isEmpty())
+    {
+        return;
+    }
+
+    QSettings settings("UpSoft", m_settingsName);
+
+    settings.beginGroup(t_host);
+    settings.setValue("srtt", t_estimate.smoothedRoundTripTime);
+    settings.setValue("rttvar", t_estimate.roundTripTimeVariation);
+    settings.endGroup();
+}
+
+QString TimeoutEstimator::getHost(const QString& t_url)
+{
+    QUrl url(t_url);
+
+    if (url.port() == -1)
+    {
+        return url.host();
+    }
+
+    return url.host() + ":" + QString::number(url.port());
+}
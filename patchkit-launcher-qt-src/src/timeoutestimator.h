@@ -0,0 +1,82 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#ifndef TIMEOUTESTIMATOR_H
+#define TIMEOUTESTIMATOR_H
+
+#include <QString>
+#include <QHash>
+#include <QMutex>
+
+/**
+ * @brief
+ * Estimates request timeouts per host from measured round trip times.
+ *
+ * @details
+ * Round trip time is measured from sending a request to receiving the first bytes of the reply.
+ * The estimation follows TCP retransmission timer (RFC 6298) - timeout is SRTT + 4 * RTTVAR,
+ * doubled after every timeout until a new sample arrives, and clamped between
+ * Config::adaptiveMinConnectionTimeoutMsec and Config::maxConnectionTimeoutMsec.
+ *
+ * Hosts without samples use Config::minConnectionTimeoutMsec and Config::maxConnectionTimeoutMsec.
+ *
+ * Estimates are stored in QSettings under t_settingsName, so they survive between runs.
+ * Empty t_settingsName disables storing.
+ */
+class TimeoutEstimator
+{
+public:
+    TimeoutEstimator(const QString& t_settingsName);
+
+    static TimeoutEstimator& getInstance()
+    {
+        static TimeoutEstimator instance(defaultSettingsName);
+
+        return instance;
+    }
+
+    /**
+     * @brief getTimeout
+     * @param t_url
+     * @param t_extended
+     *
+     * Extended timeout is used when a request to the host has already timed out.
+     *
+     * @return
+     * Timeout in milliseconds.
+     */
+    int     getTimeout(const QString& t_url, bool t_extended) const;
+
+    void    addSample(const QString& t_url, int t_roundTripTimeMsec);
+    void    reportTimeout(const QString& t_url);
+
+    const static QString defaultSettingsName;
+
+private:
+    struct Estimate
+    {
+        Estimate()
+            : smoothedRoundTripTime(0)
+            , roundTripTimeVariation(0)
+            , backoff(1)
+        {
+        }
+
+        double  smoothedRoundTripTime;
+        double  roundTripTimeVariation;
+        int     backoff;
+    };
+
+    mutable QMutex              m_mutex;
+    QString                     m_settingsName;
+    QHash<QString, Estimate>    m_estimates;
+
+    void load();
+    void save(const QString& t_host, const Estimate& t_estimate) const;
+
+    static QString getHost(const QString& t_url);
+};
+
+#endif // TIMEOUTESTIMATOR_H
@@ -0,0 +1,120 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "catch.h"
+
+#include <QMap>
+
+#include "src/byteranges.h"
+#include "src/multipartreader.h"
+
+TEST_CASE("Byte ranges are formatted and parsed.", "[byte_ranges]")
+{
+    REQUIRE(ByteRanges::formatRangeHeader({ByteRanges::TRange(0, 99), ByteRanges::TRange(200, -1)}) == "bytes=0-99,200-");
+
+    qint64 first, last, totalSize;
+
+    REQUIRE(ByteRanges::parseContentRange("bytes 100-199/1000", first, last, totalSize));
+    REQUIRE(first == 100);
+    REQUIRE(last == 199);
+    REQUIRE(totalSize == 1000);
+
+    REQUIRE(ByteRanges::parseContentRange("bytes 0-99/*", first, last, totalSize));
+    REQUIRE(totalSize == -1);
+
+    REQUIRE(!ByteRanges::parseContentRange("bytes 99-0/1000", first, last, totalSize));
+    REQUIRE(!ByteRanges::parseContentRange("bytes */1000", first, last, totalSize));
+
+    REQUIRE(ByteRanges::isMultipart("multipart/byteranges; boundary=abc"));
+    REQUIRE(ByteRanges::parseBoundary("multipart/byteranges; boundary=\"abc\"") == "abc");
+}
+
+TEST_CASE("Range headers are parsed into ranges of the resource.", "[byte_ranges]")
+{
+    QVector<ByteRanges::TRange> ranges;
+
+    REQUIRE(ByteRanges::parseRangeHeader("bytes=0-99, 200-,950-2000", 1000, ranges));
+    REQUIRE(ranges == QVector<ByteRanges::TRange>({ByteRanges::TRange(0, 99), ByteRanges::TRange(200, 999), ByteRanges::TRange(950, 999)}));
+
+    REQUIRE(ByteRanges::parseRangeHeader("bytes=3000000000-", Q_INT64_C(4000000000), ranges));
+    REQUIRE(ranges == QVector<ByteRanges::TRange>({ByteRanges::TRange(Q_INT64_C(3000000000), Q_INT64_C(3999999999))}));
+
+    REQUIRE(!ByteRanges::parseRangeHeader("bytes=1000-", 1000, ranges));
+    REQUIRE(!ByteRanges::parseRangeHeader("bytes=0-99,1000-", 1000, ranges));
+    REQUIRE(!ByteRanges::parseRangeHeader("bytes=99-0", 1000, ranges));
+    REQUIRE(!ByteRanges::parseRangeHeader("bytes=-100", 1000, ranges));
+    REQUIRE(!ByteRanges::parseRangeHeader("items=0-99", 1000, ranges));
+}
+
+TEST_CASE("Multipart reader reads parts passed in pieces.", "[byte_ranges]")
+{
+    const QByteArray body = "\r\n--abc\r\n"
+                            "Content-Type: application/octet-stream\r\n"
+                            "Content-Range: bytes 10-14/100\r\n\r\n"
+                            "01234"
+                            "\r\n--abc\r\n"
+                            "Content-Range: bytes 50-52/100\r\n\r\n"
+                            "xyz"
+                            "\r\n--abc--\r\n";
+
+    QMap<qint64, QByteArray> parts;
+    qint64 currentPart = -1;
+
+    MultipartReader reader("abc",
+        [&](qint64 t_offset) { currentPart = t_offset; },
+        [&](const QByteArray& t_data) { parts[currentPart].append(t_data); return true; });
+
+    for (int i = 0; i < body.size(); i += 3)
+    {
+        REQUIRE(reader.read(body.mid(i, 3)));
+    }
+
+    REQUIRE(reader.isFinished());
+    REQUIRE(parts.size() == 2);
+    REQUIRE(parts[10] == "01234");
+    REQUIRE(parts[50] == "xyz");
+
+    SECTION("Part without Content-Range is rejected.")
+    {
+        MultipartReader malformedReader("abc", [](qint64) {}, [](const QByteArray&) { return true; });
+
+        REQUIRE_THROWS(malformedReader.read("--abc\r\nContent-Type: text/plain\r\n\r\ndata"));
+    }
+}
+
+TEST_CASE("Multipart reader reads large parts passed in a single piece.", "[byte_ranges]")
+{
+    const QByteArray firstPart(40 * 1024, 'a');
+    const QByteArray secondPart(70 * 1024, 'b');
+
+    QByteArray body = "--abc\r\n"
+                      "Content-Range: bytes 0-" + QByteArray::number(firstPart.size() - 1) + "/1000000\r\n\r\n"
+                      + firstPart
+                      + "\r\n--abc\r\n"
+                      "Content-Range: bytes 500000-" + QByteArray::number(500000 + secondPart.size() - 1) + "/1000000\r\n\r\n"
+                      + secondPart
+                      + "\r\n--abc--\r\n";
+
+    QMap<qint64, QByteArray> parts;
+    qint64 currentPart = -1;
+
+    MultipartReader reader("abc",
+        [&](qint64 t_offset) { currentPart = t_offset; },
+        [&](const QByteArray& t_data) { parts[currentPart].append(t_data); return true; });
+
+    REQUIRE(reader.read(body));
+
+    REQUIRE(reader.isFinished());
+    REQUIRE(parts.size() == 2);
+    REQUIRE(parts[0] == firstPart);
+    REQUIRE(parts[500000] == secondPart);
+
+    SECTION("Headers without an end are still rejected.")
+    {
+        MultipartReader malformedReader("abc", [](qint64) {}, [](const QByteArray&) { return true; });
+
+        REQUIRE_THROWS(malformedReader.read("--abc\r\nContent-Range: " + QByteArray(32 * 1024, 'x')));
+    }
+}
@@ -0,0 +1,64 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "catch.h"
+
+#include <QtNetwork>
+#include <QBuffer>
+
+#include "src/downloader.h"
+#include "src/ioutils.h"
+#include "src/cancellationtokensource.h"
+
+#include "testhttpserver.h"
+
+TEST_CASE("Cancellation interrupts a stalled download.", "[cancellation]")
+{
+    std::shared_ptr<CancellationTokenSource> tokenSource(new CancellationTokenSource());
+    CancellationToken token(tokenSource);
+
+    TestHttpServer::Profile profile;
+    profile.stallAtByte = 1000;
+    profile.stallMsec = 10000;
+
+    TestHttpServer server;
+    REQUIRE(server.start());
+    server.setContent("/content", QByteArray(64 * 1024, 'x'), profile);
+
+    QNetworkAccessManager nam;
+    Downloader downloader(&nam, token);
+
+    QTimer::singleShot(100, [&tokenSource]()
+    {
+        tokenSource->cancel();
+    });
+
+    QElapsedTimer timer;
+    timer.start();
+
+    REQUIRE_THROWS_AS(downloader.downloadFile(server.url("/content"), 5000), CancelledException);
+    REQUIRE(timer.elapsed() < 1000);
+}
+
+TEST_CASE("Cancelled copy stops before reading any data.", "[cancellation]")
+{
+    std::shared_ptr<CancellationTokenSource> tokenSource(new CancellationTokenSource());
+    CancellationToken token(tokenSource);
+
+    QByteArray source(64 * 1024, 'x');
+    QByteArray target;
+
+    QBuffer sourceBuffer(&source);
+    QBuffer targetBuffer(&target);
+
+    REQUIRE(sourceBuffer.open(QIODevice::ReadOnly));
+    REQUIRE(targetBuffer.open(QIODevice::WriteOnly));
+
+    tokenSource->cancel();
+
+    REQUIRE(tokenSource->isCancelled());
+    REQUIRE_THROWS_AS(IOUtils::copyIODeviceData(sourceBuffer, targetBuffer, token), CancelledException);
+    REQUIRE(target.isEmpty());
+}
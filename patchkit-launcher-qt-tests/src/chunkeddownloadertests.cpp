@@ -14,6 +14,7 @@
 #include "src/staledownloadexception.h"
 
 #include "mockednam.h"
+#include "mockedreply.h"
 #include "custommacros.h"
 
 SCENARIO("Testing how status codes affect the chunked downloader", "[chunked_downloader]")
@@ -55,7 +56,7 @@ SCENARIO("Testing how status codes affect the chunked downloader", "[chunked_dow
         nam.push(urls[2], data, namReplyDelay, 400);
         nam.push(urls[3], data, namReplyDelay, 500);
 
-        ChunkedDownloader downloader(&nam, summary, &HashingStrategy::xxHash, token);
+        ChunkedDownloader downloader(&nam, summary, &HashingStrategy::xxHashStream, token);
 
         int permittedTimeout = 1000;
 
@@ -99,7 +100,7 @@ SCENARIO("Testing chunked downloader in multiple scenarios.", "[chunked_download
 
             nam.push("link", data, 300);
 
-            ChunkedDownloader downloader(&nam, summary, &HashingStrategy::xxHash, token);
+            ChunkedDownloader downloader(&nam, summary, &HashingStrategy::xxHashStream, token);
 
             THEN ("With a 1000 ms permitted timeout, the chunked download should succeed.")
             {
@@ -123,7 +124,7 @@ SCENARIO("Testing chunked downloader in multiple scenarios.", "[chunked_download
 
             THEN ("With a 1000 ms permitted timeout and 1000 ms permitted stale download timeout, the chunked download should succeed.")
             {
-                ChunkedDownloader downloader(&nam, summary, &HashingStrategy::xxHash, token);
+                ChunkedDownloader downloader(&nam, summary, &HashingStrategy::xxHashStream, token);
 
                 QByteArray downloadedData = downloader.downloadFile("link", 1000);
 
@@ -166,7 +167,7 @@ SCENARIO("Simulating RemotePatcherData's alternate url's functionality.", "[chun
             nam.push("link1", data, 400);
             nam.push("link2", data, 200);
 
-            ChunkedDownloader downloader(&nam, summary, HashingStrategy::xxHash, token);
+            ChunkedDownloader downloader(&nam, summary, HashingStrategy::xxHashStream, token);
 
             int timeoutCount = 0;
 
@@ -221,3 +222,297 @@ SCENARIO("Simulating RemotePatcherData's alternate url's functionality.", "[chun
         }
     }
 }
+
+// Sum of the bytes, so that the hashes of the content summary are easy to compute.
+class SumHashStream : public HashStream
+{
+public:
+    SumHashStream() : m_sum(0) {}
+
+    void reset() override
+    {
+        m_sum = 0;
+    }
+
+    void update(const char* t_data, int t_size) override
+    {
+        for (int i = 0; i < t_size; i++)
+        {
+            m_sum += static_cast<unsigned char>(t_data[i]);
+        }
+    }
+
+    THash digest() const override
+    {
+        return m_sum;
+    }
+
+    static std::unique_ptr<HashStream> create()
+    {
+        return std::unique_ptr<HashStream>(new SumHashStream());
+    }
+
+private:
+    THash m_sum;
+};
+
+TEST_CASE("Chunked downloader validates chunks with the given hashing strategy.", "[chunked_downloader]")
+{
+    std::shared_ptr<CancellationTokenSource> tokenSource(new CancellationTokenSource());
+    CancellationToken token(tokenSource);
+
+    QByteArray data = "ABCDEFGHIJ";
+
+    ContentSummary summary(5, 0, "none", "none", "sum", {'A' + 'B' + 'C' + 'D' + 'E', 'F' + 'G' + 'H' + 'I' + 'J'}, {});
+
+    MockedNAM nam;
+    nam.push("link", data, 0, 200);
+
+    ChunkedDownloader downloader(&nam, summary, &SumHashStream::create, token);
+
+    REQUIRE(downloader.downloadFile("link", 1000) == data);
+}
+
+// Discards the data and records where it was written, so content above 2 GB doesn't need the memory or the disk space.
+class OffsetRecordingDevice : public QIODevice
+{
+public:
+    QList<qint64> seeks;
+    QList<QPair<qint64, qint64>> writes;
+
+    bool isSequential() const override
+    {
+        return false;
+    }
+
+    bool seek(qint64 t_position) override
+    {
+        seeks.append(t_position);
+
+        return QIODevice::seek(t_position);
+    }
+
+protected:
+    qint64 readData(char*, qint64) override
+    {
+        return -1;
+    }
+
+    qint64 writeData(const char*, qint64 t_size) override
+    {
+        // Contiguous writes are merged, the data arrives in pieces.
+        if (!writes.isEmpty() && writes.last().first + writes.last().second == pos())
+        {
+            writes.last().second += t_size;
+        }
+        else
+        {
+            writes.append(qMakePair(pos(), t_size));
+        }
+
+        return t_size;
+    }
+};
+
+// Serves a few chunks of content which is too large to be kept in memory as a multipart body, then fails every request.
+class SparseContentNAM : public QNetworkAccessManager
+{
+public:
+    SparseContentNAM(const QByteArray& t_multipartBody)
+        : m_multipartBody(t_multipartBody)
+    {
+    }
+
+    QList<QByteArray> rangeHeaders;
+
+protected:
+    QNetworkReply* createRequest(Operation, const QNetworkRequest& t_request, QIODevice*) override
+    {
+        rangeHeaders.append(t_request.rawHeader("Range"));
+
+        MockedNetworkReply* reply;
+
+        if (rangeHeaders.size() == 1)
+        {
+            reply = new MockedNetworkReply(0, m_multipartBody, 206);
+            reply->setMultipart("abc");
+        }
+        else
+        {
+            reply = new MockedNetworkReply(0, QByteArray(), 503);
+        }
+
+        reply->launch();
+
+        return reply;
+    }
+
+private:
+    QByteArray m_multipartBody;
+};
+
+TEST_CASE("Chunked downloader requests and writes chunks above 2 GB with 64-bit offsets.", "[chunked_downloader]")
+{
+    std::shared_ptr<CancellationTokenSource> tokenSource(new CancellationTokenSource());
+    CancellationToken token(tokenSource);
+
+    const int chunkSize = 1024 * 1024;
+    const int chunksCount = 2051;
+    const qint64 contentSize = qint64(chunksCount) * chunkSize;
+
+    // Chunk 2049 is the first one which starts above 2^31 bytes.
+    const qint64 highChunkOffset = Q_INT64_C(2049) * chunkSize;
+
+    REQUIRE(highChunkOffset > Q_INT64_C(2147483648));
+
+    const QByteArray chunk(chunkSize, '\0');
+
+    ContentSummary summary(chunkSize, 0, "none", "none", "xxHash",
+                           QVector<THash>(chunksCount, HashingStrategy::xxHash(chunk)), {});
+
+    QByteArray body = "--abc\r\n"
+                      "Content-Range: bytes 0-" + QByteArray::number(chunkSize - 1) + "/" + QByteArray::number(contentSize) + "\r\n\r\n"
+                      + chunk
+                      + "\r\n--abc\r\n"
+                      "Content-Range: bytes " + QByteArray::number(highChunkOffset) + "-" + QByteArray::number(highChunkOffset + chunkSize - 1)
+                      + "/" + QByteArray::number(contentSize) + "\r\n\r\n"
+                      + chunk
+                      + "\r\n--abc--\r\n";
+
+    SparseContentNAM nam(body);
+    OffsetRecordingDevice target;
+
+    REQUIRE(target.open(QIODevice::WriteOnly | QIODevice::Unbuffered));
+
+    ChunkedDownloader downloader(&nam, summary, &HashingStrategy::xxHashStream, token);
+
+    // Missing chunks are never served, only the requests for them matter.
+    REQUIRE_THROWS(downloader.downloadFile("large", target, 1000));
+
+    REQUIRE(target.seeks == QList<qint64>({highChunkOffset}));
+    REQUIRE(target.writes == QList<QPair<qint64, qint64>>({qMakePair(qint64(0), qint64(chunkSize)),
+                                                          qMakePair(highChunkOffset, qint64(chunkSize))}));
+
+    REQUIRE(nam.rangeHeaders.size() == 2);
+    REQUIRE(nam.rangeHeaders[0].isEmpty());
+    REQUIRE(nam.rangeHeaders[1] == "bytes=1048576-2148532223,2149580800-");
+}
+
+// Sends the beginning of the content with 200 and then stalls without finishing the reply.
+class StallingNetworkReply : public QNetworkReply
+{
+public:
+    StallingNetworkReply(const QByteArray& t_data, qint64 t_contentLength)
+        : m_data(t_data)
+    {
+        setHeader(QNetworkRequest::ContentLengthHeader, QVariant(t_contentLength));
+        setAttribute(QNetworkRequest::HttpStatusCodeAttribute, QVariant(200));
+
+        open(ReadOnly | Unbuffered);
+
+        QTimer::singleShot(0, this, [this]()
+        {
+            emit readyRead();
+        });
+    }
+
+    void abort() override
+    {
+    }
+
+    qint64 bytesAvailable() const override
+    {
+        return m_data.size();
+    }
+
+    bool isSequential() const override
+    {
+        return true;
+    }
+
+protected:
+    qint64 readData(char* t_data, qint64 t_maxSize) override
+    {
+        qint64 size = qMin<qint64>(t_maxSize, m_data.size());
+
+        memcpy(t_data, m_data.constData(), size_t(size));
+        m_data.remove(0, int(size));
+
+        return size;
+    }
+
+private:
+    QByteArray m_data;
+};
+
+// First request stalls in the middle of a chunk, the next ones are answered with the requested range.
+class StallingNAM : public QNetworkAccessManager
+{
+public:
+    StallingNAM(const QByteArray& t_data, int t_stallAtByte)
+        : m_data(t_data)
+        , m_stallAtByte(t_stallAtByte)
+    {
+    }
+
+    QList<QByteArray> rangeHeaders;
+
+protected:
+    QNetworkReply* createRequest(Operation, const QNetworkRequest& t_request, QIODevice*) override
+    {
+        rangeHeaders.append(t_request.rawHeader("Range"));
+
+        if (rangeHeaders.size() == 1)
+        {
+            return new StallingNetworkReply(m_data.left(m_stallAtByte), m_data.size());
+        }
+
+        QVector<ByteRanges::TRange> ranges;
+
+        MockedNetworkReply* reply = new MockedNetworkReply(0, m_data, 200);
+
+        if (ByteRanges::parseRangeHeader(t_request.rawHeader("Range"), m_data.size(), ranges))
+        {
+            reply->setRange(ranges.first().first, ranges.first().second);
+        }
+
+        reply->launch();
+
+        return reply;
+    }
+
+private:
+    QByteArray m_data;
+    int m_stallAtByte;
+};
+
+TEST_CASE("Chunked downloader resumes a transfer which stalled in the middle of a chunk.", "[chunked_downloader]")
+{
+    std::shared_ptr<CancellationTokenSource> tokenSource(new CancellationTokenSource());
+    CancellationToken token(tokenSource);
+
+    const QByteArray data = "ABCDEFGHIJ";
+
+    ContentSummary summary(4, 0, "none", "none", "sum", {'A' + 'B' + 'C' + 'D', 'E' + 'F' + 'G' + 'H', 'I' + 'J'}, {});
+
+    // Stalls after the first chunk and half of the second one.
+    StallingNAM nam(data, 6);
+
+    QByteArray downloadedData;
+    QBuffer target(&downloadedData);
+
+    REQUIRE(target.open(QIODevice::ReadWrite));
+
+    ChunkedDownloader downloader(&nam, summary, &SumHashStream::create, token);
+
+    REQUIRE_THROWS_AS(downloader.downloadFile("stalling", target, 200), TimeoutException);
+
+    // Retry, like the one with an extended timeout, asks only for the bytes which haven't arrived.
+    downloader.downloadFile("stalling", target, 1000);
+
+    REQUIRE(nam.rangeHeaders.size() == 2);
+    REQUIRE(nam.rangeHeaders[0].isEmpty());
+    REQUIRE(nam.rangeHeaders[1] == "bytes=6-");
+
+    REQUIRE(downloadedData == data);
+}
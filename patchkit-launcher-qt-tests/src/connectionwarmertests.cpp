@@ -0,0 +1,84 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "catch.h"
+
+#include <QSettings>
+
+#include "src/connectionwarmer.h"
+#include "src/config.h"
+
+TEST_CASE("Connection warmer remembers origins of content urls.", "[connection_warmer]")
+{
+    ConnectionWarmer warmer("");
+
+    REQUIRE(warmer.getContentOrigins().isEmpty());
+
+    SECTION("Paths are dropped and duplicated origins are merged.")
+    {
+        warmer.rememberContentUrls({
+            "https://cdn.example.com/apps/1/content.zip",
+            "https://cdn.example.com/apps/1/other.zip",
+            "http://mirror.example.com:8080/content.zip"
+        });
+
+        REQUIRE(warmer.getContentOrigins() == QList<QUrl>({
+            QUrl("https://cdn.example.com"),
+            QUrl("http://mirror.example.com:8080")
+        }));
+    }
+
+    SECTION("Urls without a host are skipped.")
+    {
+        warmer.rememberContentUrls({"link", "file:///tmp/content.zip"});
+
+        REQUIRE(warmer.getContentOrigins().isEmpty());
+    }
+
+    SECTION("Only a few origins are remembered.")
+    {
+        QStringList urls;
+
+        for (int i = 0; i < Config::connectionWarmupMaxContentHosts + 2; i++)
+        {
+            urls.append(QString("http://mirror-%1.example.com/content.zip").arg(i));
+        }
+
+        warmer.rememberContentUrls(urls);
+
+        REQUIRE(warmer.getContentOrigins().size() == Config::connectionWarmupMaxContentHosts);
+    }
+}
+
+TEST_CASE("Connection warmer connects to API servers first.", "[connection_warmer]")
+{
+    ConnectionWarmer warmer("");
+
+    warmer.rememberContentUrls({Config::mainApiUrl + "/content.zip", "http://cdn.example.com/content.zip"});
+
+    QList<QUrl> origins = warmer.getWarmupOrigins();
+
+    REQUIRE(origins.size() == 2 + Config::cacheApiUrls.size());
+    REQUIRE(origins.first() == QUrl(Config::mainApiUrl));
+    REQUIRE(origins.last() == QUrl("http://cdn.example.com"));
+}
+
+TEST_CASE("Connection warmer keeps content origins between runs.", "[connection_warmer]")
+{
+    const QString settingsName = "launcher-content-hosts-tests";
+
+    QSettings("UpSoft", settingsName).clear();
+
+    {
+        ConnectionWarmer warmer(settingsName);
+        warmer.rememberContentUrls({"https://cdn.example.com/content.zip"});
+    }
+
+    ConnectionWarmer warmer(settingsName);
+
+    REQUIRE(warmer.getContentOrigins() == QList<QUrl>({QUrl("https://cdn.example.com")}));
+
+    QSettings("UpSoft", settingsName).clear();
+}
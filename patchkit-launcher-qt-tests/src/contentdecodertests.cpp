@@ -0,0 +1,116 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "catch.h"
+
+#include <zlib.h>
+
+#include "src/contentdecoder.h"
+#include "src/contentdecodingexception.h"
+
+static QByteArray encode(const QByteArray& t_data, int t_windowBits)
+{
+    z_stream stream = z_stream();
+
+    REQUIRE(deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, t_windowBits, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+
+    QByteArray result(int(deflateBound(&stream, uLong(t_data.size()))), 0);
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(t_data.constData()));
+    stream.avail_in = uInt(t_data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(result.data());
+    stream.avail_out = uInt(result.size());
+
+    REQUIRE(deflate(&stream, Z_FINISH) == Z_STREAM_END);
+
+    result.resize(int(stream.total_out));
+
+    deflateEnd(&stream);
+
+    return result;
+}
+
+static QByteArray decodeInPieces(ContentDecoder& t_decoder, const QByteArray& t_data, int t_pieceSize)
+{
+    QByteArray result;
+
+    for (int i = 0; i < t_data.size(); i += t_pieceSize)
+    {
+        result += t_decoder.decode(t_data.mid(i, t_pieceSize));
+    }
+
+    return result;
+}
+
+TEST_CASE("Content decoder decodes encoded replies as they arrive.", "[content_decoder]")
+{
+    QByteArray content;
+
+    for (int i = 0; i < 4096; i++)
+    {
+        content += "{\"hash\":\"" + QByteArray::number(i * 2654435761u, 16) + "\"},";
+    }
+
+    SECTION("gzip")
+    {
+        ContentDecoder decoder("gzip");
+        QByteArray encoded = encode(content, MAX_WBITS + 16);
+
+        REQUIRE(encoded.size() < content.size() / 4);
+        REQUIRE(decodeInPieces(decoder, encoded, 1000) == content);
+        REQUIRE_NOTHROW(decoder.finish());
+    }
+
+    SECTION("deflate with zlib header")
+    {
+        ContentDecoder decoder("Deflate");
+
+        REQUIRE(decodeInPieces(decoder, encode(content, MAX_WBITS), 1) == content);
+        REQUIRE_NOTHROW(decoder.finish());
+    }
+
+    SECTION("raw deflate")
+    {
+        ContentDecoder decoder("deflate");
+
+        REQUIRE(decodeInPieces(decoder, encode(content, -MAX_WBITS), 777) == content);
+        REQUIRE_NOTHROW(decoder.finish());
+    }
+
+    SECTION("identity")
+    {
+        ContentDecoder decoder("");
+
+        REQUIRE_FALSE(decoder.isEncoded());
+        REQUIRE(decodeInPieces(decoder, content, 1000) == content);
+        REQUIRE_NOTHROW(decoder.finish());
+    }
+}
+
+TEST_CASE("Content decoder reports broken replies.", "[content_decoder]")
+{
+    QByteArray encoded = encode(QByteArray(100000, 'a'), MAX_WBITS + 16);
+
+    SECTION("Truncated stream.")
+    {
+        ContentDecoder decoder("gzip");
+        decoder.decode(encoded.left(encoded.size() / 2));
+
+        REQUIRE_THROWS_AS(decoder.finish(), ContentDecodingException);
+    }
+
+    SECTION("Corrupted stream.")
+    {
+        ContentDecoder decoder("gzip");
+
+        REQUIRE_THROWS_AS(decoder.decode(QByteArray(64, 'x')), ContentDecodingException);
+    }
+
+    SECTION("Unsupported encoding.")
+    {
+        REQUIRE_FALSE(ContentDecoder::isSupported("br"));
+        REQUIRE_THROWS_AS(ContentDecoder("br"), ContentDecodingException);
+    }
+}
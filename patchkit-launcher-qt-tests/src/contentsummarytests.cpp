@@ -6,9 +6,14 @@
 #include "catch.h"
 
 #include <QString>
+#include <QList>
 #include <QJsonDocument>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QDir>
 
 #include <src/contentsummary.h>
+#include <src/contentsummarycache.h>
 
 #include <string>
 
@@ -115,3 +120,252 @@ TEST_CASE("Content summary can be serialized to JSON." ,"[content_summary]")
         REQUIRE(a.path == b.path);
     }
 }
+
+TEST_CASE("Content summary parsed from bytes matches the one parsed from JSON document.", "[content_summary]")
+{
+    QByteArray json = QByteArray::fromStdString(contentSummaryData);
+
+    ContentSummary expected(QJsonDocument::fromJson(json));
+    ContentSummary summary = ContentSummary::fromJson(json);
+
+    REQUIRE(summary.isValid());
+    REQUIRE(summary.getChunkSize() == expected.getChunkSize());
+    REQUIRE(summary.getHashCode() == expected.getHashCode());
+    REQUIRE(summary.getEncryptionMethod() == expected.getEncryptionMethod());
+    REQUIRE(summary.getCompressionMethod() == expected.getCompressionMethod());
+    REQUIRE(summary.getHashingMethod() == expected.getHashingMethod());
+
+    REQUIRE(summary.getChunksCount() == expected.getChunksCount());
+    for (int i = 0; i < summary.getChunksCount(); i++)
+    {
+        REQUIRE(summary.getChunkHash(i) == expected.getChunkHash(i));
+    }
+
+    REQUIRE(summary.getFilesCount() == expected.getFilesCount());
+    REQUIRE(summary.getFileData(0).path == expected.getFileData(0).path);
+    REQUIRE(summary.getFileData(0).hash == expected.getFileData(0).hash);
+}
+
+TEST_CASE("Content summary parsed from bytes handles escapes and unknown values.", "[content_summary]")
+{
+    QByteArray json =
+        "{\"unknown\": {\"nested\": [1, 2.5e3, true, null, \"x\\\"]\"]},"
+        " \"encryption_method\": \"none\", \"compression_method\": \"zip\", \"hashing_method\": \"xxhash\","
+        " \"hash_code\": \"FFFFFFFF\","
+        " \"files\": [{\"path\": \"dir\\/file \\u0105\\n\", \"hash\": \"0a\"}],"
+        " \"chunks\": {\"size\": 1024, \"hashes\": [\"1\", \"ff\", \"DEADBEEF\"]}}";
+
+    ContentSummary summary = ContentSummary::fromJson(json);
+
+    REQUIRE(summary.isValid());
+    REQUIRE(summary.getHashCode() == 0xFFFFFFFFu);
+    REQUIRE(summary.getFileData(0).path == QString("dir/file ") + QChar(0x0105) + "\n");
+    REQUIRE(summary.getFileData(0).hash == 10);
+    REQUIRE(summary.getChunkSize() == 1024);
+    REQUIRE(summary.getChunksCount() == 3);
+    REQUIRE(summary.getChunkHash(2) == 0xDEADBEEFu);
+}
+
+TEST_CASE("Content summary parsed from malformed bytes is invalid.", "[content_summary]")
+{
+    const QByteArray valid =
+        "{\"encryption_method\": \"none\", \"compression_method\": \"zip\", \"hashing_method\": \"xxhash\","
+        " \"hash_code\": \"1\", \"files\": [], \"chunks\": {\"size\": 1024, \"hashes\": [\"1\"]}}";
+
+    REQUIRE(ContentSummary::fromJson(valid).isValid());
+
+    REQUIRE(!ContentSummary::fromJson("").isValid());
+    REQUIRE(!ContentSummary::fromJson(valid + "}").isValid());
+    REQUIRE(!ContentSummary::fromJson(valid.left(valid.size() - 5)).isValid());
+    REQUIRE(!ContentSummary::fromJson(QByteArray(valid).replace("\"hash_code\": \"1\",", "")).isValid());
+    REQUIRE(!ContentSummary::fromJson(QByteArray(valid).replace("[\"1\"]", "[]")).isValid());
+    REQUIRE(!ContentSummary::fromJson(QByteArray(valid).replace("[\"1\"]", "[\"1g\"]")).isValid());
+    REQUIRE(!ContentSummary::fromJson(QByteArray(valid).replace("[\"1\"]", "[\"100000000\"]")).isValid());
+    REQUIRE(!ContentSummary::fromJson(QByteArray(valid).replace("\"files\": []", "\"files\": [{\"path\": \"a\"}]")).isValid());
+
+    REQUIRE(ContentSummary::fromJson(QByteArray(valid).replace("\"none\"", "\"n\xC3\xA9\"")).isValid());
+    REQUIRE(ContentSummary::fromJson(QByteArray(valid).replace("{\"encryption_method\"", "{\"a\": -0.5e1, \"encryption_method\"")).isValid());
+
+    // Input which QJsonDocument rejects is rejected as well.
+    const QList<QByteArray> rejected = {
+        QByteArray(valid).replace("1024", "01024"),
+        QByteArray(valid).replace("{\"encryption_method\"", "{\"a\": -01, \"encryption_method\""),
+        QByteArray(valid).replace("{\"encryption_method\"", "{\"a\": +1, \"encryption_method\""),
+        QByteArray(valid).replace("{\"encryption_method\"", "{\"a\": .5, \"encryption_method\""),
+        QByteArray(valid).replace("\"none\"", "\"n\xC3\""),
+        QByteArray(valid).replace("\"none\"", "\"n\xFF\""),
+        QByteArray(valid).replace("\"none\"", "\"\xC0\xAF\""),
+        QByteArray(valid).replace("\"none\"", "\"\xED\xA0\x80\""),
+        QByteArray(valid).replace("\"none\"", "\"\xF4\x90\x80\x80\""),
+        QByteArray(valid).replace("\"files\": []", "\"files\": [{\"path\": \"\\n\xE9\", \"hash\": \"1\"}]"),
+        QByteArray(valid).replace("{\"encryption_method\"", "{\"\xE2\x82\": 1, \"encryption_method\"")
+    };
+
+    for (const QByteArray& json : rejected)
+    {
+        INFO(json.toStdString());
+
+        REQUIRE(QJsonDocument::fromJson(json).isNull());
+        REQUIRE(!ContentSummary::fromJson(json).isValid());
+    }
+}
+
+static void requireSameSummaries(const QByteArray& t_json)
+{
+    INFO(t_json.toStdString());
+
+    ContentSummary expected(QJsonDocument::fromJson(t_json));
+    ContentSummary summary = ContentSummary::fromJson(t_json);
+
+    REQUIRE(summary.isValid() == expected.isValid());
+
+    if (!expected.isValid())
+    {
+        return;
+    }
+
+    REQUIRE(summary.getChunkSize() == expected.getChunkSize());
+    REQUIRE(summary.getHashCode() == expected.getHashCode());
+    REQUIRE(summary.getEncryptionMethod() == expected.getEncryptionMethod());
+
+    REQUIRE(summary.getChunksCount() == expected.getChunksCount());
+    for (int i = 0; i < summary.getChunksCount(); i++)
+    {
+        REQUIRE(summary.getChunkHash(i) == expected.getChunkHash(i));
+    }
+
+    REQUIRE(summary.getFilesCount() == expected.getFilesCount());
+    for (int i = 0; i < summary.getFilesCount(); i++)
+    {
+        REQUIRE(summary.getFileData(i).path == expected.getFileData(i).path);
+        REQUIRE(summary.getFileData(i).hash == expected.getFileData(i).hash);
+    }
+}
+
+TEST_CASE("Content summary parsed from bytes agrees with the JSON document on edge cases.", "[content_summary]")
+{
+    const QByteArray valid =
+        "{\"encryption_method\": \"none\", \"compression_method\": \"zip\", \"hashing_method\": \"xxhash\","
+        " \"hash_code\": \"1\", \"files\": [{\"path\": \"a\", \"hash\": \"2\"}], \"chunks\": {\"size\": 1024, \"hashes\": [\"3\"]}}";
+
+    requireSameSummaries(valid);
+
+    SECTION("The last of duplicated keys wins.")
+    {
+        requireSameSummaries(QByteArray(valid).replace("\"files\":", "\"files\": [{\"path\": \"b\", \"hash\": \"4\"}], \"files\":"));
+        requireSameSummaries(QByteArray(valid).replace("\"files\":", "\"files\": [{\"path\": \"b\"}], \"files\":"));
+        requireSameSummaries(QByteArray(valid).replace("\"files\": [", "\"files\": [], \"files\": 5, \"files\": ["));
+        requireSameSummaries(QByteArray(valid).replace("\"chunks\":", "\"chunks\": {\"size\": 8, \"hashes\": [\"5\", \"6\"]}, \"chunks\":"));
+        requireSameSummaries(QByteArray(valid).replace("\"chunks\":", "\"chunks\": {}, \"chunks\":"));
+        requireSameSummaries(QByteArray(valid).replace("\"chunks\":", "\"chunks\": [], \"chunks\":"));
+        requireSameSummaries(QByteArray(valid).replace("\"size\": 1024", "\"size\": 1.5, \"size\": 1024"));
+        requireSameSummaries(QByteArray(valid).replace("\"size\": 1024", "\"size\": 1024, \"size\": \"x\""));
+        requireSameSummaries(QByteArray(valid).replace("\"hashes\": [\"3\"]", "\"hashes\": [\"g\"], \"hashes\": [\"3\"]"));
+        requireSameSummaries(QByteArray(valid).replace("\"hash_code\": \"1\"", "\"hash_code\": \"1\", \"hash_code\": \"z\""));
+        requireSameSummaries(QByteArray(valid).replace("\"hash\": \"2\"", "\"hash\": 2, \"hash\": \"2\""));
+    }
+
+    SECTION("Chunk size is an integral number in the int range.")
+    {
+        for (const char* size : {"1.5", "1e3", "-0", "2147483647", "2147483648", "-2147483649", "1e10", "-1e300", "true", "null", "\"1024\""})
+        {
+            requireSameSummaries(QByteArray(valid).replace("1024", size));
+        }
+    }
+
+    SECTION("Hashes are read like QString::toUInt does.")
+    {
+        for (const char* hash : {"ff", "FF", "00000000ff", "ffffffff", "100000000", " ff", "ff ", "\\tff\\n", "0xff", "0XFF", "0x",
+                                 "+ff", "-1", "f f", "\\u0066f", "", "fg"})
+        {
+            QByteArray quoted = QByteArray("\"") + hash + "\"";
+
+            requireSameSummaries(QByteArray(valid).replace("[\"3\"]", "[" + quoted + "]"));
+            requireSameSummaries(QByteArray(valid).replace("\"hash_code\": \"1\"", "\"hash_code\": " + quoted));
+            requireSameSummaries(QByteArray(valid).replace("\"hash\": \"2\"", "\"hash\": " + quoted));
+        }
+
+        requireSameSummaries(QByteArray(valid).replace("[\"3\"]", "[3]"));
+        requireSameSummaries(QByteArray(valid).replace("\"hash_code\": \"1\"", "\"hash_code\": null"));
+    }
+}
+
+TEST_CASE("Content summary survives a binary round trip.", "[content_summary]")
+{
+    ContentSummary expected = ContentSummary::fromJson(QByteArray::fromStdString(contentSummaryData));
+    QByteArray binary = expected.toBinary();
+
+    ContentSummary summary = ContentSummary::fromBinary(binary);
+
+    REQUIRE(summary.isValid());
+    REQUIRE(summary.getChunkSize() == expected.getChunkSize());
+    REQUIRE(summary.getHashCode() == expected.getHashCode());
+    REQUIRE(summary.getEncryptionMethod() == expected.getEncryptionMethod());
+    REQUIRE(summary.getCompressionMethod() == expected.getCompressionMethod());
+    REQUIRE(summary.getHashingMethod() == expected.getHashingMethod());
+
+    REQUIRE(summary.getChunksCount() == expected.getChunksCount());
+    for (int i = 0; i < summary.getChunksCount(); i++)
+    {
+        REQUIRE(summary.getChunkHash(i) == expected.getChunkHash(i));
+    }
+
+    REQUIRE(summary.getFilesCount() == expected.getFilesCount());
+    REQUIRE(summary.getFileData(0).path == expected.getFileData(0).path);
+    REQUIRE(summary.getFileData(0).hash == expected.getFileData(0).hash);
+
+    SECTION("Damaged binary is invalid.")
+    {
+        REQUIRE(!ContentSummary::fromBinary(QByteArray()).isValid());
+        REQUIRE(!ContentSummary::fromBinary(binary.left(binary.size() - 1)).isValid());
+        REQUIRE(!ContentSummary::fromBinary(binary + QByteArray(1, 0)).isValid());
+
+        QByteArray corrupted = binary;
+        corrupted[corrupted.size() / 2] = corrupted[corrupted.size() / 2] ^ 0x01;
+
+        REQUIRE(!ContentSummary::fromBinary(corrupted).isValid());
+    }
+}
+
+TEST_CASE("Content summary cache keeps the most recent summaries.", "[content_summary]")
+{
+    QTemporaryDir cacheDir;
+    REQUIRE(cacheDir.isValid());
+
+    ContentSummary summary = ContentSummary::fromJson(QByteArray::fromStdString(contentSummaryData));
+
+    ContentSummaryCache cache(cacheDir.path(), 2);
+
+    REQUIRE(!cache.load("secret", 1).isValid());
+
+    cache.store("secret", 1, summary);
+
+    ContentSummary cached = cache.load("secret", 1);
+
+    REQUIRE(cached.isValid());
+    REQUIRE(cached.getHashCode() == summary.getHashCode());
+    REQUIRE(!cache.load("secret", 2).isValid());
+    REQUIRE(!cache.load("other secret", 1).isValid());
+
+    SECTION("Damaged cache file is removed.")
+    {
+        QStringList files = QDir(cacheDir.path()).entryList(QDir::Files);
+        REQUIRE(files.size() == 1);
+
+        QFile file(cacheDir.path() + "/" + files[0]);
+        REQUIRE(file.open(QIODevice::ReadWrite));
+        file.resize(file.size() - 1);
+        file.close();
+
+        REQUIRE(!cache.load("secret", 1).isValid());
+        REQUIRE(!QFile::exists(file.fileName()));
+    }
+
+    SECTION("Oldest summaries are evicted.")
+    {
+        cache.store("secret", 2, summary);
+        cache.store("secret", 3, summary);
+
+        REQUIRE(QDir(cacheDir.path()).entryList(QDir::Files).size() == 2);
+    }
+}
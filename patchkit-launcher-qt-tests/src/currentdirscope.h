@@ -0,0 +1,34 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#ifndef CURRENTDIRSCOPE_H
+#define CURRENTDIRSCOPE_H
+
+#include "catch.h"
+
+#include <QDir>
+
+#include "src/locations.h"
+
+// Patcher and staging directories are resolved against the current directory, which is moved to a temporary one.
+class CurrentDirScope
+{
+public:
+    CurrentDirScope(const QString& t_path)
+        : m_previousPath(Locations::getInstance().currentDirPath())
+    {
+        REQUIRE(QDir::setCurrent(t_path));
+    }
+
+    ~CurrentDirScope()
+    {
+        QDir::setCurrent(m_previousPath);
+    }
+
+private:
+    QString m_previousPath;
+};
+
+#endif // CURRENTDIRSCOPE_H
@@ -0,0 +1,125 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "catch.h"
+
+#include <QTemporaryDir>
+
+#include "src/fastlaunchpolicy.h"
+#include "src/localpatcherdata.h"
+#include "src/stagedpatcherdata.h"
+#include "src/locations.h"
+#include "src/ioutils.h"
+#include "src/config.h"
+
+#include "currentdirscope.h"
+
+struct FastLaunchTestData : public Data
+{
+    QString patcherSecret() const override
+    {
+        return "xxpatcherxx";
+    }
+};
+
+static void writeInstalledPatcher(const QString& t_patcherId, const QString& t_version)
+{
+    Locations& locations = Locations::getInstance();
+
+    IOUtils::createDir(locations.patcherDirectoryPath());
+    IOUtils::writeTextToFile(locations.patcherDirectoryPath() + "/patcher.exe", "");
+    IOUtils::writeTextToFile(locations.patcherInstallationInfoFilePath(), "patcher.exe");
+    IOUtils::writeTextToFile(locations.patcherIdInfoFilePath(), t_patcherId);
+    IOUtils::writeTextToFile(locations.patcherVersionInfoFilePath(), t_version);
+}
+
+static void writeStagedPatcher(const QString& t_patcherId, const QString& t_version)
+{
+    Locations& locations = Locations::getInstance();
+
+    IOUtils::createDir(locations.patcherStagingDirPath());
+    IOUtils::writeTextToFile(locations.patcherStagingArchiveFilePath(), "");
+    IOUtils::writeTextToFile(locations.patcherStagingIdInfoFilePath(), t_patcherId);
+    IOUtils::writeTextToFile(locations.patcherStagingVersionInfoFilePath(), t_version);
+}
+
+TEST_CASE("Fast launch is allowed only for a recently validated patcher.", "[fast_launch]")
+{
+    const qint64 now = Q_INT64_C(1700000000000);
+
+    REQUIRE(FastLaunchPolicy::isValidationRecent(now, now));
+    REQUIRE(FastLaunchPolicy::isValidationRecent(now - 1000, now));
+    REQUIRE(FastLaunchPolicy::isValidationRecent(now - Config::fastLaunchMaxStalenessMsec, now));
+
+    REQUIRE(!FastLaunchPolicy::isValidationRecent(now - Config::fastLaunchMaxStalenessMsec - 1, now));
+    REQUIRE(!FastLaunchPolicy::isValidationRecent(-1, now));
+
+    // Validation time from the future means the clock has been moved back.
+    REQUIRE(!FastLaunchPolicy::isValidationRecent(now + 1000, now));
+}
+
+TEST_CASE("Staged patcher is installed only over an older one.", "[fast_launch]")
+{
+    REQUIRE(FastLaunchPolicy::shouldInstallStaged(5, -1));
+    REQUIRE(FastLaunchPolicy::shouldInstallStaged(5, 4));
+
+    REQUIRE(!FastLaunchPolicy::shouldInstallStaged(5, 5));
+    REQUIRE(!FastLaunchPolicy::shouldInstallStaged(4, 5));
+    REQUIRE(!FastLaunchPolicy::shouldInstallStaged(-1, -1));
+}
+
+TEST_CASE("Installed and staged patcher versions are read from their info files.", "[fast_launch]")
+{
+    QTemporaryDir currentDir;
+    REQUIRE(currentDir.isValid());
+
+    CurrentDirScope currentDirScope(currentDir.path());
+
+    FastLaunchTestData data;
+    LocalPatcherData localPatcher;
+    StagedPatcherData stagedPatcher;
+
+    SECTION("Missing files mean no version.")
+    {
+        REQUIRE(localPatcher.getInstalledVersion(data) == -1);
+        REQUIRE(stagedPatcher.getStagedVersion(data) == -1);
+
+        writeInstalledPatcher("patcher", "3");
+        writeStagedPatcher("patcher", "4");
+
+        QFile::remove(Locations::getInstance().patcherVersionInfoFilePath());
+        QFile::remove(Locations::getInstance().patcherStagingArchiveFilePath());
+
+        REQUIRE(localPatcher.getInstalledVersion(data) == -1);
+        REQUIRE(stagedPatcher.getStagedVersion(data) == -1);
+    }
+
+    SECTION("Versions of the patcher of this application are read.")
+    {
+        writeInstalledPatcher("patcher", "3");
+        writeStagedPatcher("patcher", "4");
+
+        REQUIRE(localPatcher.getInstalledVersion(data) == 3);
+        REQUIRE(stagedPatcher.getStagedVersion(data) == 4);
+    }
+
+    SECTION("Versions of a patcher of another application are ignored.")
+    {
+        writeInstalledPatcher("other", "3");
+        writeStagedPatcher("other", "4");
+
+        REQUIRE(localPatcher.getInstalledVersion(data) == -1);
+        REQUIRE(stagedPatcher.getStagedVersion(data) == -1);
+    }
+
+    SECTION("Corrupted version info means no version.")
+    {
+        writeInstalledPatcher("patcher", "3x");
+        writeStagedPatcher("patcher", "");
+
+        REQUIRE(localPatcher.getInstalledVersion(data) == -1);
+        REQUIRE(stagedPatcher.getStagedVersion(data) == -1);
+    }
+}
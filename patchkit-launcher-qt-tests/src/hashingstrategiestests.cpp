@@ -20,3 +20,27 @@ TEST_CASE("HashingStrategy xxHash", "[xxHash]")
     REQUIRE(HashingStrategy::xxHash(dataOne) != HashingStrategy::xxHash(dataTwo));
     REQUIRE(HashingStrategy::xxHash(dataTwo) == HashingStrategy::xxHash(dataTwo));
 }
+
+TEST_CASE("HashingStrategy xxHash stream", "[xxHash]")
+{
+    QByteArray data = "TestDataWhichIsLongerThanTheInternalBufferOfTheHash";
+
+    HashingStrategy::XXHashStream stream;
+
+    stream.update(data.constData(), 5);
+
+    // Copy of a paused stream resumes where the original has stopped.
+    HashingStrategy::XXHashStream resumedStream = stream;
+
+    stream.update(data.constData() + 5, data.size() - 5);
+
+    resumedStream.update(data.constData() + 5, 20);
+    resumedStream.update(data.constData() + 25, data.size() - 25);
+
+    REQUIRE(stream.digest() == HashingStrategy::xxHash(data));
+    REQUIRE(resumedStream.digest() == HashingStrategy::xxHash(data));
+
+    stream.reset();
+
+    REQUIRE(stream.digest() == HashingStrategy::xxHash(QByteArray()));
+}
@@ -0,0 +1,59 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "catch.h"
+
+#include <QTemporaryDir>
+#include <QFileInfo>
+
+#include <quazip.h>
+#include <quazipfile.h>
+
+#include "src/ioutils.h"
+#include "src/cancellationtokensource.h"
+
+// Writes a ZIP64 archive with a single zero-filled entry, which compresses to a tiny fraction of its size.
+static void writeSparseZip(const QString& t_zipPath, const QString& t_entryName, qint64 t_entrySize)
+{
+    QuaZip zip(t_zipPath);
+    zip.setZip64Enabled(true);
+
+    REQUIRE(zip.open(QuaZip::mdCreate));
+
+    QuaZipFile entry(&zip);
+    REQUIRE(entry.open(QIODevice::WriteOnly, QuaZipNewInfo(t_entryName)));
+
+    const QByteArray zeros(4 * 1024 * 1024, '\0');
+
+    for (qint64 written = 0; written < t_entrySize; written += zeros.size())
+    {
+        qint64 size = qMin<qint64>(zeros.size(), t_entrySize - written);
+        REQUIRE(entry.write(zeros.constData(), size) == size);
+    }
+
+    entry.close();
+    REQUIRE(entry.getZipError() == ZIP_OK);
+
+    zip.close();
+}
+
+TEST_CASE("Zip entries above 4 GB are extracted.", "[.][large_archive]")
+{
+    std::shared_ptr<CancellationTokenSource> tokenSource(new CancellationTokenSource());
+
+    QTemporaryDir tempDir;
+    REQUIRE(tempDir.isValid());
+
+    const qint64 entrySize = Q_INT64_C(5) * 1024 * 1024 * 1024;
+
+    QString zipPath = tempDir.path() + "/patcher.zip";
+    writeSparseZip(zipPath, "data/large.bin", entrySize);
+
+    QStringList extractedEntries;
+    IOUtils::extractZip(zipPath, tempDir.path() + "/extracted", extractedEntries, tokenSource);
+
+    REQUIRE(extractedEntries == QStringList("data/large.bin"));
+    REQUIRE(QFileInfo(tempDir.path() + "/extracted/data/large.bin").size() == entrySize);
+}
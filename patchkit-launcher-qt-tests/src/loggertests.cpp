@@ -0,0 +1,241 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "catch.h"
+
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QRegExp>
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "src/logger.h"
+
+static int evaluations = 0;
+
+static QString countEvaluation()
+{
+    evaluations++;
+
+    return "evaluated";
+}
+
+TEST_CASE("Disabled log levels don't evaluate the message arguments.", "[logger]")
+{
+    evaluations = 0;
+
+    Logger::setMinimumLevel(QtWarningMsg);
+
+    logDebug("Argument - %1", .arg(countEvaluation()));
+    logInfo("Argument - %1", .arg(countEvaluation()));
+
+    REQUIRE(evaluations == 0);
+    REQUIRE(!Logger::isEnabled(QtInfoMsg));
+    REQUIRE(Logger::isEnabled(QtWarningMsg));
+    REQUIRE(Logger::isEnabled(QtCriticalMsg));
+
+    Logger::setMinimumLevel(QtDebugMsg);
+
+    logDebug("Argument - %1", .arg(countEvaluation()));
+
+    REQUIRE(evaluations == 1);
+}
+
+TEST_CASE("Log level names are parsed.", "[logger]")
+{
+    QtMsgType type = QtDebugMsg;
+
+    REQUIRE(Logger::parseLevel("Warning", type));
+    REQUIRE(type == QtWarningMsg);
+
+    REQUIRE(Logger::parseLevel("info", type));
+    REQUIRE(type == QtInfoMsg);
+
+    REQUIRE(!Logger::parseLevel("verbose", type));
+    REQUIRE(type == QtInfoMsg);
+}
+
+static QStringList readLogLines(const QString& t_logFilePath)
+{
+    QFile logFile(t_logFilePath);
+
+    if (!logFile.open(QIODevice::ReadOnly))
+    {
+        return QStringList();
+    }
+
+    return QString::fromUtf8(logFile.readAll()).split('\n', QString::SkipEmptyParts);
+}
+
+static bool containsMessage(const QStringList& t_lines, const QString& t_message)
+{
+    for (const QString& line : t_lines)
+    {
+        if (line.endsWith(" - " + t_message))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+class LoggingThread : public QThread
+{
+public:
+    LoggingThread(Logger& t_logger, int t_threadIndex, int t_messagesCount)
+        : m_logger(t_logger)
+        , m_threadIndex(t_threadIndex)
+        , m_messagesCount(t_messagesCount)
+    {
+    }
+
+protected:
+    void run() override
+    {
+        for (int i = 0; i < m_messagesCount; i++)
+        {
+            m_logger.write(QtInfoMsg, QString("thread %1 message %2").arg(m_threadIndex).arg(i));
+        }
+    }
+
+private:
+    Logger& m_logger;
+    int m_threadIndex;
+    int m_messagesCount;
+};
+
+TEST_CASE("Messages from several threads are all written in the order of each thread.", "[logger]")
+{
+    const int threadsCount = 4;
+    const int messagesCount = 500;
+
+    QTemporaryDir logDir;
+    REQUIRE(logDir.isValid());
+
+    QString logFilePath = logDir.path() + "/log.txt";
+
+    {
+        Logger logger(logFilePath);
+
+        std::vector<std::unique_ptr<LoggingThread>> threads;
+
+        for (int i = 0; i < threadsCount; i++)
+        {
+            threads.emplace_back(new LoggingThread(logger, i, messagesCount));
+            threads.back()->start();
+        }
+
+        for (auto& thread : threads)
+        {
+            REQUIRE(thread->wait(30000));
+        }
+    }
+
+    QStringList lines = readLogLines(logFilePath);
+
+    REQUIRE(lines.size() == threadsCount * messagesCount);
+
+    QVector<int> nextMessages(threadsCount, 0);
+    QRegExp messagePattern(" - thread (\\d+) message (\\d+)$");
+
+    for (const QString& line : lines)
+    {
+        REQUIRE(messagePattern.indexIn(line) >= 0);
+
+        int threadIndex = messagePattern.cap(1).toInt();
+        int message = messagePattern.cap(2).toInt();
+
+        REQUIRE(message == nextMessages[threadIndex]);
+        nextMessages[threadIndex]++;
+    }
+}
+
+TEST_CASE("Warning and critical messages are on disk when the logging call returns.", "[logger]")
+{
+    QTemporaryDir logDir;
+    REQUIRE(logDir.isValid());
+
+    QString logFilePath = logDir.path() + "/log.txt";
+
+    Logger logger(logFilePath);
+
+    logger.write(QtInfoMsg, "before warning");
+    logger.write(QtWarningMsg, "warning");
+
+    QStringList lines = readLogLines(logFilePath);
+
+    // Messages queued before are written with the same batch.
+    REQUIRE(containsMessage(lines, "before warning"));
+    REQUIRE(containsMessage(lines, "warning"));
+
+    logger.write(QtCriticalMsg, "critical");
+
+    REQUIRE(containsMessage(readLogLines(logFilePath), "critical"));
+}
+
+TEST_CASE("Stopping the writer writes the pending messages, later messages are written synchronously.", "[logger]")
+{
+    QTemporaryDir logDir;
+    REQUIRE(logDir.isValid());
+
+    QString logFilePath = logDir.path() + "/log.txt";
+
+    Logger logger(logFilePath);
+
+    for (int i = 0; i < 100; i++)
+    {
+        logger.write(QtDebugMsg, QString("pending %1").arg(i));
+    }
+
+    logger.stopWriter();
+
+    QStringList lines = readLogLines(logFilePath);
+
+    REQUIRE(lines.size() == 100);
+    REQUIRE(containsMessage(lines, "pending 0"));
+    REQUIRE(containsMessage(lines, "pending 99"));
+
+    logger.write(QtInfoMsg, "after stop");
+
+    REQUIRE(containsMessage(readLogLines(logFilePath), "after stop"));
+}
+
+TEST_CASE("Per call cost of disabled debug logging in a chunk loop.", "[.][logger_benchmark]")
+{
+    const int chunksCount = 1000000;
+
+    Logger::setMinimumLevel(QtInfoMsg);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int i = 0; i < chunksCount; i++)
+    {
+        logDebug("Validating chunk %1 of %2", .arg(QString::number(i), QString::number(chunksCount)));
+    }
+
+    qint64 gatedNsec = timer.nsecsElapsed();
+
+    // Cost of the formatting which used to be paid before Qt dropped the message.
+    timer.restart();
+
+    for (int i = 0; i < chunksCount; i++)
+    {
+        std::string message = QString("Validating chunk %1 of %2").arg(QString::number(i), QString::number(chunksCount)).toStdString();
+    }
+
+    qint64 formattingNsec = timer.nsecsElapsed();
+
+    Logger::setMinimumLevel(QtDebugMsg);
+
+    std::cerr << "Disabled logDebug - " << double(gatedNsec) / chunksCount << " ns per call, "
+              << "formatting - " << double(formattingNsec) / chunksCount << " ns per call" << std::endl;
+
+    REQUIRE(gatedNsec < formattingNsec);
+}
@@ -0,0 +1,229 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "catch.h"
+
+#include <QtNetwork>
+
+#include "src/mirrorcapabilities.h"
+#include "src/downloader.h"
+
+static MirrorCapabilities::Response makeResponse(bool t_rangeRequested, int t_statusCode)
+{
+    MirrorCapabilities::Response response;
+    response.rangeRequested = t_rangeRequested;
+    response.statusCode = t_statusCode;
+
+    return response;
+}
+
+TEST_CASE("Mirror capabilities are learned from replies.", "[mirror_capabilities]")
+{
+    MirrorCapabilities capabilities;
+
+    const QString url = "http://mirror.example.com/content";
+
+    REQUIRE(capabilities.getRangeSupport(url) == MirrorCapabilities::Unknown);
+    REQUIRE(capabilities.getContentSize(url) == -1);
+
+    SECTION("Partial content with a valid Content-Range confirms the support.")
+    {
+        MirrorCapabilities::Response response = makeResponse(true, 206);
+        response.contentRange = "bytes 100-199/1000";
+
+        capabilities.recordResponse(url, response);
+
+        REQUIRE(capabilities.getRangeSupport(url) == MirrorCapabilities::Supported);
+        REQUIRE(capabilities.getRangeSupport("http://mirror.example.com/other") == MirrorCapabilities::Supported);
+        REQUIRE(capabilities.getContentSize(url) == 1000);
+    }
+
+    SECTION("Whole content sent to a Range request means ranges are ignored.")
+    {
+        MirrorCapabilities::Response response = makeResponse(true, 200);
+        response.acceptRanges = "bytes";
+        response.contentLength = 1000;
+
+        capabilities.recordResponse(url, response);
+
+        REQUIRE(capabilities.getRangeSupport(url) == MirrorCapabilities::Unsupported);
+        REQUIRE(capabilities.getContentSize(url) == 1000);
+
+        // Accept-Ranges can't override what a Range request has proven.
+        response.rangeRequested = false;
+        capabilities.recordResponse(url, response);
+
+        REQUIRE(capabilities.getRangeSupport(url) == MirrorCapabilities::Unsupported);
+    }
+
+    SECTION("Length of an encoded body isn't taken as the size of the content.")
+    {
+        MirrorCapabilities::Response response = makeResponse(false, 200);
+        response.contentEncoding = "gzip";
+        response.contentLength = 100;
+
+        capabilities.recordResponse(url, response);
+
+        REQUIRE(capabilities.getContentSize(url) == -1);
+    }
+
+    SECTION("Partial content with a broken Content-Range means ranges are not supported.")
+    {
+        MirrorCapabilities::Response response = makeResponse(true, 206);
+        response.contentRange = "bytes 199-100/1000";
+
+        capabilities.recordResponse(url, response);
+
+        REQUIRE(capabilities.getRangeSupport(url) == MirrorCapabilities::Unsupported);
+    }
+
+    SECTION("Accept-Ranges of a plain reply is taken as a hint.")
+    {
+        MirrorCapabilities::Response response = makeResponse(false, 200);
+        response.acceptRanges = "none";
+
+        capabilities.recordResponse(url, response);
+
+        REQUIRE(capabilities.getRangeSupport(url) == MirrorCapabilities::Unsupported);
+
+        response.acceptRanges = "bytes";
+        capabilities.recordResponse(url, response);
+
+        REQUIRE(capabilities.getRangeSupport(url) == MirrorCapabilities::Supported);
+    }
+
+    SECTION("Replies of urls without a host are not recorded.")
+    {
+        capabilities.recordResponse("link", makeResponse(true, 200));
+
+        REQUIRE(capabilities.getRangeSupport("link") == MirrorCapabilities::Unknown);
+    }
+}
+
+TEST_CASE("Mirrors honoring Range requests are planned first.", "[mirror_capabilities]")
+{
+    MirrorCapabilities capabilities;
+
+    MirrorCapabilities::Response partialContent = makeResponse(true, 206);
+    partialContent.contentRange = "bytes 0-99/1000";
+
+    capabilities.recordResponse("http://ignoring.example.com/content", makeResponse(true, 200));
+    capabilities.recordResponse("http://honoring.example.com/content", partialContent);
+
+    QStringList urls =
+    {
+        "http://ignoring.example.com/content",
+        "http://unknown.example.com/content",
+        "http://honoring.example.com/content",
+        "http://other-unknown.example.com/content"
+    };
+
+    REQUIRE(capabilities.planRangeDownloads(urls) == QStringList({
+        "http://honoring.example.com/content",
+        "http://unknown.example.com/content",
+        "http://other-unknown.example.com/content",
+        "http://ignoring.example.com/content"
+    }));
+}
+
+TEST_CASE("Hosts which have failed with HTTP/2 are talked to with HTTP/1.1.", "[mirror_capabilities]")
+{
+    MirrorCapabilities capabilities;
+
+    REQUIRE(capabilities.isHttp2Allowed("http://h2.example.com/content"));
+
+    capabilities.reportHttp2Failure("http://h2.example.com/content");
+
+    // Fallback is a property of the server software, so it's kept for the whole host.
+    REQUIRE(!capabilities.isHttp2Allowed("http://h2.example.com/content"));
+    REQUIRE(!capabilities.isHttp2Allowed("http://h2.example.com/other-content"));
+
+    REQUIRE(capabilities.isHttp2Allowed("http://h2.example.com:8080/content"));
+    REQUIRE(capabilities.isHttp2Allowed("http://other-h2.example.com/content"));
+
+    capabilities.clear();
+
+    REQUIRE(capabilities.isHttp2Allowed("http://h2.example.com/content"));
+}
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+
+// Fails with a protocol error, as if HTTP/2 was allowed for the request or not.
+class ProtocolFailureReply : public QNetworkReply
+{
+public:
+    ProtocolFailureReply(const QNetworkRequest& t_request, bool t_isHttp2Allowed)
+    {
+        QNetworkRequest request = t_request;
+        request.setAttribute(QNetworkRequest::Http2AllowedAttribute, t_isHttp2Allowed);
+
+        setRequest(request);
+        setUrl(request.url());
+        setError(QNetworkReply::ProtocolFailure, "Protocol failure");
+        setFinished(true);
+
+        open(ReadOnly | Unbuffered);
+    }
+
+    void abort() override
+    {
+    }
+
+protected:
+    qint64 readData(char*, qint64) override
+    {
+        return -1;
+    }
+};
+
+class ProtocolFailureNAM : public QNetworkAccessManager
+{
+public:
+    ProtocolFailureNAM(bool t_isHttp2Allowed)
+        : m_isHttp2Allowed(t_isHttp2Allowed)
+    {
+    }
+
+protected:
+    QNetworkReply* createRequest(Operation, const QNetworkRequest& t_request, QIODevice*) override
+    {
+        return new ProtocolFailureReply(t_request, m_isHttp2Allowed);
+    }
+
+private:
+    bool m_isHttp2Allowed;
+};
+
+TEST_CASE("Protocol failure of an HTTP/2 request makes the downloader fall back to HTTP/1.1.", "[mirror_capabilities]")
+{
+    std::shared_ptr<CancellationTokenSource> tokenSource(new CancellationTokenSource());
+    CancellationToken token(tokenSource);
+
+    MirrorCapabilities& capabilities = MirrorCapabilities::getInstance();
+
+    SECTION("HTTP/2 request marks the host.")
+    {
+        const QString url = "http://h2-failing.example.com/content";
+
+        ProtocolFailureNAM nam(true);
+        Downloader downloader(&nam, token);
+
+        REQUIRE_THROWS(downloader.downloadFile(url, 1000));
+        REQUIRE(!capabilities.isHttp2Allowed(url));
+    }
+
+    SECTION("HTTP/1.1 request doesn't mark the host.")
+    {
+        const QString url = "http://h1-failing.example.com/content";
+
+        ProtocolFailureNAM nam(false);
+        Downloader downloader(&nam, token);
+
+        REQUIRE_THROWS(downloader.downloadFile(url, 1000));
+        REQUIRE(capabilities.isHttp2Allowed(url));
+    }
+}
+
+#endif
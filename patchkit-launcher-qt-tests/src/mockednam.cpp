@@ -5,6 +5,8 @@
 
 #include "mockednam.h"
 
+#include "src/byteranges.h"
+
 MockedNAM::MockedNAM()
     : QNetworkAccessManager()
     , m_repliesToCorrupt(0)
@@ -40,13 +42,6 @@ QNetworkReply* MockedNAM::createRequest(QNetworkAccessManager::Operation /*op*/,
 {
     QString url = request.url().toString();
 
-    qint64 offset = 0;
-
-    if (request.hasRawHeader("Range"))
-    {
-        offset = parseRangeHeader(request.rawHeader("Range"));
-    }
-
     if (!m_replyDefinitions.contains(url))
     {
         return nullptr;
@@ -57,7 +52,14 @@ QNetworkReply* MockedNAM::createRequest(QNetworkAccessManager::Operation /*op*/,
 
     MockedNetworkReply* reply = new MockedNetworkReply(def.delay, def.data, def.statusCode);
 
-    reply->setOffset(offset);
+    QVector<ByteRanges::TRange> ranges;
+
+    // Only the first range is served, just like some servers do.
+    if (def.statusCode == 200 && request.hasRawHeader("Range")
+        && ByteRanges::parseRangeHeader(request.rawHeader("Range"), def.data.size(), ranges))
+    {
+        reply->setRange(ranges.first().first, ranges.first().second);
+    }
 
     if (m_repliesToCorrupt != 0)
     {
@@ -69,29 +71,3 @@ QNetworkReply* MockedNAM::createRequest(QNetworkAccessManager::Operation /*op*/,
 
     return reply;
 }
-
-qint64 MockedNAM::parseRangeHeader(const QByteArray& t_rangeHeader)
-{
-    if (t_rangeHeader.size() == 0)
-    {
-        return 0;
-    }
-
-    // Header is formulated as so: "bytes=start-end"
-    // We only care about start so it'll be assumed the header is of form "bytes=start-"
-
-    QString header (t_rangeHeader);
-
-    QStringList tokens = header.split('=');
-
-    if (tokens.size() < 2)
-    {
-        return 0;
-    }
-
-    QString offsetString = tokens.at(1);
-    offsetString = offsetString.mid(0, offsetString.size() - 1);
-
-    return offsetString.toLongLong();
-}
-
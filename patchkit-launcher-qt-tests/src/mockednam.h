@@ -49,8 +49,6 @@ private:
 
     int m_repliesToCorrupt;
 
-    qint64 parseRangeHeader(const QByteArray& t_rangeHeader);
-
     QMap<QString, ReplyDefinition> m_replyDefinitions;
 };
 
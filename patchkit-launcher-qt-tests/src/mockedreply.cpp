@@ -34,6 +34,26 @@ void MockedNetworkReply::setOffset(qint64 t_offset)
     m_contentOffset = t_offset;
 }
 
+void MockedNetworkReply::setRange(qint64 t_first, qint64 t_last)
+{
+    qint64 size = m_content.size();
+
+    t_last = qMin(t_last, size - 1);
+
+    setRawHeader("Content-Range", "bytes " + QByteArray::number(t_first) + "-" + QByteArray::number(t_last)
+                 + "/" + QByteArray::number(size));
+    setContent(m_content.mid(int(t_first), int(t_last - t_first + 1)));
+
+    m_statusCode = 206;
+}
+
+void MockedNetworkReply::setMultipart(const QByteArray& t_boundary)
+{
+    setRawHeader("Content-Type", "multipart/byteranges; boundary=" + t_boundary);
+
+    m_statusCode = 206;
+}
+
 void MockedNetworkReply::launch()
 {
     open(ReadOnly | Unbuffered);
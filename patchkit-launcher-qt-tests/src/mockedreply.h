@@ -20,6 +20,12 @@ public:
 
     void setOffset(qint64 t_offset);
 
+    // Replies with 206 and only the given range of the content.
+    void setRange(qint64 t_first, qint64 t_last);
+
+    // Replies with 206 and the content as a "multipart/byteranges" body.
+    void setMultipart(const QByteArray& t_boundary);
+
     void launch();
     void corrupt();
 
@@ -0,0 +1,107 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "catch.h"
+
+#include <QtNetwork>
+#include <QTemporaryDir>
+
+#include "src/peerchunkserver.h"
+#include "src/peerdiscovery.h"
+#include "src/chunkeddownloader.h"
+#include "src/contentsummary.h"
+
+SCENARIO("Launchers on loopback can share a patcher archive.", "[peer_sharing]")
+{
+    std::shared_ptr<CancellationTokenSource> tokenSource(new CancellationTokenSource());
+    CancellationToken token(tokenSource);
+
+    GIVEN("A peer cache containing an archive served by a peer chunk server.")
+    {
+        const QByteArray data = "ABCDEFGHIJ";
+        const QString contentId = "abc123";
+
+        QTemporaryDir cacheDir;
+        REQUIRE(cacheDir.isValid());
+
+        QFile cacheFile(cacheDir.path() + "/" + contentId);
+        REQUIRE(cacheFile.open(QIODevice::WriteOnly));
+        cacheFile.write(data);
+        cacheFile.close();
+
+        PeerChunkServer server(cacheDir.path());
+        REQUIRE(server.start());
+
+        quint16 discoveryPort = 43000 + (QCoreApplication::applicationPid() % 1000);
+
+        PeerDiscovery responder(discoveryPort, QHostAddress::LocalHost);
+        REQUIRE(responder.startResponding(cacheDir.path(), server.serverPort()));
+
+        WHEN("Another launcher looks for the archive.")
+        {
+            PeerDiscovery discovery(discoveryPort, QHostAddress::LocalHost);
+            QStringList peers = discovery.findPeers(contentId, 500, token);
+
+            THEN("The serving launcher should be found.")
+            {
+                REQUIRE(peers.size() == 1);
+                REQUIRE(peers[0] == QString("http://127.0.0.1:%1/%2").arg(QString::number(server.serverPort()), contentId));
+            }
+        }
+
+        WHEN("Another launcher looks for an archive which isn't shared.")
+        {
+            PeerDiscovery discovery(discoveryPort, QHostAddress::LocalHost);
+            QStringList peers = discovery.findPeers("def456", 500, token);
+
+            THEN("No peers should be found.")
+            {
+                REQUIRE(peers.isEmpty());
+            }
+        }
+
+        WHEN("The archive is downloaded in chunks from the peer.")
+        {
+            ContentSummary summary(1, 0, "none", "none", "xxHash",
+            {
+                HashingStrategy::xxHash(data.mid(0, 1)),
+                HashingStrategy::xxHash(data.mid(1, 1)),
+                HashingStrategy::xxHash(data.mid(2, 1)),
+                HashingStrategy::xxHash(data.mid(3, 1)),
+                HashingStrategy::xxHash(data.mid(4, 1)),
+                HashingStrategy::xxHash(data.mid(5, 1)),
+                HashingStrategy::xxHash(data.mid(6, 1)),
+                HashingStrategy::xxHash(data.mid(7, 1)),
+                HashingStrategy::xxHash(data.mid(8, 1)),
+                HashingStrategy::xxHash(data.mid(9, 1))
+            },
+            {});
+
+            QNetworkAccessManager nam;
+            ChunkedDownloader downloader(&nam, summary, &HashingStrategy::xxHashStream, token);
+
+            QString url = QString("http://127.0.0.1:%1/%2").arg(QString::number(server.serverPort()), contentId);
+
+            THEN("The downloaded data should match the shared archive.")
+            {
+                REQUIRE(downloader.downloadFile(url, 1000).toStdString() == data.toStdString());
+            }
+        }
+    }
+}
+
+TEST_CASE("Peer chunk server accepts only local peers.", "[peer_sharing]")
+{
+    REQUIRE(PeerChunkServer::isLocalPeer(QHostAddress::LocalHost));
+    REQUIRE(PeerChunkServer::isLocalPeer(QHostAddress::LocalHost, QHostAddress::LocalHost));
+    REQUIRE(!PeerChunkServer::isLocalPeer(QHostAddress("8.8.8.8")));
+
+    QTemporaryDir cacheDir;
+    REQUIRE(cacheDir.isValid());
+
+    PeerChunkServer server(cacheDir.path());
+    REQUIRE(server.start(QHostAddress::LocalHost));
+    REQUIRE(server.serverAddress() == QHostAddress(QHostAddress::LocalHost));
+}
@@ -0,0 +1,114 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "catch.h"
+
+#include "src/progressaggregator.h"
+
+TEST_CASE("Progress aggregator samples notifications at a fixed rate.", "[progress_aggregator]")
+{
+    qint64 currentMsec = 0;
+
+    ProgressAggregator aggregator(100, [&currentMsec]() { return currentMsec; });
+
+    REQUIRE(aggregator.update(0, 1024 * 1024));
+    REQUIRE(aggregator.percent() == 0);
+
+    SECTION("Notifications within the interval are dropped.")
+    {
+        int updatesCount = 0;
+
+        for (int i = 1; i <= 1000; i++)
+        {
+            currentMsec = i;
+
+            if (aggregator.update(i * 1024, 1024 * 1024))
+            {
+                updatesCount++;
+            }
+        }
+
+        REQUIRE(updatesCount == 10);
+    }
+
+    SECTION("Unchanged progress isn't reported.")
+    {
+        currentMsec = 200;
+
+        REQUIRE_FALSE(aggregator.update(0, 1024 * 1024));
+    }
+
+    SECTION("Completion is always reported.")
+    {
+        currentMsec = 1;
+
+        REQUIRE(aggregator.update(1024 * 1024, 1024 * 1024));
+        REQUIRE(aggregator.percent() == 100);
+        REQUIRE(aggregator.status() == "Downloading 1024 / 1024 KB");
+    }
+}
+
+TEST_CASE("Progress aggregator estimates speed and time left.", "[progress_aggregator]")
+{
+    qint64 currentMsec = 0;
+
+    ProgressAggregator aggregator(100, [&currentMsec]() { return currentMsec; });
+
+    const qint64 totalBytes = 100 * 1024 * 1024;
+
+    aggregator.update(0, totalBytes);
+
+    REQUIRE(aggregator.bytesPerSecond() < 0);
+    REQUIRE(aggregator.secondsLeft() == -1);
+
+    SECTION("Steady transfer.")
+    {
+        // 1 MB/s
+        for (int i = 1; i <= 10; i++)
+        {
+            currentMsec = i * 1000;
+            aggregator.update(i * 1024 * 1024, totalBytes);
+        }
+
+        REQUIRE(aggregator.bytesPerSecond() == Approx(1024 * 1024));
+        REQUIRE(aggregator.secondsLeft() == 90);
+        REQUIRE(aggregator.status() == "Downloading 10240 / 102400 KB (1.0 MB/s, 1:30 left)");
+    }
+
+    SECTION("Speed changes are smoothed.")
+    {
+        currentMsec = 1000;
+        aggregator.update(1024 * 1024, totalBytes);
+
+        currentMsec = 2000;
+        aggregator.update(4 * 1024 * 1024, totalBytes);
+
+        REQUIRE(aggregator.bytesPerSecond() > 1024 * 1024);
+        REQUIRE(aggregator.bytesPerSecond() < 3 * 1024 * 1024);
+    }
+
+    SECTION("Restarted download is measured from the new position.")
+    {
+        currentMsec = 1000;
+        aggregator.update(1024 * 1024, totalBytes);
+
+        currentMsec = 2000;
+        aggregator.update(0, totalBytes);
+
+        REQUIRE(aggregator.bytesPerSecond() == Approx(1024 * 1024));
+
+        currentMsec = 3000;
+        aggregator.update(1024 * 1024, totalBytes);
+
+        REQUIRE(aggregator.bytesPerSecond() == Approx(1024 * 1024));
+    }
+}
+
+TEST_CASE("Progress aggregator formats durations.", "[progress_aggregator]")
+{
+    REQUIRE(ProgressAggregator::formatDuration(5) == "0:05");
+    REQUIRE(ProgressAggregator::formatDuration(125) == "2:05");
+    REQUIRE(ProgressAggregator::formatDuration(3725) == "1:02:05");
+}
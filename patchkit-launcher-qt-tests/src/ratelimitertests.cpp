@@ -0,0 +1,88 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "catch.h"
+
+#include "src/ratelimiter.h"
+
+TEST_CASE("Rate limiter without a limit grants everything.", "[rate_limiter]")
+{
+    RateLimiter limiter(0);
+
+    REQUIRE(limiter.acquire(1024 * 1024) == 1024 * 1024);
+    REQUIRE(limiter.acquire(1024 * 1024) == 1024 * 1024);
+}
+
+TEST_CASE("Rate limiter grants bytes according to the limit.", "[rate_limiter]")
+{
+    const qint64 bytesPerSecond = 400 * 1024;
+
+    qint64 nowMsec = 0;
+    RateLimiter limiter(bytesPerSecond, nullptr, [&nowMsec]() { return nowMsec; });
+
+    REQUIRE(limiter.acquire(bytesPerSecond) == 0);
+
+    nowMsec = 100;
+
+    // After 100 ms a tenth of the limit is available.
+    REQUIRE(limiter.acquire(bytesPerSecond) == bytesPerSecond / 10);
+
+    // The bucket is drained, nothing has been refilled in the meantime.
+    REQUIRE(limiter.acquire(bytesPerSecond) == 0);
+
+    nowMsec = 2000;
+
+    // Never more than the burst - a quarter of the limit.
+    REQUIRE(limiter.acquire(bytesPerSecond) == bytesPerSecond / 4);
+
+    SECTION("Limit can be lifted at runtime.")
+    {
+        limiter.setBytesPerSecond(0);
+
+        REQUIRE(limiter.acquire(bytesPerSecond) == bytesPerSecond);
+    }
+}
+
+TEST_CASE("Rate limiter tells when the bytes will be available.", "[rate_limiter]")
+{
+    const qint64 bytesPerSecond = 64 * 1024;
+
+    qint64 nowMsec = 0;
+    RateLimiter limiter(bytesPerSecond, nullptr, [&nowMsec]() { return nowMsec; });
+
+    // 4 KB, the minimal grant, is refilled in 62.5 ms.
+    REQUIRE(limiter.msecsUntilAvailable() == 63);
+
+    nowMsec = 63;
+
+    REQUIRE(limiter.acquire(1024 * 1024) == 4128);
+    REQUIRE(RateLimiter(0).msecsUntilAvailable() == 1);
+}
+
+TEST_CASE("Background rate limiter is bounded by the foreground one.", "[rate_limiter]")
+{
+    qint64 nowMsec = 0;
+    RateLimiter::TClock clock = [&nowMsec]() { return nowMsec; };
+
+    RateLimiter foreground(64 * 1024, nullptr, clock);
+    RateLimiter background(0, &foreground, clock);
+
+    nowMsec = 100;
+
+    // 100 ms of the foreground limit.
+    REQUIRE(background.acquire(1024 * 1024) == 6553);
+    REQUIRE(foreground.acquire(1024 * 1024) == 0);
+
+    SECTION("Background limit caps background downloads below the foreground limit.")
+    {
+        background.setBytesPerSecond(32 * 1024);
+
+        nowMsec = 200;
+
+        // 100 ms of the background limit, the rest of the foreground limit is left for foreground downloads.
+        REQUIRE(background.acquire(1024 * 1024) == 3276);
+        REQUIRE(foreground.acquire(1024 * 1024) == 3278);
+    }
+}
@@ -0,0 +1,87 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "catch.h"
+
+#include <QThread>
+
+#include "src/retrybackoff.h"
+#include "src/circuitbreaker.h"
+
+TEST_CASE("Retry backoff delays are jittered and capped.", "[retry_backoff]")
+{
+    const int baseMsec = 100;
+    const int capMsec = 5000;
+
+    RetryBackoff backoff(baseMsec, capMsec, 42);
+
+    int previousDelay = baseMsec;
+    int maxDelay = 0;
+
+    for (int i = 0; i < 100; i++)
+    {
+        int delay = backoff.nextDelay();
+
+        REQUIRE(delay >= baseMsec);
+        REQUIRE(delay <= capMsec);
+        REQUIRE(delay <= previousDelay * 3);
+
+        previousDelay = delay;
+        maxDelay = qMax(maxDelay, delay);
+    }
+
+    CHECK(maxDelay > baseMsec * 3);
+
+    SECTION("Reset brings the delays back to the base.")
+    {
+        backoff.reset();
+
+        REQUIRE(backoff.nextDelay() <= baseMsec * 3);
+    }
+}
+
+TEST_CASE("Retry backoffs with different seeds don't retry in lockstep.", "[retry_backoff]")
+{
+    RetryBackoff first(100, 5000, 1);
+    RetryBackoff second(100, 5000, 2);
+
+    bool differ = false;
+
+    for (int i = 0; i < 10; i++)
+    {
+        differ = differ || first.nextDelay() != second.nextDelay();
+    }
+
+    REQUIRE(differ);
+}
+
+TEST_CASE("Circuit breaker skips a failing mirror for a while.", "[circuit_breaker]")
+{
+    CircuitBreaker circuitBreaker(2, 200);
+
+    circuitBreaker.recordFailure("mirror");
+    REQUIRE(circuitBreaker.isAllowed("mirror"));
+
+    circuitBreaker.recordFailure("mirror");
+    REQUIRE(!circuitBreaker.isAllowed("mirror"));
+    REQUIRE(circuitBreaker.isAllowed("other mirror"));
+
+    QThread::msleep(250);
+
+    REQUIRE(circuitBreaker.isAllowed("mirror"));
+
+    SECTION("Failure of the half-open mirror opens the circuit again.")
+    {
+        circuitBreaker.recordFailure("mirror");
+        REQUIRE(!circuitBreaker.isAllowed("mirror"));
+    }
+
+    SECTION("Success of the half-open mirror closes the circuit.")
+    {
+        circuitBreaker.recordSuccess("mirror");
+        circuitBreaker.recordFailure("mirror");
+        REQUIRE(circuitBreaker.isAllowed("mirror"));
+    }
+}
@@ -0,0 +1,140 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "catch.h"
+
+#include <QTemporaryDir>
+
+#include "src/stagedpatcherdata.h"
+#include "src/locations.h"
+#include "src/ioutils.h"
+
+#include "currentdirscope.h"
+
+struct StagingTestData : public Data
+{
+    StagingTestData(const QString& t_patcherSecret)
+        : m_patcherSecret(t_patcherSecret)
+    {
+    }
+
+    QString patcherSecret() const override
+    {
+        return m_patcherSecret;
+    }
+
+private:
+    QString m_patcherSecret;
+};
+
+static QString writeDownloadedArchive(const QByteArray& t_contents)
+{
+    IOUtils::createDir(Locations::getInstance().patcherStagingDirPath());
+
+    QFile file(StagedPatcherData::partialArchivePath());
+
+    REQUIRE(file.open(QIODevice::WriteOnly));
+    REQUIRE(file.write(t_contents) == t_contents.size());
+
+    return file.fileName();
+}
+
+SCENARIO("Patcher archives are staged and taken for installation.", "[staged_patcher]")
+{
+    QTemporaryDir currentDir;
+    REQUIRE(currentDir.isValid());
+
+    CurrentDirScope currentDirScope(currentDir.path());
+
+    Locations& locations = Locations::getInstance();
+
+    StagingTestData data("xxpatcherxx");
+    StagedPatcherData stagedPatcher;
+
+    QString targetPath = currentDir.path() + "/patcher.zip";
+
+    GIVEN("A staged archive of version 5.")
+    {
+        REQUIRE(stagedPatcher.stage(writeDownloadedArchive("archive"), data, 5));
+
+        THEN("It should be staged with its version.")
+        {
+            REQUIRE(stagedPatcher.isStaged(5, data));
+            REQUIRE(stagedPatcher.getStagedVersion(data) == 5);
+            REQUIRE(!QFile::exists(StagedPatcherData::partialArchivePath()));
+        }
+
+        WHEN("Version 5 is taken.")
+        {
+            REQUIRE(stagedPatcher.takeArchive(5, data, targetPath));
+
+            THEN("The archive should be moved to the target path and the staging info should be removed.")
+            {
+                REQUIRE(IOUtils::readTextFromFile(targetPath) == "archive");
+
+                REQUIRE(!QFile::exists(locations.patcherStagingArchiveFilePath()));
+                REQUIRE(!QFile::exists(locations.patcherStagingVersionInfoFilePath()));
+                REQUIRE(!QFile::exists(locations.patcherStagingIdInfoFilePath()));
+
+                REQUIRE(!stagedPatcher.isStaged(5, data));
+                REQUIRE(stagedPatcher.getStagedVersion(data) == -1);
+            }
+        }
+
+        WHEN("Another version is taken.")
+        {
+            THEN("Nothing should be taken and the archive should stay staged.")
+            {
+                REQUIRE(!stagedPatcher.isStaged(6, data));
+                REQUIRE(!stagedPatcher.takeArchive(6, data, targetPath));
+
+                REQUIRE(!QFile::exists(targetPath));
+                REQUIRE(stagedPatcher.isStaged(5, data));
+            }
+        }
+
+        WHEN("The archive is taken for another patcher.")
+        {
+            StagingTestData otherData("xxotherxx");
+
+            THEN("Nothing should be taken and the archive should stay staged.")
+            {
+                REQUIRE(!stagedPatcher.isStaged(5, otherData));
+                REQUIRE(!stagedPatcher.takeArchive(5, otherData, targetPath));
+
+                REQUIRE(!QFile::exists(targetPath));
+                REQUIRE(stagedPatcher.isStaged(5, data));
+            }
+        }
+
+        WHEN("A newer archive is staged.")
+        {
+            REQUIRE(stagedPatcher.stage(writeDownloadedArchive("newer archive"), data, 6));
+
+            THEN("Only the newer archive should be taken.")
+            {
+                REQUIRE(!stagedPatcher.takeArchive(5, data, targetPath));
+                REQUIRE(stagedPatcher.takeArchive(6, data, targetPath));
+                REQUIRE(IOUtils::readTextFromFile(targetPath) == "newer archive");
+            }
+        }
+    }
+
+    GIVEN("A half staged archive without version info.")
+    {
+        IOUtils::createDir(locations.patcherStagingDirPath());
+        IOUtils::writeTextToFile(locations.patcherStagingArchiveFilePath(), "archive");
+        IOUtils::writeTextToFile(locations.patcherStagingIdInfoFilePath(), "patcher");
+
+        THEN("It should never be taken.")
+        {
+            REQUIRE(!stagedPatcher.isStaged(5, data));
+            REQUIRE(stagedPatcher.getStagedVersion(data) == -1);
+            REQUIRE(!stagedPatcher.takeArchive(5, data, targetPath));
+
+            REQUIRE(!QFile::exists(targetPath));
+        }
+    }
+}
@@ -0,0 +1,42 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "catch.h"
+
+#include <QJsonObject>
+#include <QJsonArray>
+
+#include "src/telemetry.h"
+
+TEST_CASE("Telemetry report contains stages, counters, timings and values.", "[telemetry]")
+{
+    Telemetry& telemetry = Telemetry::getInstance();
+
+    {
+        Telemetry::Stage stage("telemetry_test_stage");
+    }
+
+    telemetry.addCounter("telemetry_test_counter", 2);
+    telemetry.addCounter("telemetry_test_counter");
+    telemetry.setTimingOnce("telemetry_test_timing", 120);
+    telemetry.setTimingOnce("telemetry_test_timing", 250);
+    telemetry.setValue("telemetry_test_value", "value");
+
+    QJsonObject report = telemetry.toJson().object();
+
+    bool hasStage = false;
+
+    for (const QJsonValue& stage : report["stages"].toArray())
+    {
+        hasStage = hasStage || stage.toObject()["name"].toString() == "telemetry_test_stage";
+    }
+
+    REQUIRE(hasStage);
+    REQUIRE(report["counters"].toObject()["telemetry_test_counter"].toDouble() == 3);
+    REQUIRE(report["timings"].toObject()["telemetry_test_timing"].toDouble() == 120);
+    REQUIRE_FALSE(report["counters"].toObject().contains("telemetry_test_timing"));
+    REQUIRE(report["values"].toObject()["telemetry_test_value"].toString() == "value");
+    REQUIRE(report["total_msec"].toDouble() >= 0);
+}
@@ -0,0 +1,415 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "testhttpserver.h"
+
+#include <limits>
+
+#include <QTcpSocket>
+
+const qint64 TestHttpServer::pieceSize          = 16 * 1024;
+const qint64 TestHttpServer::maxBytesToWrite    = 64 * 1024;
+const int    TestHttpServer::pacingIntervalMsec = 5;
+
+TestHttpServer::TestHttpServer(QObject* t_parent)
+    : QTcpServer(t_parent)
+{
+    m_pacingTimer.setInterval(pacingIntervalMsec);
+
+    connect(this, &QTcpServer::newConnection, this, &TestHttpServer::onNewConnection);
+    connect(&m_pacingTimer, &QTimer::timeout, this, &TestHttpServer::onPacingTimeout);
+}
+
+bool TestHttpServer::start()
+{
+    return listen(QHostAddress::LocalHost, 0);
+}
+
+QString TestHttpServer::url(const QString& t_path) const
+{
+    return QString("http://127.0.0.1:%1%2").arg(QString::number(serverPort()), t_path);
+}
+
+void TestHttpServer::setContent(const QString& t_path, const QByteArray& t_content, const Profile& t_profile)
+{
+    Resource resource;
+    resource.content = t_content;
+    resource.profile = t_profile;
+
+    m_resources.insert(t_path, resource);
+}
+
+int TestHttpServer::requestsCount(const QString& t_path) const
+{
+    return m_resources.value(t_path).requestsCount;
+}
+
+QList<QByteArray> TestHttpServer::rangeHeaders(const QString& t_path) const
+{
+    return m_resources.value(t_path).rangeHeaders;
+}
+
+void TestHttpServer::onNewConnection()
+{
+    while (hasPendingConnections())
+    {
+        QTcpSocket* socket = nextPendingConnection();
+
+        m_connections.insert(socket, Connection());
+
+        connect(socket, &QTcpSocket::readyRead, this, &TestHttpServer::onReadyRead);
+        connect(socket, &QTcpSocket::bytesWritten, this, &TestHttpServer::onBytesWritten);
+        connect(socket, &QTcpSocket::disconnected, this, &TestHttpServer::onDisconnected);
+    }
+}
+
+void TestHttpServer::onReadyRead()
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+
+    if (!socket || !m_connections.contains(socket))
+    {
+        return;
+    }
+
+    Connection& connection = m_connections[socket];
+
+    if (connection.isResponding)
+    {
+        socket->readAll();
+        return;
+    }
+
+    connection.request += socket->readAll();
+
+    if (connection.request.contains("\r\n\r\n"))
+    {
+        connection.isResponding = true;
+        handleRequest(socket, connection);
+    }
+}
+
+void TestHttpServer::onBytesWritten()
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+
+    if (!socket || !m_connections.contains(socket))
+    {
+        return;
+    }
+
+    pump(socket, m_connections[socket]);
+}
+
+void TestHttpServer::onDisconnected()
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+
+    if (!socket)
+    {
+        return;
+    }
+
+    m_connections.remove(socket);
+    socket->deleteLater();
+
+    if (m_connections.isEmpty())
+    {
+        m_pacingTimer.stop();
+    }
+}
+
+void TestHttpServer::onPacingTimeout()
+{
+    // Pumping may disconnect a socket, which removes it from the connections.
+    for (QTcpSocket* socket : m_connections.keys())
+    {
+        if (m_connections.contains(socket))
+        {
+            pump(socket, m_connections[socket]);
+        }
+    }
+}
+
+void TestHttpServer::handleRequest(QTcpSocket* t_socket, Connection& t_connection)
+{
+    QList<QByteArray> lines = t_connection.request.split('\n');
+    QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+
+    if (requestLine.size() < 2 || requestLine[0] != "GET")
+    {
+        respond(t_socket, 400, "Bad Request");
+        return;
+    }
+
+    QString path = QString::fromLatin1(requestLine[1]);
+
+    if (!m_resources.contains(path))
+    {
+        respond(t_socket, 404, "Not Found");
+        return;
+    }
+
+    Resource& resource = m_resources[path];
+    resource.requestsCount++;
+
+    t_connection.content = resource.content;
+    t_connection.profile = resource.profile;
+    t_connection.isFaulty = resource.profile.faultyRequestsCount < 0
+                         || resource.requestsCount <= resource.profile.faultyRequestsCount;
+
+    qint64 size = resource.content.size();
+    qint64 start = 0;
+    qint64 end = size - 1;
+    bool isRangeRequest = false;
+    QVector<ByteRanges::TRange> ranges;
+
+    for (const QByteArray& line : lines)
+    {
+        if (!line.toLower().startsWith("range:"))
+        {
+            continue;
+        }
+
+        QByteArray rangeHeader = line.mid(6).trimmed();
+        resource.rangeHeaders.append(rangeHeader);
+
+        if (!resource.profile.supportsRanges)
+        {
+            continue;
+        }
+
+        if (!ByteRanges::parseRangeHeader(rangeHeader, size, ranges))
+        {
+            respond(t_socket, 416, "Range Not Satisfiable");
+            return;
+        }
+
+        start = ranges.first().first;
+        end = ranges.first().second;
+        isRangeRequest = true;
+    }
+
+    if (t_connection.isFaulty && resource.profile.statusCode != 200)
+    {
+        respond(t_socket, resource.profile.statusCode, "Injected Error");
+        return;
+    }
+
+    QByteArray header;
+
+    if (ranges.size() > 1 && resource.profile.supportsMultipartRanges)
+    {
+        const QByteArray boundary = "TEST_HTTP_SERVER_BOUNDARY";
+
+        t_connection.content = multipartBody(resource.content, ranges, boundary);
+        t_connection.isFaulty = false;
+
+        start = 0;
+        end = t_connection.content.size() - 1;
+
+        header += "HTTP/1.1 206 Partial Content\r\n";
+        header += "Content-Type: multipart/byteranges; boundary=" + boundary + "\r\n";
+    }
+    else if (isRangeRequest)
+    {
+        header += "HTTP/1.1 206 Partial Content\r\n";
+        header += "Content-Range: bytes " + QByteArray::number(start) + "-" + QByteArray::number(end)
+                + "/" + QByteArray::number(size) + "\r\n";
+    }
+    else
+    {
+        header += "HTTP/1.1 200 OK\r\n";
+    }
+
+    if (!header.contains("Content-Type"))
+    {
+        header += "Content-Type: application/octet-stream\r\n";
+    }
+
+    header += "Content-Length: " + QByteArray::number(end - start + 1) + "\r\n";
+
+    if (resource.profile.supportsRanges)
+    {
+        header += "Accept-Ranges: bytes\r\n";
+    }
+
+    header += "Connection: close\r\n\r\n";
+
+    t_connection.header = header;
+    t_connection.position = start;
+    t_connection.end = end;
+
+    if (t_connection.profile.latencyMsec > 0)
+    {
+        QTimer::singleShot(t_connection.profile.latencyMsec, t_socket, [this, t_socket]()
+        {
+            startSending(t_socket);
+        });
+    }
+    else
+    {
+        startSending(t_socket);
+    }
+}
+
+void TestHttpServer::startSending(QTcpSocket* t_socket)
+{
+    if (!m_connections.contains(t_socket))
+    {
+        return;
+    }
+
+    Connection& connection = m_connections[t_socket];
+
+    t_socket->write(connection.header);
+
+    connection.isSending = true;
+    connection.clock.start();
+    connection.bytesSentSinceClockStart = 0;
+
+    if (!m_pacingTimer.isActive())
+    {
+        m_pacingTimer.start();
+    }
+
+    pump(t_socket, connection);
+}
+
+void TestHttpServer::pump(QTcpSocket* t_socket, Connection& t_connection)
+{
+    if (!t_connection.isSending)
+    {
+        return;
+    }
+
+    const Profile& profile = t_connection.profile;
+
+    while (t_connection.position <= t_connection.end && t_socket->bytesToWrite() < maxBytesToWrite)
+    {
+        if (t_connection.stallClock.isValid())
+        {
+            if (t_connection.stallClock.elapsed() < profile.stallMsec)
+            {
+                return;
+            }
+
+            // Transfer starts over after the stall, slow start included.
+            t_connection.stallClock.invalidate();
+            t_connection.clock.restart();
+            t_connection.bytesSentSinceClockStart = 0;
+        }
+
+        qint64 allowed = allowedBytes(t_connection);
+
+        if (allowed <= 0)
+        {
+            return;
+        }
+
+        qint64 next = qMin(t_connection.end + 1, t_connection.position + qMin(pieceSize, allowed));
+
+        if (t_connection.isFaulty && !t_connection.hasStalled
+            && profile.stallAtByte >= t_connection.position && profile.stallAtByte < next)
+        {
+            if (profile.stallAtByte == t_connection.position)
+            {
+                t_connection.hasStalled = true;
+                t_connection.stallClock.start();
+                continue;
+            }
+
+            next = profile.stallAtByte;
+        }
+
+        bool truncate = t_connection.isFaulty
+                     && profile.truncateAtByte >= t_connection.position && profile.truncateAtByte < next;
+
+        if (truncate)
+        {
+            next = profile.truncateAtByte;
+        }
+
+        QByteArray piece = t_connection.content.mid(int(t_connection.position), int(next - t_connection.position));
+
+        if (t_connection.isFaulty && profile.corruptAtByte >= t_connection.position && profile.corruptAtByte < next)
+        {
+            int index = int(profile.corruptAtByte - t_connection.position);
+            piece[index] = char(piece[index] ^ 0xFF);
+        }
+
+        t_socket->write(piece);
+
+        t_connection.position = next;
+        t_connection.bytesSentSinceClockStart += piece.size();
+
+        if (truncate)
+        {
+            // Connection is closed once the data written so far is sent.
+            t_connection.isSending = false;
+            t_socket->disconnectFromHost();
+            return;
+        }
+    }
+
+    if (t_connection.position > t_connection.end)
+    {
+        t_connection.isSending = false;
+        t_socket->disconnectFromHost();
+    }
+}
+
+void TestHttpServer::respond(QTcpSocket* t_socket, int t_statusCode, const QByteArray& t_reason)
+{
+    QByteArray response = "HTTP/1.1 " + QByteArray::number(t_statusCode) + " " + t_reason + "\r\n"
+                        + "Content-Length: 0\r\n"
+                        + "Connection: close\r\n\r\n";
+
+    t_socket->write(response);
+    t_socket->disconnectFromHost();
+}
+
+qint64 TestHttpServer::allowedBytes(const Connection& t_connection)
+{
+    const Profile& profile = t_connection.profile;
+
+    if (profile.bytesPerSecond <= 0)
+    {
+        return std::numeric_limits<qint64>::max();
+    }
+
+    double elapsedMsec = t_connection.clock.elapsed();
+    double budget;
+
+    // Bandwidth grows linearly during slow start, the budget is its integral.
+    if (profile.slowStartMsec > 0 && elapsedMsec < profile.slowStartMsec)
+    {
+        budget = profile.bytesPerSecond * elapsedMsec * elapsedMsec / (2.0 * profile.slowStartMsec) / 1000.0;
+    }
+    else
+    {
+        budget = profile.bytesPerSecond * (elapsedMsec - profile.slowStartMsec / 2.0) / 1000.0;
+    }
+
+    return qint64(budget) - t_connection.bytesSentSinceClockStart;
+}
+
+QByteArray TestHttpServer::multipartBody(const QByteArray& t_content, const QVector<ByteRanges::TRange>& t_ranges, const QByteArray& t_boundary)
+{
+    QByteArray body;
+
+    for (const ByteRanges::TRange& range : t_ranges)
+    {
+        body += "\r\n--" + t_boundary + "\r\n";
+        body += "Content-Type: application/octet-stream\r\n";
+        body += "Content-Range: bytes " + QByteArray::number(range.first) + "-" + QByteArray::number(range.second)
+              + "/" + QByteArray::number(t_content.size()) + "\r\n\r\n";
+        body += t_content.mid(int(range.first), int(range.second - range.first + 1));
+    }
+
+    body += "\r\n--" + t_boundary + "--\r\n";
+
+    return body;
+}
@@ -0,0 +1,150 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#ifndef TESTHTTPSERVER_H
+#define TESTHTTPSERVER_H
+
+#include <QTcpServer>
+#include <QHash>
+#include <QMap>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include "src/byteranges.h"
+
+class QTcpSocket;
+
+/**
+ * @brief
+ * Loopback HTTP server which serves content with injected network faults.
+ *
+ * @details
+ * Speaks a single GET request per connection with optional "Range: bytes=start-" or
+ * "Range: bytes=start-end" header, just like content servers used by the launcher do.
+ * Several ranges are answered with a "multipart/byteranges" body, or with the first range only
+ * if the profile doesn't support multipart responses.
+ * Every path is served with its own Profile, which can limit the bandwidth (with a slow-start ramp),
+ * delay the response, stall the transfer, cut the connection or corrupt a byte.
+ *
+ * All offsets of a profile are offsets in the content, not in the response body, so a request
+ * resumed with a Range header past the fault isn't affected by it. Faults don't apply to multipart responses.
+ *
+ * The server works in the thread it was created in, which must be processing events while
+ * the content is downloaded (the downloaders wait in their own event loops).
+ */
+class TestHttpServer : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    struct Profile
+    {
+        Profile()
+            : bytesPerSecond(0)
+            , slowStartMsec(0)
+            , latencyMsec(0)
+            , stallAtByte(-1)
+            , stallMsec(0)
+            , truncateAtByte(-1)
+            , corruptAtByte(-1)
+            , supportsRanges(true)
+            , supportsMultipartRanges(true)
+            , statusCode(200)
+            , faultyRequestsCount(-1)
+        {
+        }
+
+        qint64  bytesPerSecond;         // 0 - unlimited
+        int     slowStartMsec;          // bandwidth ramps up linearly during this time
+        int     latencyMsec;            // delay before the response header is sent
+        qint64  stallAtByte;            // -1 - never stalls
+        int     stallMsec;
+        qint64  truncateAtByte;         // -1 - never truncated, connection is aborted at this byte
+        qint64  corruptAtByte;          // -1 - never corrupted, this byte is flipped
+        bool    supportsRanges;         // false - Range headers are ignored and whole content is sent with 200
+        bool    supportsMultipartRanges;// false - only the first of several ranges is sent
+        int     statusCode;             // status code of faulty requests, anything else than 200 sends no content
+        int     faultyRequestsCount;    // -1 - faults apply to every request, otherwise only to the first ones
+    };
+
+    TestHttpServer(QObject* t_parent = nullptr);
+
+    bool start();
+
+    QString url(const QString& t_path) const;
+
+    void setContent(const QString& t_path, const QByteArray& t_content, const Profile& t_profile = Profile());
+
+    int requestsCount(const QString& t_path) const;
+
+    QList<QByteArray> rangeHeaders(const QString& t_path) const;
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+    void onBytesWritten();
+    void onDisconnected();
+    void onPacingTimeout();
+
+private:
+    struct Resource
+    {
+        Resource()
+            : requestsCount(0)
+        {
+        }
+
+        QByteArray          content;
+        Profile             profile;
+        int                 requestsCount;
+        QList<QByteArray>   rangeHeaders;
+    };
+
+    struct Connection
+    {
+        Connection()
+            : isResponding(false)
+            , isSending(false)
+            , isFaulty(false)
+            , hasStalled(false)
+            , position(0)
+            , end(0)
+            , bytesSentSinceClockStart(0)
+        {
+        }
+
+        QByteArray      request;
+        QByteArray      header;
+        QByteArray      content;
+        Profile         profile;
+        bool            isResponding;
+        bool            isSending;
+        bool            isFaulty;
+        bool            hasStalled;
+        qint64          position;
+        qint64          end;
+        qint64          bytesSentSinceClockStart;
+        QElapsedTimer   clock;
+        QElapsedTimer   stallClock;
+    };
+
+    const static qint64 pieceSize;
+    const static qint64 maxBytesToWrite;
+    const static int    pacingIntervalMsec;
+
+    QMap<QString, Resource>         m_resources;
+    QHash<QTcpSocket*, Connection>  m_connections;
+    QTimer                          m_pacingTimer;
+
+    void handleRequest(QTcpSocket* t_socket, Connection& t_connection);
+    void startSending(QTcpSocket* t_socket);
+    void pump(QTcpSocket* t_socket, Connection& t_connection);
+    void respond(QTcpSocket* t_socket, int t_statusCode, const QByteArray& t_reason);
+
+    static qint64 allowedBytes(const Connection& t_connection);
+    static QByteArray multipartBody(const QByteArray& t_content, const QVector<ByteRanges::TRange>& t_ranges, const QByteArray& t_boundary);
+};
+
+#endif // TESTHTTPSERVER_H
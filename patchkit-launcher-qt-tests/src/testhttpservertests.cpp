@@ -0,0 +1,291 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "catch.h"
+
+#include <QtNetwork>
+#include <QTemporaryFile>
+
+#include "src/chunkeddownloader.h"
+#include "src/contentsummary.h"
+#include "src/mirrorcapabilities.h"
+
+#include "testhttpserver.h"
+
+static QByteArray generateContent(int t_size)
+{
+    QByteArray content(t_size, Qt::Uninitialized);
+
+    for (int i = 0; i < t_size; i++)
+    {
+        content[i] = char((i * 31 + i / 251) & 0xFF);
+    }
+
+    return content;
+}
+
+static ContentSummary summarize(const QByteArray& t_content, int t_chunkSize)
+{
+    QVector<THash> chunkHashes;
+
+    for (int offset = 0; offset < t_content.size(); offset += t_chunkSize)
+    {
+        chunkHashes.append(HashingStrategy::xxHash(t_content.mid(offset, t_chunkSize)));
+    }
+
+    return ContentSummary(t_chunkSize, 0, "none", "none", "xxHash", chunkHashes, {});
+}
+
+SCENARIO("Chunked downloader recovers from faults injected by the local server.", "[test_http_server]")
+{
+    std::shared_ptr<CancellationTokenSource> tokenSource(new CancellationTokenSource());
+    CancellationToken token(tokenSource);
+
+    const QByteArray content = generateContent(64 * 1024);
+    const ContentSummary summary = summarize(content, 4096);
+
+    // Ports of local servers are reused between test cases.
+    MirrorCapabilities::getInstance().clear();
+
+    TestHttpServer server;
+    REQUIRE(server.start());
+
+    QNetworkAccessManager nam;
+    ChunkedDownloader downloader(&nam, summary, &HashingStrategy::xxHashStream, token);
+
+    GIVEN("A server without faults.")
+    {
+        server.setContent("/content", content);
+
+        THEN("The content should be downloaded with a single request.")
+        {
+            REQUIRE(downloader.downloadFile(server.url("/content"), 5000) == content);
+            REQUIRE(server.requestsCount("/content") == 1);
+            REQUIRE(server.rangeHeaders("/content").isEmpty());
+        }
+    }
+
+    GIVEN("A server which cuts the first transfer in the middle of a chunk.")
+    {
+        TestHttpServer::Profile profile;
+        profile.truncateAtByte = 10 * 4096 + 100;
+        profile.faultyRequestsCount = 1;
+
+        // Limited bandwidth makes the reply start before the connection is cut.
+        profile.bytesPerSecond = 1024 * 1024;
+
+        server.setContent("/content", content, profile);
+
+        THEN("The download should be resumed with a Range request at the first byte which hasn't arrived.")
+        {
+            REQUIRE(downloader.downloadFile(server.url("/content"), 5000) == content);
+            REQUIRE(server.requestsCount("/content") == 2);
+            REQUIRE(server.rangeHeaders("/content") == QList<QByteArray>({"bytes=41060-"}));
+        }
+    }
+
+    GIVEN("A server which corrupts a byte of a chunk and cuts the first transfer in the middle of it.")
+    {
+        TestHttpServer::Profile profile;
+        profile.corruptAtByte = 10 * 4096 + 50;
+        profile.truncateAtByte = 10 * 4096 + 100;
+        profile.faultyRequestsCount = 1;
+        profile.bytesPerSecond = 1024 * 1024;
+
+        server.setContent("/content", content, profile);
+
+        THEN("The resumed chunk should be found invalid and downloaded again as a whole.")
+        {
+            REQUIRE(downloader.downloadFile(server.url("/content"), 5000) == content);
+            REQUIRE(server.requestsCount("/content") == 3);
+            REQUIRE(server.rangeHeaders("/content") == QList<QByteArray>({"bytes=41060-", "bytes=40960-45055"}));
+        }
+    }
+
+    GIVEN("A server which cuts the first transfer and a file as the download target.")
+    {
+        TestHttpServer::Profile profile;
+        profile.truncateAtByte = 7 * 4096 + 100;
+        profile.faultyRequestsCount = 1;
+        profile.bytesPerSecond = 1024 * 1024;
+
+        server.setContent("/content", content, profile);
+
+        THEN("The file should hold the whole content.")
+        {
+            QTemporaryFile file;
+            REQUIRE(file.open());
+
+            downloader.downloadFile(server.url("/content"), file, 5000);
+
+            REQUIRE(file.size() == content.size());
+            REQUIRE(file.seek(0));
+            REQUIRE(file.readAll() == content);
+            REQUIRE(server.rangeHeaders("/content") == QList<QByteArray>({"bytes=28772-"}));
+        }
+    }
+
+    GIVEN("A server which corrupts a byte of the first transfer.")
+    {
+        TestHttpServer::Profile profile;
+        profile.corruptAtByte = 5 * 4096 + 7;
+        profile.faultyRequestsCount = 1;
+
+        server.setContent("/content", content, profile);
+
+        THEN("The corrupted chunk should be downloaded again.")
+        {
+            REQUIRE(downloader.downloadFile(server.url("/content"), 5000) == content);
+            REQUIRE(server.requestsCount("/content") == 2);
+            REQUIRE(server.rangeHeaders("/content") == QList<QByteArray>({"bytes=20480-24575"}));
+        }
+    }
+
+    GIVEN("A server which corrupts a byte and then cuts the first transfer.")
+    {
+        TestHttpServer::Profile profile;
+        profile.corruptAtByte = 2 * 4096 + 7;
+        profile.truncateAtByte = 10 * 4096 + 100;
+        profile.faultyRequestsCount = 1;
+        profile.bytesPerSecond = 1024 * 1024;
+
+        WHEN("The server supports multipart responses.")
+        {
+            server.setContent("/content", content, profile);
+
+            THEN("Both missing parts should be downloaded with a single request.")
+            {
+                REQUIRE(downloader.downloadFile(server.url("/content"), 5000) == content);
+                REQUIRE(server.requestsCount("/content") == 2);
+                REQUIRE(server.rangeHeaders("/content") == QList<QByteArray>({"bytes=8192-12287,41060-"}));
+            }
+        }
+
+        WHEN("The server sends only the first of requested ranges.")
+        {
+            profile.supportsMultipartRanges = false;
+            server.setContent("/content", content, profile);
+
+            THEN("The remaining part should be requested again.")
+            {
+                REQUIRE(downloader.downloadFile(server.url("/content"), 5000) == content);
+                REQUIRE(server.requestsCount("/content") == 3);
+                REQUIRE(server.rangeHeaders("/content").last() == "bytes=41060-");
+            }
+        }
+    }
+
+    GIVEN("A server which ignores Range requests and corrupts a byte of the first two transfers.")
+    {
+        TestHttpServer::Profile profile;
+        profile.supportsRanges = false;
+        profile.corruptAtByte = 5 * 4096 + 7;
+        profile.faultyRequestsCount = 2;
+
+        server.setContent("/content", content, profile);
+
+        THEN("After the first ignored Range request the whole file should be requested without one.")
+        {
+            REQUIRE(downloader.downloadFile(server.url("/content"), 5000) == content);
+            REQUIRE(server.requestsCount("/content") == 3);
+            REQUIRE(server.rangeHeaders("/content").size() == 1);
+            REQUIRE(MirrorCapabilities::getInstance().getRangeSupport(server.url("/content")) == MirrorCapabilities::Unsupported);
+        }
+    }
+
+    GIVEN("A mirror which stalls near the end of the transfer and a mirror without faults.")
+    {
+        TestHttpServer::Profile profile;
+        profile.stallAtByte = 14 * 4096 + 10;
+        profile.stallMsec = 3000;
+
+        server.setContent("/slow", content, profile);
+        server.setContent("/fast", content);
+
+        downloader.setMirrorUrls({server.url("/slow"), server.url("/fast")});
+
+        THEN("The outstanding chunks should be delivered by the other mirror without waiting for the stall.")
+        {
+            QElapsedTimer timer;
+            timer.start();
+
+            REQUIRE(downloader.downloadFile(server.url("/slow"), 5000) == content);
+            REQUIRE(timer.elapsed() < profile.stallMsec);
+            REQUIRE(server.requestsCount("/slow") == 1);
+            REQUIRE(server.requestsCount("/fast") >= 1);
+            REQUIRE(server.requestsCount("/fast") <= 4);
+        }
+    }
+
+    GIVEN("A server with content of a different size than the content summary describes.")
+    {
+        server.setContent("/content", content + content);
+
+        THEN("The mirror should be rejected.")
+        {
+            REQUIRE_THROWS(downloader.downloadFile(server.url("/content"), 5000));
+        }
+    }
+}
+
+SCENARIO("Local server shapes the transfer.", "[test_http_server]")
+{
+    std::shared_ptr<CancellationTokenSource> tokenSource(new CancellationTokenSource());
+    CancellationToken token(tokenSource);
+
+    const QByteArray content = generateContent(64 * 1024);
+
+    TestHttpServer server;
+    REQUIRE(server.start());
+
+    QNetworkAccessManager nam;
+    Downloader downloader(&nam, token);
+
+    QElapsedTimer timer;
+
+    GIVEN("A bandwidth limited server.")
+    {
+        TestHttpServer::Profile profile;
+        profile.bytesPerSecond = 256 * 1024;
+
+        server.setContent("/content", content, profile);
+
+        THEN("The download should take as long as the bandwidth allows.")
+        {
+            timer.start();
+            REQUIRE(downloader.downloadFile(server.url("/content"), 5000) == content);
+            REQUIRE(timer.elapsed() >= 200);
+        }
+    }
+
+    GIVEN("A server which stalls the transfer.")
+    {
+        TestHttpServer::Profile profile;
+        profile.stallAtByte = 1000;
+        profile.stallMsec = 300;
+
+        server.setContent("/content", content, profile);
+
+        THEN("The download should wait for the stalled data.")
+        {
+            timer.start();
+            REQUIRE(downloader.downloadFile(server.url("/content"), 5000) == content);
+            REQUIRE(timer.elapsed() >= 300);
+        }
+    }
+
+    GIVEN("A server which responds with an error status code.")
+    {
+        TestHttpServer::Profile profile;
+        profile.statusCode = 503;
+
+        server.setContent("/content", content, profile);
+
+        THEN("The download should fail.")
+        {
+            REQUIRE_THROWS(downloader.downloadFile(server.url("/content"), 5000));
+        }
+    }
+}
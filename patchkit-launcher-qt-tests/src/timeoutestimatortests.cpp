@@ -0,0 +1,69 @@
+/*
+* Copyright (C) Upsoft 2016
+* License: https://github.com/patchkit-net/patchkit-launcher-qt/blob/master/LICENSE
+*/
+
+#include "catch.h"
+
+#include "src/timeoutestimator.h"
+#include "src/config.h"
+
+TEST_CASE("Timeout estimator without samples uses the configured timeouts.", "[timeout_estimator]")
+{
+    TimeoutEstimator estimator("");
+
+    REQUIRE(estimator.getTimeout("http://example.com/file", false) == Config::minConnectionTimeoutMsec);
+    REQUIRE(estimator.getTimeout("http://example.com/file", true) == Config::maxConnectionTimeoutMsec);
+}
+
+TEST_CASE("Timeout estimator adapts to the measured round trip time.", "[timeout_estimator]")
+{
+    TimeoutEstimator estimator("");
+
+    SECTION("Fast host fails over quickly.")
+    {
+        for (int i = 0; i < 20; i++)
+        {
+            estimator.addSample("http://fast.example.com/a", 40);
+        }
+
+        REQUIRE(estimator.getTimeout("http://fast.example.com/b", false) == Config::adaptiveMinConnectionTimeoutMsec);
+        REQUIRE(estimator.getTimeout("http://slow.example.com/b", false) == Config::minConnectionTimeoutMsec);
+    }
+
+    SECTION("Slow host is given more time than the measured round trip time.")
+    {
+        for (int i = 0; i < 20; i++)
+        {
+            estimator.addSample("http://slow.example.com/a", 2000 + (i % 2) * 1000);
+        }
+
+        int timeout = estimator.getTimeout("http://slow.example.com/a", false);
+
+        CHECK(timeout > 3000);
+        REQUIRE(timeout <= Config::maxConnectionTimeoutMsec);
+        REQUIRE(estimator.getTimeout("http://slow.example.com/a", true) > timeout);
+    }
+
+    SECTION("Timeouts back off until a new sample arrives.")
+    {
+        estimator.addSample("http://example.com/a", 1000);
+
+        int timeout = estimator.getTimeout("http://example.com/a", false);
+
+        estimator.reportTimeout("http://example.com/a");
+
+        REQUIRE(estimator.getTimeout("http://example.com/a", false) == qMin(2 * timeout, Config::maxConnectionTimeoutMsec));
+
+        estimator.addSample("http://example.com/a", 1000);
+
+        REQUIRE(estimator.getTimeout("http://example.com/a", false) < 2 * timeout);
+    }
+
+    SECTION("Hosts are distinguished by port.")
+    {
+        estimator.addSample("http://example.com:8080/a", 40);
+
+        REQUIRE(estimator.getTimeout("http://example.com/a", false) == Config::minConnectionTimeoutMsec);
+    }
+}